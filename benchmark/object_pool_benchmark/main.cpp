@@ -0,0 +1,567 @@
+// 对象池基准测试：同样的负载分别跑在各种池、malloc/new和std::pmr上，结果按CSV输出，便于比较和追踪回退。
+// 多线程时不是线程安全的分配器(CObjectPool、pmr)由一把锁保护
+#include <utility/object_pool.h>
+#include <utility/magazine_object_pool.h>
+#include <utility/thread_heap_object_pool.h>
+#include <utility/percpu_object_pool.h>
+#include <memory_resource>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace utility;
+
+constexpr uint32_t BenchObjectSize = 64;         // 固定大小负载的对象大小
+constexpr uint32_t BenchMaxObjectSize = 1024;    // 变长负载的最大对象大小
+constexpr uint32_t BenchRoundObjects = 1024;     // 每轮申请的对象数量
+constexpr uint32_t BenchHandoffQueueSize = 1024; // 生产者/消费者之间的队列长度
+constexpr uint32_t BenchPhaseObjects = 65536;    // 增长阶段每个线程申请的对象数量
+
+static const std::vector<uint32_t> s_vecFixedSizes = {BenchObjectSize};
+static const std::vector<uint32_t> s_vecMixedSizes = {16, 24, 32, 48, 64, 96, 128, 256, 512, 1024};
+
+class IBenchAllocator
+{
+public:
+    virtual ~IBenchAllocator() = default;
+    virtual const char *GetName() = 0;
+    // bShared为true时会有多个线程同时调用
+    virtual int32_t Prepare(const std::vector<uint32_t> &vecSizes, bool bShared) = 0;
+    virtual void *Get(uint32_t uSize) = 0;
+    virtual void Release(void *ptr, uint32_t uSize) = 0;
+};
+
+class CMallocAllocator : public IBenchAllocator
+{
+public:
+    const char *GetName() override { return "malloc"; }
+    int32_t Prepare(const std::vector<uint32_t> &vecSizes, bool bShared) override { return 0; }
+    void *Get(uint32_t uSize) override { return malloc(uSize); }
+    void Release(void *ptr, uint32_t uSize) override { free(ptr); }
+};
+
+class CNewAllocator : public IBenchAllocator
+{
+public:
+    const char *GetName() override { return "new"; }
+    int32_t Prepare(const std::vector<uint32_t> &vecSizes, bool bShared) override { return 0; }
+    void *Get(uint32_t uSize) override { return ::operator new(uSize); }
+    void Release(void *ptr, uint32_t uSize) override { ::operator delete(ptr); }
+};
+
+class CPmrAllocator : public IBenchAllocator
+{
+public:
+    const char *GetName() override { return "pmr_pool"; }
+
+    int32_t Prepare(const std::vector<uint32_t> &vecSizes, bool bShared) override
+    {
+        m_bShared = bShared;
+        return 0;
+    }
+
+    void *Get(uint32_t uSize) override
+    {
+        if (m_bShared)
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            return m_resource.allocate(uSize, alignof(std::max_align_t));
+        }
+        return m_resource.allocate(uSize, alignof(std::max_align_t));
+    }
+
+    void Release(void *ptr, uint32_t uSize) override
+    {
+        if (m_bShared)
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            m_resource.deallocate(ptr, uSize, alignof(std::max_align_t));
+            return;
+        }
+        m_resource.deallocate(ptr, uSize, alignof(std::max_align_t));
+    }
+
+private:
+    bool m_bShared{false};
+    std::mutex m_lock;
+    std::pmr::unsynchronized_pool_resource m_resource;
+};
+
+// 每种对象大小一个池，按大小/8直接索引；bLockable为true时多线程下加锁
+template <typename Pool>
+class CPoolAllocator : public IBenchAllocator
+{
+public:
+    CPoolAllocator(const char *lpName, bool bLockable) : m_lpName(lpName), m_bLockable(bLockable) {}
+
+    ~CPoolAllocator()
+    {
+        for (auto &pool : m_vecPools)
+        {
+            pool->UnInit();
+        }
+    }
+
+    const char *GetName() override { return m_lpName; }
+
+    int32_t Prepare(const std::vector<uint32_t> &vecSizes, bool bShared) override
+    {
+        m_bLocked = m_bLockable && bShared;
+        for (auto uSize : vecSizes)
+        {
+            m_vecPools.emplace_back(new Pool());
+            if (uSize > BenchMaxObjectSize || m_vecPools.back()->Init(uSize) != 0)
+            {
+                return 1;
+            }
+            m_arrPools[uSize / 8] = m_vecPools.back().get();
+        }
+        return 0;
+    }
+
+    void *Get(uint32_t uSize) override
+    {
+        auto lpPool = m_arrPools[uSize / 8];
+        if (m_bLocked)
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            return lpPool->Get();
+        }
+        return lpPool->Get();
+    }
+
+    void Release(void *ptr, uint32_t uSize) override
+    {
+        auto lpPool = m_arrPools[uSize / 8];
+        if (m_bLocked)
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            lpPool->Release(ptr);
+            return;
+        }
+        lpPool->Release(ptr);
+    }
+
+private:
+    const char *m_lpName;
+    bool m_bLockable;
+    bool m_bLocked{false};
+    std::mutex m_lock;
+    std::vector<std::unique_ptr<Pool>> m_vecPools;
+    Pool *m_arrPools[BenchMaxObjectSize / 8 + 1]{nullptr};
+};
+
+static IBenchAllocator *CreateAllocator(const std::string &strName)
+{
+    if (strName == "object")
+    {
+        return new CPoolAllocator<CObjectPool>("object", true);
+    }
+    if (strName == "magazine")
+    {
+        return new CPoolAllocator<CMagazineObjectPool>("magazine", false);
+    }
+    if (strName == "thread_heap")
+    {
+        return new CPoolAllocator<CThreadHeapObjectPool>("thread_heap", false);
+    }
+    if (strName == "percpu")
+    {
+        return new CPoolAllocator<CPerCpuObjectPool>("percpu", false);
+    }
+    if (strName == "malloc")
+    {
+        return new CMallocAllocator();
+    }
+    if (strName == "new")
+    {
+        return new CNewAllocator();
+    }
+    if (strName == "pmr_pool")
+    {
+        return new CPmrAllocator();
+    }
+    return nullptr;
+}
+
+// 所有线程到齐后一起出发，可以重复使用
+class CSpinBarrier
+{
+public:
+    explicit CSpinBarrier(uint32_t uCount) : m_uCount(uCount) {}
+
+    void Wait()
+    {
+        auto uGeneration = m_uGeneration.load(std::memory_order_acquire);
+        if (m_uArrived.fetch_add(1, std::memory_order_acq_rel) + 1 == m_uCount)
+        {
+            m_uArrived.store(0, std::memory_order_relaxed);
+            m_uGeneration.fetch_add(1, std::memory_order_release);
+            return;
+        }
+        while (m_uGeneration.load(std::memory_order_acquire) == uGeneration)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    uint32_t m_uCount;
+    std::atomic<uint32_t> m_uArrived{0};
+    std::atomic<uint32_t> m_uGeneration{0};
+};
+
+// 单生产者单消费者的环形队列
+class CHandoffQueue
+{
+public:
+    void Push(void *ptr)
+    {
+        auto uTail = m_uTail.load(std::memory_order_relaxed);
+        while (uTail - m_uHead.load(std::memory_order_acquire) == BenchHandoffQueueSize)
+        {
+            std::this_thread::yield();
+        }
+        m_lppObjs[uTail % BenchHandoffQueueSize] = ptr;
+        m_uTail.store(uTail + 1, std::memory_order_release);
+    }
+
+    void *Pop()
+    {
+        auto uHead = m_uHead.load(std::memory_order_relaxed);
+        while (m_uTail.load(std::memory_order_acquire) == uHead)
+        {
+            std::this_thread::yield();
+        }
+        auto ptr = m_lppObjs[uHead % BenchHandoffQueueSize];
+        m_uHead.store(uHead + 1, std::memory_order_release);
+        return ptr;
+    }
+
+private:
+    alignas(PoolCacheLineSize) std::atomic<uint64_t> m_uHead{0};
+    alignas(PoolCacheLineSize) std::atomic<uint64_t> m_uTail{0};
+    void *m_lppObjs[BenchHandoffQueueSize];
+};
+
+static uint64_t XorShift(uint64_t &uState)
+{
+    uState ^= uState << 13;
+    uState ^= uState >> 7;
+    uState ^= uState << 17;
+    return uState;
+}
+
+static std::vector<uint32_t> Shuffle(uint32_t uCount, uint64_t uSeed)
+{
+    std::vector<uint32_t> vecIndex(uCount);
+    for (uint32_t i = 0; i < uCount; i++)
+    {
+        vecIndex[i] = i;
+    }
+    for (uint32_t i = uCount - 1; i > 0; i--)
+    {
+        std::swap(vecIndex[i], vecIndex[XorShift(uSeed) % (i + 1)]);
+    }
+    return vecIndex;
+}
+
+// 一次运行中所有线程共享的状态，每个阶段的耗时取所有线程最早开始到最晚结束
+struct BenchContext
+{
+    IBenchAllocator *lpAlloc_;
+    uint32_t uThreads_;
+    uint32_t uRounds_;
+    CSpinBarrier barrier_;
+    std::vector<CHandoffQueue> vecQueues_;
+    std::vector<std::vector<timespec>> vecBegin_; // [阶段][线程]
+    std::vector<std::vector<timespec>> vecEnd_;
+    std::vector<std::vector<uint64_t>> vecOps_;
+
+    BenchContext(IBenchAllocator *lpAlloc, uint32_t uThreads, uint32_t uRounds, uint32_t uStages)
+        : lpAlloc_(lpAlloc), uThreads_(uThreads), uRounds_(uRounds), barrier_(uThreads), vecQueues_(uThreads / 2),
+          vecBegin_(uStages, std::vector<timespec>(uThreads)), vecEnd_(uStages, std::vector<timespec>(uThreads)),
+          vecOps_(uStages, std::vector<uint64_t>(uThreads, 0))
+    {
+    }
+
+    void BeginStage(uint32_t uStage, uint32_t uThread)
+    {
+        barrier_.Wait();
+        CPerfProfiler::GetTime(vecBegin_[uStage][uThread]);
+    }
+
+    void EndStage(uint32_t uStage, uint32_t uThread, uint64_t uOps)
+    {
+        CPerfProfiler::GetTime(vecEnd_[uStage][uThread]);
+        vecOps_[uStage][uThread] = uOps;
+    }
+};
+
+// 按给定顺序释放一轮申请的对象：LIFO、FIFO、随机
+static void RunOrdered(BenchContext &ctx, uint32_t uThread, const std::vector<uint32_t> &vecOrder,
+                       const std::vector<uint32_t> &vecSizes)
+{
+    std::vector<void *> vecObjs(BenchRoundObjects);
+    std::vector<uint32_t> vecObjSizes(BenchRoundObjects);
+    for (uint32_t i = 0; i < BenchRoundObjects; i++)
+    {
+        vecObjSizes[i] = vecSizes[(i * 7 + uThread) % vecSizes.size()];
+    }
+
+    ctx.BeginStage(0, uThread);
+    for (uint32_t round = 0; round < ctx.uRounds_; round++)
+    {
+        for (uint32_t i = 0; i < BenchRoundObjects; i++)
+        {
+            vecObjs[i] = ctx.lpAlloc_->Get(vecObjSizes[i]);
+            *(volatile uint8_t *)vecObjs[i] = 0;
+        }
+        for (auto uIndex : vecOrder)
+        {
+            ctx.lpAlloc_->Release(vecObjs[uIndex], vecObjSizes[uIndex]);
+        }
+    }
+    ctx.EndStage(0, uThread, 2ull * ctx.uRounds_ * BenchRoundObjects);
+}
+
+static void RunLifo(BenchContext &ctx, uint32_t uThread)
+{
+    std::vector<uint32_t> vecOrder(BenchRoundObjects);
+    for (uint32_t i = 0; i < BenchRoundObjects; i++)
+    {
+        vecOrder[i] = BenchRoundObjects - 1 - i;
+    }
+    RunOrdered(ctx, uThread, vecOrder, s_vecFixedSizes);
+}
+
+static void RunFifo(BenchContext &ctx, uint32_t uThread)
+{
+    std::vector<uint32_t> vecOrder(BenchRoundObjects);
+    for (uint32_t i = 0; i < BenchRoundObjects; i++)
+    {
+        vecOrder[i] = i;
+    }
+    RunOrdered(ctx, uThread, vecOrder, s_vecFixedSizes);
+}
+
+static void RunRandom(BenchContext &ctx, uint32_t uThread)
+{
+    RunOrdered(ctx, uThread, Shuffle(BenchRoundObjects, uThread + 1), s_vecFixedSizes);
+}
+
+static void RunMixedSize(BenchContext &ctx, uint32_t uThread)
+{
+    RunOrdered(ctx, uThread, Shuffle(BenchRoundObjects, uThread + 1), s_vecMixedSizes);
+}
+
+// 线程两两配对，偶数线程申请，奇数线程释放
+static void RunHandoff(BenchContext &ctx, uint32_t uThread)
+{
+    auto &queue = ctx.vecQueues_[uThread / 2];
+    uint64_t uCount = (uint64_t)ctx.uRounds_ * BenchRoundObjects;
+    ctx.BeginStage(0, uThread);
+    if (uThread % 2 == 0)
+    {
+        for (uint64_t i = 0; i < uCount; i++)
+        {
+            auto ptr = ctx.lpAlloc_->Get(BenchObjectSize);
+            *(volatile uint8_t *)ptr = 0;
+            queue.Push(ptr);
+        }
+    }
+    else
+    {
+        for (uint64_t i = 0; i < uCount; i++)
+        {
+            ctx.lpAlloc_->Release(queue.Pop(), BenchObjectSize);
+        }
+    }
+    ctx.EndStage(0, uThread, uCount);
+}
+
+// 增长、稳定、收缩三个阶段：先申请到峰值，再随机替换，最后随机全部释放
+static void RunPhases(BenchContext &ctx, uint32_t uThread)
+{
+    std::vector<void *> vecObjs(BenchPhaseObjects);
+    std::vector<uint32_t> vecObjSizes(BenchPhaseObjects);
+    uint64_t uSeed = uThread + 1;
+
+    ctx.BeginStage(0, uThread);
+    for (uint32_t i = 0; i < BenchPhaseObjects; i++)
+    {
+        vecObjSizes[i] = s_vecMixedSizes[XorShift(uSeed) % s_vecMixedSizes.size()];
+        vecObjs[i] = ctx.lpAlloc_->Get(vecObjSizes[i]);
+        *(volatile uint8_t *)vecObjs[i] = 0;
+    }
+    ctx.EndStage(0, uThread, BenchPhaseObjects);
+
+    uint64_t uSteady = (uint64_t)ctx.uRounds_ * BenchRoundObjects / 2;
+    ctx.BeginStage(1, uThread);
+    for (uint64_t i = 0; i < uSteady; i++)
+    {
+        auto uIndex = XorShift(uSeed) % BenchPhaseObjects;
+        ctx.lpAlloc_->Release(vecObjs[uIndex], vecObjSizes[uIndex]);
+        vecObjSizes[uIndex] = s_vecMixedSizes[uSeed % s_vecMixedSizes.size()];
+        vecObjs[uIndex] = ctx.lpAlloc_->Get(vecObjSizes[uIndex]);
+        *(volatile uint8_t *)vecObjs[uIndex] = 0;
+    }
+    ctx.EndStage(1, uThread, uSteady * 2);
+
+    auto vecOrder = Shuffle(BenchPhaseObjects, uSeed);
+    ctx.BeginStage(2, uThread);
+    for (auto uIndex : vecOrder)
+    {
+        ctx.lpAlloc_->Release(vecObjs[uIndex], vecObjSizes[uIndex]);
+    }
+    ctx.EndStage(2, uThread, BenchPhaseObjects);
+}
+
+struct BenchWorkload
+{
+    const char *lpName_;
+    std::vector<const char *> vecStages_; // 每个阶段单独输出一行
+    const std::vector<uint32_t> *lpSizes_;
+    bool bPaired_; // 需要偶数个线程
+    void (*funcRun_)(BenchContext &, uint32_t);
+};
+
+static const std::vector<BenchWorkload> s_vecWorkloads = {
+    {"lifo", {""}, &s_vecFixedSizes, false, RunLifo},
+    {"fifo", {""}, &s_vecFixedSizes, false, RunFifo},
+    {"random", {""}, &s_vecFixedSizes, false, RunRandom},
+    {"mixed_size", {""}, &s_vecMixedSizes, false, RunMixedSize},
+    {"handoff", {""}, &s_vecFixedSizes, true, RunHandoff},
+    {"phase", {"growth", "steady", "shrink"}, &s_vecMixedSizes, false, RunPhases},
+};
+
+static int32_t RunWorkload(const BenchWorkload &workload, const std::string &strAlloc, uint32_t uThreads,
+                           uint32_t uRounds)
+{
+    std::unique_ptr<IBenchAllocator> alloc(CreateAllocator(strAlloc));
+    if (alloc == nullptr || alloc->Prepare(*workload.lpSizes_, uThreads > 1) != 0)
+    {
+        fprintf(stderr, "allocator %s prepare fail\n", strAlloc.c_str());
+        return 1;
+    }
+
+    BenchContext ctx(alloc.get(), uThreads, uRounds, (uint32_t)workload.vecStages_.size());
+    std::vector<std::thread> vecThreads;
+    for (uint32_t i = 0; i < uThreads; i++)
+    {
+        vecThreads.emplace_back(workload.funcRun_, std::ref(ctx), i);
+    }
+    for (auto &th : vecThreads)
+    {
+        th.join();
+    }
+
+    for (uint32_t uStage = 0; uStage < workload.vecStages_.size(); uStage++)
+    {
+        auto uBegin = CPerfProfiler::GetTimeNano(ctx.vecBegin_[uStage][0]);
+        auto uEnd = CPerfProfiler::GetTimeNano(ctx.vecEnd_[uStage][0]);
+        uint64_t uOps = 0;
+        for (uint32_t i = 0; i < uThreads; i++)
+        {
+            uBegin = std::min(uBegin, CPerfProfiler::GetTimeNano(ctx.vecBegin_[uStage][i]));
+            uEnd = std::max(uEnd, CPerfProfiler::GetTimeNano(ctx.vecEnd_[uStage][i]));
+            uOps += ctx.vecOps_[uStage][i];
+        }
+        auto lpStage = workload.vecStages_[uStage];
+        printf("%s%s%s,%s,%u,%lu,%lu,%.2f,%.2f\n", workload.lpName_, *lpStage != '\0' ? "_" : "", lpStage,
+               alloc->GetName(), uThreads, uOps, uEnd - uBegin, (double)(uEnd - uBegin) / uOps,
+               uOps * 1e3 / (uEnd - uBegin));
+    }
+    fflush(stdout);
+    return 0;
+}
+
+static std::vector<std::string> Split(const char *lpList)
+{
+    std::vector<std::string> vecItems;
+    std::string strItem;
+    for (auto lpChar = lpList; ; lpChar++)
+    {
+        if (*lpChar == ',' || *lpChar == '\0')
+        {
+            if (!strItem.empty())
+            {
+                vecItems.push_back(strItem);
+            }
+            strItem.clear();
+            if (*lpChar == '\0')
+            {
+                break;
+            }
+            continue;
+        }
+        strItem += *lpChar;
+    }
+    return vecItems;
+}
+
+int main(int argc, const char *argv[])
+{
+    uint32_t uMaxThreads = std::max(2u, std::thread::hardware_concurrency());
+    uint32_t uRounds = 1000;
+    std::vector<std::string> vecAllocs = {"object", "magazine", "thread_heap", "percpu", "malloc", "new", "pmr_pool"};
+    std::vector<std::string> vecWorkloads;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            uMaxThreads = std::max(1, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+        {
+            uRounds = std::max(1, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc)
+        {
+            vecAllocs = Split(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+        {
+            vecWorkloads = Split(argv[++i]);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-t max_threads] [-r rounds] [-a alloc,...] [-w workload,...]\n", argv[0]);
+            fprintf(stderr, "  alloc     object magazine thread_heap percpu malloc new pmr_pool\n");
+            fprintf(stderr, "  workload  lifo fifo random mixed_size handoff phase\n");
+            return 1;
+        }
+    }
+
+    // 线程数按1、2、4...增长，最后一档是uMaxThreads
+    std::vector<uint32_t> vecThreads;
+    for (uint32_t uThreads = 1; uThreads < uMaxThreads; uThreads *= 2)
+    {
+        vecThreads.push_back(uThreads);
+    }
+    vecThreads.push_back(uMaxThreads);
+
+    printf("workload,allocator,threads,ops,total_ns,ns_per_op,mops\n");
+    int32_t iRet = 0;
+    for (auto &workload : s_vecWorkloads)
+    {
+        if (!vecWorkloads.empty() &&
+            std::find(vecWorkloads.begin(), vecWorkloads.end(), workload.lpName_) == vecWorkloads.end())
+        {
+            continue;
+        }
+        for (auto uThreads : vecThreads)
+        {
+            if (workload.bPaired_ && uThreads % 2 != 0)
+            {
+                continue;
+            }
+            for (auto &strAlloc : vecAllocs)
+            {
+                iRet |= RunWorkload(workload, strAlloc, uThreads, uRounds);
+            }
+        }
+    }
+    return iRet;
+}
@@ -0,0 +1,7 @@
+#!/bin/bash
+
+target=object_pool_benchmark.out
+
+rm $target
+g++ -O2 -DNDEBUG main.cpp -I ../../src -o $target -lpthread -std=c++17
+./$target "$@"
@@ -0,0 +1,188 @@
+#ifndef __BLOCK_ALLOCATOR_H
+#define __BLOCK_ALLOCATOR_H
+
+#include <include/common.h>
+
+#ifdef OS_LINUX
+#include <sys/mman.h>
+#endif
+
+namespace utility
+{
+
+    // 对象池申请块内存的策略，同一个块的Alloc和Free使用相同的uSize
+    class IBlockAllocator
+    {
+    public:
+        virtual ~IBlockAllocator() = default;
+
+        // bPrefault为true时返回的内存要已经完成缺页，避免第一次Get时触发缺页
+        virtual void *Alloc(size_t uSize, bool bPrefault) = 0;
+        virtual void Free(void *ptr, size_t uSize) = 0;
+
+        // 块不小于这个大小时分配更有效(如能用上大页)，0表示没有要求
+        virtual size_t GetPreferredBlockSize() { return 0; }
+    };
+
+    class CMallocBlockAllocator : public IBlockAllocator
+    {
+    public:
+        static CMallocBlockAllocator *GetInstance()
+        {
+            static CMallocBlockAllocator s_allocator;
+            return &s_allocator;
+        }
+
+        void *Alloc(size_t uSize, bool bPrefault) override
+        {
+            auto ptr = malloc(uSize);
+            if (likely(ptr != nullptr) && bPrefault)
+            {
+                WarnUp(ptr, uSize);
+            }
+            return ptr;
+        }
+
+        void Free(void *ptr, size_t) override { free(ptr); }
+
+    private:
+        // 逐页写一次，提前触发缺页
+        static void WarnUp(void *ptr, size_t uSize)
+        {
+            uint32_t uPageSize = 0;
+#ifdef OS_WIN
+            SYSTEM_INFO si;
+            GetSystemInfo(&si);
+            uPageSize = (uint32_t)si.dwPageSize;
+#else
+            uPageSize = (uint32_t)sysconf(_SC_PAGESIZE);
+#endif
+            auto addr = (uint8_t *)ptr;
+            for (size_t offset = 0; offset < uSize; offset += uPageSize)
+            {
+                addr[offset] = 0x00;
+            }
+            addr[uSize - 1] = 0x00;
+        }
+    };
+
+#ifdef OS_LINUX
+    constexpr size_t HugePageSize = 2 * 1024 * 1024;
+
+    // mmap块分配：优先MAP_HUGETLB，预留的大页不够时退回普通映射 + MADV_HUGEPAGE(透明大页)，
+    // 预热用MAP_POPULATE由内核一次完成，不再逐页写。
+    // 只有不小于HugePageSize的块才用大页；CObjectPool会把最大的块提高到一个大页，
+    // 但每块最多PoolMaxBlockObjects个对象，槽位小于512字节时凑不满，仍然是普通页
+    class CMmapBlockAllocator : public IBlockAllocator
+    {
+    public:
+        enum : uint32_t
+        {
+            MmapHugeTlb = 0x01,         // 尝试使用预留大页
+            MmapTransparentHuge = 0x02, // 退回普通页时建议内核使用透明大页
+            MmapPopulate = 0x04,        // 需要预热时使用MAP_POPULATE
+        };
+
+        explicit CMmapBlockAllocator(uint32_t uFlags = MmapHugeTlb | MmapTransparentHuge | MmapPopulate)
+            : m_uFlags(uFlags)
+        {
+        }
+
+        void *Alloc(size_t uSize, bool bPrefault) override
+        {
+            // 不足一个大页的块按普通页映射，否则浪费太多
+            bool bHuge = IsHugeSize(uSize);
+            size_t uMapSize = RoundUp(uSize, bHuge ? HugePageSize : GetPageSize());
+            int iPopulate = (bPrefault && (m_uFlags & MmapPopulate)) ? MAP_POPULATE : 0;
+
+            if (bHuge && (m_uFlags & MmapHugeTlb))
+            {
+                auto ptr = mmap(nullptr, uMapSize, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | iPopulate, -1, 0);
+                if (ptr != MAP_FAILED)
+                {
+                    return ptr;
+                }
+            }
+
+            void *ptr = nullptr;
+            if (bHuge && (m_uFlags & MmapTransparentHuge))
+            {
+                // 透明大页要求2M对齐，多映射一个大页再裁掉首尾
+                auto lpRaw = (uint8_t *)mmap(nullptr, uMapSize + HugePageSize, PROT_READ | PROT_WRITE,
+                                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (lpRaw == MAP_FAILED)
+                {
+                    return nullptr;
+                }
+                auto lpAligned = (uint8_t *)RoundUp((size_t)lpRaw, HugePageSize);
+                if (lpAligned != lpRaw)
+                {
+                    munmap(lpRaw, lpAligned - lpRaw);
+                }
+                munmap(lpAligned + uMapSize, HugePageSize - (lpAligned - lpRaw));
+                madvise(lpAligned, uMapSize, MADV_HUGEPAGE);
+                ptr = lpAligned;
+                // MAP_POPULATE发生在madvise之前，透明大页只能在madvise之后手工预热
+                if (iPopulate != 0)
+                {
+                    Touch(ptr, uMapSize, GetPageSize());
+                }
+            }
+            else
+            {
+                ptr = mmap(nullptr, uMapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | iPopulate, -1, 0);
+                if (ptr == MAP_FAILED)
+                {
+                    return nullptr;
+                }
+            }
+
+            if (bPrefault && iPopulate == 0)
+            {
+                Touch(ptr, uMapSize, GetPageSize());
+            }
+            return ptr;
+        }
+
+        void Free(void *ptr, size_t uSize) override
+        {
+            munmap(ptr, RoundUp(uSize, IsHugeSize(uSize) ? HugePageSize : GetPageSize()));
+        }
+
+        size_t GetPreferredBlockSize() override
+        {
+            return (m_uFlags & (MmapHugeTlb | MmapTransparentHuge)) != 0 ? HugePageSize : 0;
+        }
+
+    private:
+        bool IsHugeSize(size_t uSize)
+        {
+            return (m_uFlags & (MmapHugeTlb | MmapTransparentHuge)) != 0 && uSize >= HugePageSize;
+        }
+
+        static size_t GetPageSize()
+        {
+            static size_t s_uPageSize = (size_t)sysconf(_SC_PAGESIZE);
+            return s_uPageSize;
+        }
+
+        static size_t RoundUp(size_t uSize, size_t uAlign) { return (uSize + uAlign - 1) & ~(uAlign - 1); }
+
+        static void Touch(void *ptr, size_t uSize, size_t uStep)
+        {
+            auto addr = (volatile uint8_t *)ptr;
+            for (size_t offset = 0; offset < uSize; offset += uStep)
+            {
+                addr[offset] = 0x00;
+            }
+        }
+
+    private:
+        uint32_t m_uFlags{0};
+    };
+#endif
+
+} // end namespace utility
+
+#endif //__BLOCK_ALLOCATOR_H
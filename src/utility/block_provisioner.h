@@ -0,0 +1,171 @@
+#ifndef __BLOCK_PROVISIONER_H
+#define __BLOCK_PROVISIONER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility/block_allocator.h>
+
+namespace utility
+{
+
+    constexpr uint32_t MaxSpareBlocks = 64;
+
+    // 后台预备块：工作线程提前申请、预热并构造好备用块，使用方一次原子交换取走，
+    // 备用块数量降到低水位时通知工作线程补满。只支持一个使用方线程取块
+    class CBlockProvisioner
+    {
+    public:
+        CBlockProvisioner() = default;
+        ~CBlockProvisioner() { UnInit(); }
+        CBlockProvisioner(const CBlockProvisioner &) = delete;
+        CBlockProvisioner &operator=(const CBlockProvisioner &) = delete;
+
+        // funcPrepare在工作线程中对每个新块调用一次，必须是线程安全的；
+        // Init返回前备用块已经补满
+        int32_t Init(IBlockAllocator *lpAllocator, size_t uBlockSize, bool bPrefault, uint32_t uSpareCount,
+                     uint32_t uLowWatermark, std::function<void(void *)> funcPrepare = nullptr)
+        {
+            UnInit();
+
+            if (lpAllocator == nullptr || uSpareCount == 0 || uSpareCount > MaxSpareBlocks ||
+                uLowWatermark >= uSpareCount)
+            {
+                return 1;
+            }
+
+            m_lpAllocator = lpAllocator;
+            m_uBlockSize = uBlockSize;
+            m_bPrefault = bPrefault;
+            m_uSpareCount = uSpareCount;
+            m_uLowWatermark = uLowWatermark;
+            m_funcPrepare = funcPrepare;
+            m_bStop = false;
+            Refill();
+            if (m_uReady.load(std::memory_order_relaxed) == 0)
+            {
+                return 1;
+            }
+
+            m_thWorker = std::thread(&CBlockProvisioner::WorkerLoop, this);
+            return 0;
+        }
+
+        void UnInit()
+        {
+            if (m_thWorker.joinable())
+            {
+                {
+                    std::lock_guard<std::mutex> guard(m_lock);
+                    m_bStop = true;
+                }
+                m_cond.notify_one();
+                m_thWorker.join();
+            }
+
+            for (uint32_t i = 0; i < MaxSpareBlocks; i++)
+            {
+                auto ptr = m_arrSpares[i].exchange(nullptr, std::memory_order_acquire);
+                if (ptr != nullptr)
+                {
+                    m_lpAllocator->Free(ptr, m_uBlockSize);
+                }
+            }
+            m_uReady.store(0, std::memory_order_relaxed);
+            m_bRefillPending.store(false, std::memory_order_relaxed);
+            m_uSpareCount = 0;
+            m_uCursor = 0;
+        }
+
+        // 没有备用块时返回nullptr，由调用方自己申请
+        void *TakeBlock()
+        {
+            for (uint32_t n = 0; n < m_uSpareCount; n++)
+            {
+                auto i = m_uCursor;
+                m_uCursor = (m_uCursor + 1) % m_uSpareCount;
+                if (m_arrSpares[i].load(std::memory_order_relaxed) == nullptr)
+                {
+                    continue;
+                }
+
+                auto ptr = m_arrSpares[i].exchange(nullptr, std::memory_order_acquire);
+                auto uReady = m_uReady.fetch_sub(1, std::memory_order_relaxed) - 1;
+                if (uReady <= m_uLowWatermark && !m_bRefillPending.exchange(true, std::memory_order_relaxed))
+                {
+                    // 只在跨过低水位时加锁通知一次
+                    std::lock_guard<std::mutex> guard(m_lock);
+                    m_cond.notify_one();
+                }
+                return ptr;
+            }
+            return nullptr;
+        }
+
+        uint32_t GetReadyCount() { return m_uReady.load(std::memory_order_relaxed); }
+
+    private:
+        void WorkerLoop()
+        {
+            while (true)
+            {
+                {
+                    std::unique_lock<std::mutex> guard(m_lock);
+                    m_cond.wait(guard, [this]() { return m_bStop || m_bRefillPending.load(std::memory_order_relaxed); });
+                    if (m_bStop)
+                    {
+                        return;
+                    }
+                }
+                // 先清标志再补，补的过程中再被取走会重新通知
+                m_bRefillPending.store(false, std::memory_order_relaxed);
+                Refill();
+            }
+        }
+
+        // 只有工作线程(或Init)会把空槽位填上
+        void Refill()
+        {
+            for (uint32_t i = 0; i < m_uSpareCount; i++)
+            {
+                if (m_arrSpares[i].load(std::memory_order_relaxed) != nullptr)
+                {
+                    continue;
+                }
+
+                auto ptr = m_lpAllocator->Alloc(m_uBlockSize, m_bPrefault);
+                if (unlikely(ptr == nullptr))
+                {
+                    return;
+                }
+                if (m_funcPrepare != nullptr)
+                {
+                    m_funcPrepare(ptr);
+                }
+                m_arrSpares[i].store(ptr, std::memory_order_release);
+                m_uReady.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+    private:
+        IBlockAllocator *m_lpAllocator{nullptr};
+        size_t m_uBlockSize{0};
+        bool m_bPrefault{false};
+        uint32_t m_uSpareCount{0};
+        uint32_t m_uLowWatermark{0};
+        uint32_t m_uCursor{0}; // 使用方下一次查看的槽位
+        std::function<void(void *)> m_funcPrepare;
+        std::atomic<void *> m_arrSpares[MaxSpareBlocks]{};
+        std::atomic<uint32_t> m_uReady{0};
+        std::atomic<bool> m_bRefillPending{false};
+        bool m_bStop{false};
+        std::mutex m_lock;
+        std::condition_variable m_cond;
+        std::thread m_thWorker;
+    };
+
+} // end namespace utility
+
+#endif //__BLOCK_PROVISIONER_H
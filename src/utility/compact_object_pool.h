@@ -0,0 +1,301 @@
+#ifndef __COMPACT_OBJECT_POOL_H
+#define __COMPACT_OBJECT_POOL_H
+
+#include <include/common.h>
+#include <utility/level_bitmap.h>
+#include <utility/object_pool.h>
+#include <vector>
+
+namespace utility
+{
+
+    constexpr uint32_t CompactMinBlockSize = 4096;
+    constexpr uint32_t CompactMaxBlockObjects = 4096; // 块内位图用一个汇总字，最多64 * 64个对象
+    constexpr uint32_t CompactDataAlign = 64;         // 对象区从缓存行边界开始
+    constexpr uint32_t CompactMaxBlockSize = 1u << 30;
+
+    // 无对象头的对象池：块按自身大小(2的幂)对齐，Release用指针掩码找到所属块，
+    // 用指针在块内的偏移算出编号，对象之间没有ElemHead，小对象按原大小紧密排列。
+    // 对象大小不小于8时按8对齐，否则按2的幂取整；与CObjectPool一样不是线程安全的
+    class CCompactObjectPool
+    {
+        struct ObjectBlock
+        {
+            uint32_t uCurrSize_;      // 当前被使用的数量
+            uint32_t uIndex_;         // 当前块在pool中索引
+            uint64_t uWordFree_;      // 第i位表示bitSetFree_[i]还有空闲
+            BitSetType bitSetFree_[]; // 被使用的置零，空闲的置1，后面是对象区
+
+            void Reset(uint32_t _uIndex, uint32_t uObjects, uint32_t uWords)
+            {
+                uCurrSize_ = 0;
+                uIndex_ = _uIndex;
+                memset(bitSetFree_, 0xFF, uWords * sizeof(BitSetType));
+                // 最后一个字里超出对象数量的位不能被分配
+                if ((uObjects & 63) != 0)
+                {
+                    bitSetFree_[uWords - 1] = (BitSetType(1) << (uObjects & 63)) - 1;
+                }
+                uWordFree_ = uWords == 64 ? ~uint64_t(0) : (uint64_t(1) << uWords) - 1;
+            }
+
+            uint32_t GetObjIndex()
+            {
+                auto i = __builtin_ctzll(uWordFree_);
+                auto idx = __builtin_ctzll(bitSetFree_[i]);
+                bitSetFree_[i] &= bitSetFree_[i] - 1;
+                if (bitSetFree_[i] == 0)
+                {
+                    uWordFree_ &= ~(uint64_t(1) << i);
+                }
+                uCurrSize_++;
+                return (i << BitSetScale) + idx;
+            }
+
+            void ReleaseObjIndex(uint32_t uObjIndex)
+            {
+                auto i = uObjIndex >> BitSetScale;
+                bitSetFree_[i] |= BitSetType(1) << (uObjIndex & ((1 << BitSetScale) - 1));
+                uWordFree_ |= uint64_t(1) << i;
+                uCurrSize_--;
+            }
+        };
+
+    public:
+        CCompactObjectPool() = default;
+        ~CCompactObjectPool() { UnInit(); }
+        CCompactObjectPool(const CCompactObjectPool &) = delete;
+        CCompactObjectPool &operator=(const CCompactObjectPool &) = delete;
+
+        // 块大小为能容纳uTargetObjects个对象的最小2的幂，余下的空间也用来放对象
+        int32_t Init(uint32_t uObjectSize, uint32_t uTargetObjects = BlockObjectSize, uint32_t uInitBlockCount = 1)
+        {
+            UnInit();
+
+            if (uObjectSize == 0 || uTargetObjects == 0 || uTargetObjects > CompactMaxBlockObjects)
+            {
+                return 1;
+            }
+
+            m_uSlotSize = uObjectSize >= 8 ? ALIGN8(uObjectSize) : RoundUpPow2(uObjectSize);
+            // 对象区偏移 = 块头 + 位图，向上取整到缓存行
+            size_t uBlockSize = CompactMinBlockSize;
+            while (uBlockSize < GetDataOffset(uTargetObjects) + (size_t)m_uSlotSize * uTargetObjects)
+            {
+                uBlockSize <<= 1;
+            }
+            if (uBlockSize > CompactMaxBlockSize)
+            {
+                return 1;
+            }
+
+            // 块里还能多放的对象也用上，受限于位图容量
+            uint32_t uObjects = uTargetObjects;
+            while (uObjects < CompactMaxBlockObjects &&
+                   GetDataOffset(uObjects + 1) + (size_t)m_uSlotSize * (uObjects + 1) <= uBlockSize)
+            {
+                uObjects++;
+            }
+
+            m_uBlockSize = uBlockSize;
+            m_uBlockObjects = uObjects;
+            m_uBitWords = (uObjects + 63) / 64;
+            m_uDataOffset = (uint32_t)GetDataOffset(uObjects);
+            // 偏移一定是m_uSlotSize的整数倍，乘以向上取整的倒数再右移32位即可得到编号，无需除法
+            m_uSlotMagic = (uint64_t(1) << 32) / m_uSlotSize + 1;
+
+            if (m_bitmapFree.Init(MinBlockCount) != 0)
+            {
+                return 1;
+            }
+            for (uint32_t i = 0; i < uInitBlockCount; i++)
+            {
+                if (Expand() == nullptr)
+                {
+                    return 1;
+                }
+            }
+            return 0;
+        }
+
+        void UnInit()
+        {
+            for (auto lpBlock : m_vecBlocks)
+            {
+                free(lpBlock);
+            }
+            m_vecBlocks.clear();
+            m_bitmapFree.UnInit();
+            m_lpCurrBlock = nullptr;
+            m_uIdleBlocks = 0;
+        }
+
+        void *Get()
+        {
+            auto lpBlock = m_lpCurrBlock;
+            if (unlikely(lpBlock == nullptr || lpBlock->uCurrSize_ == m_uBlockObjects))
+            {
+                lpBlock = FindFreeBlock();
+                if (unlikely(lpBlock == nullptr))
+                {
+                    return nullptr;
+                }
+            }
+
+            if (unlikely(lpBlock->uCurrSize_ == 0))
+            {
+                m_uIdleBlocks--;
+            }
+            auto uObjIndex = lpBlock->GetObjIndex();
+            if (unlikely(lpBlock->uCurrSize_ == m_uBlockObjects))
+            {
+                m_bitmapFree.Clear(lpBlock->uIndex_);
+            }
+            return (uint8_t *)lpBlock + m_uDataOffset + (size_t)uObjIndex * m_uSlotSize;
+        }
+
+        void Release(void *ptr)
+        {
+            if (unlikely(ptr == nullptr))
+            {
+                return;
+            }
+
+            auto lpBlock = (ObjectBlock *)((uintptr_t)ptr & ~(uintptr_t)(m_uBlockSize - 1));
+            auto uOffset = (uint32_t)((uint8_t *)ptr - (uint8_t *)lpBlock) - m_uDataOffset;
+            auto uObjIndex = (uint32_t)((uOffset * m_uSlotMagic) >> 32);
+
+            if (unlikely(lpBlock->uCurrSize_ == m_uBlockObjects))
+            {
+                m_bitmapFree.Set(lpBlock->uIndex_);
+            }
+            lpBlock->ReleaseObjIndex(uObjIndex);
+            if (unlikely(lpBlock->uCurrSize_ == 0))
+            {
+                m_uIdleBlocks++;
+            }
+        }
+
+        // 释放多余的空闲块，最多保留uKeepIdle个，当前块不释放，返回释放的块数
+        uint32_t Trim(uint32_t uKeepIdle = 0)
+        {
+            uint32_t uFreed = 0;
+            for (uint32_t i = 0; i < m_vecBlocks.size() && m_uIdleBlocks > uKeepIdle;)
+            {
+                auto lpBlock = m_vecBlocks[i];
+                if (lpBlock->uCurrSize_ != 0 || lpBlock == m_lpCurrBlock)
+                {
+                    i++;
+                    continue;
+                }
+
+                // 最后一个块挪到空出来的位置
+                auto uLast = (uint32_t)m_vecBlocks.size() - 1;
+                auto lpLast = m_vecBlocks[uLast];
+                m_bitmapFree.Clear(uLast);
+                if (lpLast != lpBlock)
+                {
+                    lpLast->uIndex_ = i;
+                    m_vecBlocks[i] = lpLast;
+                    if (lpLast->uCurrSize_ != m_uBlockObjects)
+                    {
+                        m_bitmapFree.Set(i);
+                    }
+                    else
+                    {
+                        m_bitmapFree.Clear(i);
+                    }
+                }
+                m_vecBlocks.pop_back();
+                free(lpBlock);
+                m_uIdleBlocks--;
+                uFreed++;
+            }
+            return uFreed;
+        }
+
+        uint32_t GetBlockCount() { return (uint32_t)m_vecBlocks.size(); }
+        uint32_t GetIdleBlockCount() { return m_uIdleBlocks; }
+        uint32_t GetBlockSize() { return m_uBlockSize; }
+        uint32_t GetBlockObjects() { return m_uBlockObjects; }
+        uint32_t GetSlotSize() { return m_uSlotSize; }
+
+    private:
+        static uint32_t RoundUpPow2(uint32_t n) { return n <= 1 ? 1 : 1u << (32 - __builtin_clz(n - 1)); }
+
+        static size_t GetDataOffset(uint32_t uObjects)
+        {
+            auto uHead = sizeof(ObjectBlock) + sizeof(BitSetType) * ((uObjects + 63) / 64);
+            return (uHead + CompactDataAlign - 1) & ~(size_t)(CompactDataAlign - 1);
+        }
+
+        ObjectBlock *FindFreeBlock()
+        {
+            auto uStart = m_lpCurrBlock == nullptr ? 0 : m_lpCurrBlock->uIndex_;
+            auto uIndex = m_bitmapFree.FindNext(uStart);
+            if (likely(uIndex != CLevelBitmap::NotFound))
+            {
+                m_lpCurrBlock = m_vecBlocks[uIndex];
+                return m_lpCurrBlock;
+            }
+
+            auto lpBlock = Expand();
+            if (likely(lpBlock != nullptr))
+            {
+                m_lpCurrBlock = lpBlock;
+            }
+            return lpBlock;
+        }
+
+        ObjectBlock *Expand()
+        {
+            auto uIndex = (uint32_t)m_vecBlocks.size();
+            if (unlikely(uIndex == m_bitmapFree.GetBitCount()))
+            {
+                CLevelBitmap bitmapTmp;
+                if (unlikely(bitmapTmp.Init(uIndex * 2) != 0))
+                {
+                    return nullptr;
+                }
+                for (uint32_t i = 0; i < uIndex; i++)
+                {
+                    if (m_vecBlocks[i]->uCurrSize_ != m_uBlockObjects)
+                    {
+                        bitmapTmp.Set(i);
+                    }
+                }
+                m_bitmapFree.UnInit();
+                m_bitmapFree = bitmapTmp;
+            }
+
+            // 块按自身大小对齐，指针掩码后就是块头
+            void *ptr = nullptr;
+            if (posix_memalign(&ptr, m_uBlockSize, m_uBlockSize) != 0)
+            {
+                return nullptr;
+            }
+
+            auto lpNewBlock = (ObjectBlock *)ptr;
+            lpNewBlock->Reset(uIndex, m_uBlockObjects, m_uBitWords);
+            m_vecBlocks.push_back(lpNewBlock);
+            m_bitmapFree.Set(uIndex);
+            m_uIdleBlocks++;
+            return lpNewBlock;
+        }
+
+    private:
+        uint32_t m_uSlotSize{0};
+        uint64_t m_uSlotMagic{0};
+        uint32_t m_uBlockSize{0};
+        uint32_t m_uBlockObjects{0};
+        uint32_t m_uBitWords{0};
+        uint32_t m_uDataOffset{0};
+        uint32_t m_uIdleBlocks{0};
+        ObjectBlock *m_lpCurrBlock{nullptr};
+        std::vector<ObjectBlock *> m_vecBlocks;
+        CLevelBitmap m_bitmapFree; // 第i位表示m_vecBlocks[i]是未满的块
+    };
+
+} // end namespace utility
+
+#endif //__COMPACT_OBJECT_POOL_H
@@ -0,0 +1,370 @@
+#ifndef __HANDLE_OBJECT_POOL_H
+#define __HANDLE_OBJECT_POOL_H
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include <include/common.h>
+#include <utility/level_bitmap.h>
+#include <utility/object_pool.h>
+
+namespace utility
+{
+
+    // 句柄 = 块编号(16位) | 块内编号(10位) | 代数(6位)，0永远不是有效句柄
+    constexpr uint32_t InvalidHandle = 0;
+    constexpr uint32_t HandleGenBits = 6;
+    constexpr uint32_t HandleSlotBits = 10;
+    constexpr uint32_t HandleBlockBits = 32 - HandleGenBits - HandleSlotBits;
+    constexpr uint32_t HandleGenMask = (1u << HandleGenBits) - 1;
+    constexpr uint32_t HandleSlotMask = (1u << HandleSlotBits) - 1;
+    constexpr uint32_t HandleMaxBlocks = 1u << HandleBlockBits;
+    constexpr uint8_t HandleLiveFlag = 0x80;
+    static_assert((1u << HandleSlotBits) == BlockObjectSize, "slot bits must cover one block");
+
+    // 句柄对象池：用32位句柄代替指针，每个槽位记录代数，归还后代数加一，过期句柄解析时直接失败。
+    // 因为使用方只保存句柄，Compact可以把稀疏块里的对象搬到其他块后释放稀疏块。
+    // 对象必须可以按字节拷贝；与CObjectPool一样不是线程安全的
+    class CHandleObjectPool
+    {
+        // 被释放的块编号及其槽位代数
+        struct FreeIndex
+        {
+            uint32_t uIndex_;
+            std::vector<uint8_t> vecGen_;
+        };
+
+        struct ObjectBlock
+        {
+            uint32_t uCurrSize_;                  // 当前被使用的数量
+            uint32_t uIndex_;                     // 块编号，就是句柄中的块编号，生命周期内不变
+            uint16_t uWordFree_;                  // 第i位表示bitSetFree_[i]还有空闲
+            BitSetType bitSetFree_[BlockBitSize]; // 被使用的置零，空闲的置1
+            uint8_t arrGen_[BlockObjectSize];     // 低6位是代数，最高位表示正在使用
+            alignas(8) uint8_t pData_[];
+
+            // 复用块编号时沿用旧块的代数，旧块留下的句柄仍然是过期的
+            void Reset(uint32_t _uIndex, const uint8_t *lpGen)
+            {
+                uCurrSize_ = 0;
+                uIndex_ = _uIndex;
+                uWordFree_ = (uint16_t)((1u << BlockBitSize) - 1);
+                memset(bitSetFree_, 0xFF, sizeof(bitSetFree_));
+                if (lpGen != nullptr)
+                {
+                    memcpy(arrGen_, lpGen, sizeof(arrGen_));
+                }
+                else
+                {
+                    memset(arrGen_, 1, sizeof(arrGen_));
+                }
+            }
+
+            bool IsFull() { return uCurrSize_ == BlockObjectSize; }
+
+            uint32_t GetSlot()
+            {
+                auto i = __builtin_ctz(uWordFree_);
+                auto idx = __builtin_ctzll(bitSetFree_[i]);
+                bitSetFree_[i] &= bitSetFree_[i] - 1;
+                if (bitSetFree_[i] == 0)
+                {
+                    uWordFree_ &= ~(1u << i);
+                }
+                uCurrSize_++;
+                uint32_t uSlot = (i << BitSetScale) + idx;
+                arrGen_[uSlot] |= HandleLiveFlag;
+                return uSlot;
+            }
+
+            // 代数在1~63之间循环
+            void ReleaseSlot(uint32_t uSlot)
+            {
+                auto uGen = (arrGen_[uSlot] & HandleGenMask) + 1;
+                arrGen_[uSlot] = (uint8_t)(uGen > HandleGenMask ? 1 : uGen);
+                bitSetFree_[uSlot >> BitSetScale] |= BitSetType(1) << (uSlot & ((1 << BitSetScale) - 1));
+                uWordFree_ |= 1u << (uSlot >> BitSetScale);
+                uCurrSize_--;
+            }
+
+            bool IsLive(uint32_t uSlot) { return (arrGen_[uSlot] & HandleLiveFlag) != 0; }
+
+            uint32_t MakeHandle(uint32_t uSlot)
+            {
+                return (uIndex_ << (HandleSlotBits + HandleGenBits)) | (uSlot << HandleGenBits) |
+                       (arrGen_[uSlot] & HandleGenMask);
+            }
+        };
+
+    public:
+        // uOldHandle已经失效，对象已被拷贝到lpNewObj，使用方要把保存的句柄换成uNewHandle
+        using RelocateFunc = std::function<void(uint32_t uOldHandle, uint32_t uNewHandle, void *lpNewObj)>;
+
+        CHandleObjectPool() = default;
+        ~CHandleObjectPool() { UnInit(); }
+        CHandleObjectPool(const CHandleObjectPool &) = delete;
+        CHandleObjectPool &operator=(const CHandleObjectPool &) = delete;
+
+        int32_t Init(uint32_t uObjectSize, uint32_t uInitBlockCount = 1)
+        {
+            UnInit();
+
+            if (uObjectSize == 0 || m_bitmapFree.Init(MinBlockCount) != 0)
+            {
+                return 1;
+            }
+            m_uObjectSize = ALIGN8(uObjectSize);
+            for (uint32_t i = 0; i < uInitBlockCount; i++)
+            {
+                if (Expand() == nullptr)
+                {
+                    return 1;
+                }
+            }
+            return 0;
+        }
+
+        void UnInit()
+        {
+            for (auto lpBlock : m_vecBlocks)
+            {
+                free(lpBlock);
+            }
+            m_vecBlocks.clear();
+            m_vecFreeIndex.clear();
+            m_bitmapFree.UnInit();
+            m_lpCurrBlock = nullptr;
+            m_uBlockCount = 0;
+        }
+
+        // 失败返回InvalidHandle
+        uint32_t Get()
+        {
+            auto lpBlock = m_lpCurrBlock;
+            if (unlikely(lpBlock == nullptr || lpBlock->IsFull()))
+            {
+                lpBlock = FindFreeBlock();
+                if (unlikely(lpBlock == nullptr))
+                {
+                    return InvalidHandle;
+                }
+            }
+
+            auto uSlot = lpBlock->GetSlot();
+            if (unlikely(lpBlock->IsFull()))
+            {
+                m_bitmapFree.Clear(lpBlock->uIndex_);
+            }
+            return lpBlock->MakeHandle(uSlot);
+        }
+
+        // O(1)，过期或非法句柄返回nullptr
+        void *Resolve(uint32_t uHandle)
+        {
+            auto uIndex = uHandle >> (HandleSlotBits + HandleGenBits);
+            if (unlikely(uIndex >= m_vecBlocks.size()))
+            {
+                return nullptr;
+            }
+            auto lpBlock = m_vecBlocks[uIndex];
+            auto uSlot = (uHandle >> HandleGenBits) & HandleSlotMask;
+            if (unlikely(lpBlock == nullptr || lpBlock->arrGen_[uSlot] != (HandleLiveFlag | (uHandle & HandleGenMask))))
+            {
+                return nullptr;
+            }
+            return lpBlock->pData_ + (size_t)uSlot * m_uObjectSize;
+        }
+
+        // 过期句柄返回1，不影响当前占用该槽位的对象
+        int32_t Release(uint32_t uHandle)
+        {
+            if (unlikely(Resolve(uHandle) == nullptr))
+            {
+                return 1;
+            }
+
+            auto lpBlock = m_vecBlocks[uHandle >> (HandleSlotBits + HandleGenBits)];
+            if (unlikely(lpBlock->IsFull()))
+            {
+                m_bitmapFree.Set(lpBlock->uIndex_);
+            }
+            lpBlock->ReleaseSlot((uHandle >> HandleGenBits) & HandleSlotMask);
+            return 0;
+        }
+
+        // 把使用率不超过uMaxLivePerBlock的块里的对象搬到更满的块，搬空的块和原本就空的块都释放。
+        // 每搬一个对象调用一次funcRelocate，返回释放的块数
+        uint32_t Compact(uint32_t uMaxLivePerBlock, const RelocateFunc &funcRelocate)
+        {
+            uint32_t uFreed = 0;
+            std::vector<ObjectBlock *> vecPartial;
+            for (auto lpBlock : m_vecBlocks)
+            {
+                if (lpBlock == nullptr || lpBlock->IsFull())
+                {
+                    continue;
+                }
+                if (lpBlock->uCurrSize_ == 0)
+                {
+                    FreeBlock(lpBlock);
+                    uFreed++;
+                    continue;
+                }
+                vecPartial.push_back(lpBlock);
+            }
+            std::sort(vecPartial.begin(), vecPartial.end(),
+                      [](ObjectBlock *lhs, ObjectBlock *rhs) { return lhs->uCurrSize_ < rhs->uCurrSize_; });
+
+            // 最稀疏的块往最满的块里搬
+            size_t i = 0;
+            size_t j = vecPartial.size();
+            while (i + 1 < j && vecPartial[i]->uCurrSize_ <= uMaxLivePerBlock)
+            {
+                auto lpSrc = vecPartial[i];
+                auto lpDst = vecPartial[j - 1];
+                for (uint32_t uSlot = 0; uSlot < BlockObjectSize && lpSrc->uCurrSize_ != 0 && !lpDst->IsFull(); uSlot++)
+                {
+                    if (lpSrc->IsLive(uSlot))
+                    {
+                        MoveObject(lpSrc, uSlot, lpDst, funcRelocate);
+                    }
+                }
+                if (lpDst->IsFull())
+                {
+                    m_bitmapFree.Clear(lpDst->uIndex_);
+                    j--;
+                }
+                if (lpSrc->uCurrSize_ == 0)
+                {
+                    FreeBlock(lpSrc);
+                    uFreed++;
+                    i++;
+                }
+            }
+            return uFreed;
+        }
+
+        uint32_t GetBlockCount() { return m_uBlockCount; }
+        uint32_t GetObjectSize() { return m_uObjectSize; }
+
+    private:
+        void MoveObject(ObjectBlock *lpSrc, uint32_t uSrcSlot, ObjectBlock *lpDst, const RelocateFunc &funcRelocate)
+        {
+            auto uOldHandle = lpSrc->MakeHandle(uSrcSlot);
+            auto uDstSlot = lpDst->GetSlot();
+            auto lpNewObj = lpDst->pData_ + (size_t)uDstSlot * m_uObjectSize;
+            memcpy(lpNewObj, lpSrc->pData_ + (size_t)uSrcSlot * m_uObjectSize, m_uObjectSize);
+            lpSrc->ReleaseSlot(uSrcSlot);
+            if (funcRelocate != nullptr)
+            {
+                funcRelocate(uOldHandle, lpDst->MakeHandle(uDstSlot), lpNewObj);
+            }
+        }
+
+        ObjectBlock *FindFreeBlock()
+        {
+            auto uStart = m_lpCurrBlock == nullptr ? 0 : m_lpCurrBlock->uIndex_;
+            auto uIndex = m_bitmapFree.FindNext(uStart);
+            if (likely(uIndex != CLevelBitmap::NotFound))
+            {
+                m_lpCurrBlock = m_vecBlocks[uIndex];
+                return m_lpCurrBlock;
+            }
+
+            auto lpBlock = Expand();
+            if (likely(lpBlock != nullptr))
+            {
+                m_lpCurrBlock = lpBlock;
+            }
+            return lpBlock;
+        }
+
+        // 块编号出现在句柄里，释放后编号留给下一个新块
+        ObjectBlock *Expand()
+        {
+            uint32_t uIndex = 0;
+            const uint8_t *lpGen = nullptr;
+            if (!m_vecFreeIndex.empty())
+            {
+                uIndex = m_vecFreeIndex.back().uIndex_;
+                lpGen = m_vecFreeIndex.back().vecGen_.data();
+            }
+            else
+            {
+                uIndex = (uint32_t)m_vecBlocks.size();
+                if (unlikely(uIndex >= HandleMaxBlocks))
+                {
+                    return nullptr;
+                }
+                if (unlikely(uIndex == m_bitmapFree.GetBitCount()) && GrowBitmap(uIndex * 2) != 0)
+                {
+                    return nullptr;
+                }
+            }
+
+            auto lpNewBlock = (ObjectBlock *)malloc(sizeof(ObjectBlock) + (size_t)m_uObjectSize * BlockObjectSize);
+            if (unlikely(lpNewBlock == nullptr))
+            {
+                return nullptr;
+            }
+            lpNewBlock->Reset(uIndex, lpGen);
+
+            if (uIndex == m_vecBlocks.size())
+            {
+                m_vecBlocks.push_back(lpNewBlock);
+            }
+            else
+            {
+                m_vecFreeIndex.pop_back();
+                m_vecBlocks[uIndex] = lpNewBlock;
+            }
+            m_bitmapFree.Set(uIndex);
+            m_uBlockCount++;
+            return lpNewBlock;
+        }
+
+        int32_t GrowBitmap(uint32_t uBitCount)
+        {
+            CLevelBitmap bitmapTmp;
+            if (bitmapTmp.Init(uBitCount) != 0)
+            {
+                return 1;
+            }
+            for (uint32_t i = 0; i < m_vecBlocks.size(); i++)
+            {
+                if (m_vecBlocks[i] != nullptr && !m_vecBlocks[i]->IsFull())
+                {
+                    bitmapTmp.Set(i);
+                }
+            }
+            m_bitmapFree.UnInit();
+            m_bitmapFree = bitmapTmp;
+            return 0;
+        }
+
+        void FreeBlock(ObjectBlock *lpBlock)
+        {
+            if (lpBlock == m_lpCurrBlock)
+            {
+                m_lpCurrBlock = nullptr;
+            }
+            m_bitmapFree.Clear(lpBlock->uIndex_);
+            m_vecBlocks[lpBlock->uIndex_] = nullptr;
+            m_vecFreeIndex.push_back(FreeIndex{lpBlock->uIndex_,
+                                               std::vector<uint8_t>(lpBlock->arrGen_, lpBlock->arrGen_ + BlockObjectSize)});
+            m_uBlockCount--;
+            free(lpBlock);
+        }
+
+    private:
+        uint32_t m_uObjectSize{0};
+        uint32_t m_uBlockCount{0};
+        ObjectBlock *m_lpCurrBlock{nullptr};
+        std::vector<ObjectBlock *> m_vecBlocks; // 下标就是块编号，释放的块留空
+        std::vector<FreeIndex> m_vecFreeIndex;  // 空出来的块编号
+        CLevelBitmap m_bitmapFree;              // 第i位表示m_vecBlocks[i]是未满的块
+    };
+
+} // end namespace utility
+
+#endif //__HANDLE_OBJECT_POOL_H
@@ -0,0 +1,134 @@
+#ifndef __LEVEL_BITMAP_H
+#define __LEVEL_BITMAP_H
+
+#include <include/common.h>
+
+namespace utility
+{
+
+    // 两级位图：第一级每位表示一个槽位，第二级每位表示第一级的一个字是否非零
+    // 查找下一个置位只需要几次ctz，第二级每个字覆盖4096个槽位
+    // 与CObjectPool一致，内存由Init/UnInit显式管理
+    class CLevelBitmap
+    {
+    public:
+        static constexpr uint32_t NotFound = 0xFFFFFFFF;
+
+        CLevelBitmap() = default;
+        ~CLevelBitmap() = default;
+
+        // 重新初始化，所有位清零
+        int32_t Init(uint32_t uBitCount)
+        {
+            UnInit();
+
+            m_uWords = (uBitCount + 63) / 64;
+            m_uSummaryWords = (m_uWords + 63) / 64;
+            m_lpBits = (uint64_t *)calloc(m_uWords + m_uSummaryWords, sizeof(uint64_t));
+            if (m_lpBits == nullptr)
+            {
+                m_uWords = 0;
+                m_uSummaryWords = 0;
+                return 1;
+            }
+            m_lpSummary = m_lpBits + m_uWords;
+            m_uBitCount = uBitCount;
+            return 0;
+        }
+
+        void UnInit()
+        {
+            free(m_lpBits);
+            m_lpBits = nullptr;
+            m_lpSummary = nullptr;
+            m_uBitCount = 0;
+            m_uWords = 0;
+            m_uSummaryWords = 0;
+        }
+
+        uint32_t GetBitCount() { return m_uBitCount; }
+
+        bool Test(uint32_t uIndex) { return (m_lpBits[uIndex >> 6] >> (uIndex & 63)) & 1; }
+
+        void Set(uint32_t uIndex)
+        {
+            auto uWord = uIndex >> 6;
+            m_lpBits[uWord] |= uint64_t(1) << (uIndex & 63);
+            m_lpSummary[uWord >> 6] |= uint64_t(1) << (uWord & 63);
+        }
+
+        void Clear(uint32_t uIndex)
+        {
+            auto uWord = uIndex >> 6;
+            m_lpBits[uWord] &= ~(uint64_t(1) << (uIndex & 63));
+            if (m_lpBits[uWord] == 0)
+            {
+                m_lpSummary[uWord >> 6] &= ~(uint64_t(1) << (uWord & 63));
+            }
+        }
+
+        // 从uStart开始向后找第一个置位，到末尾后从头绕回，没有返回NotFound
+        uint32_t FindNext(uint32_t uStart)
+        {
+            if (unlikely(m_uBitCount == 0))
+            {
+                return NotFound;
+            }
+            if (unlikely(uStart >= m_uBitCount))
+            {
+                uStart = 0;
+            }
+
+            auto uWord = uStart >> 6;
+            auto bits = m_lpBits[uWord] & (~uint64_t(0) << (uStart & 63));
+            if (bits != 0)
+            {
+                return (uWord << 6) + __builtin_ctzll(bits);
+            }
+
+            auto uNext = FindWord(uWord + 1);
+            if (uNext == NotFound)
+            {
+                // 绕回，包括起点所在字里起点之前的位
+                uNext = FindWord(0);
+                if (uNext == NotFound || uNext > uWord)
+                {
+                    return NotFound;
+                }
+            }
+            return (uNext << 6) + __builtin_ctzll(m_lpBits[uNext]);
+        }
+
+    private:
+        // 借助第二级找第一个非零的第一级字
+        uint32_t FindWord(uint32_t uFrom)
+        {
+            auto uSummary = uFrom >> 6;
+            if (uSummary >= m_uSummaryWords)
+            {
+                return NotFound;
+            }
+
+            auto bits = m_lpSummary[uSummary] & (~uint64_t(0) << (uFrom & 63));
+            while (bits == 0)
+            {
+                if (++uSummary >= m_uSummaryWords)
+                {
+                    return NotFound;
+                }
+                bits = m_lpSummary[uSummary];
+            }
+            return (uSummary << 6) + __builtin_ctzll(bits);
+        }
+
+    private:
+        uint64_t *m_lpBits{nullptr};
+        uint64_t *m_lpSummary{nullptr};
+        uint32_t m_uBitCount{0};
+        uint32_t m_uWords{0};
+        uint32_t m_uSummaryWords{0};
+    };
+
+} // end namespace utility
+
+#endif //__LEVEL_BITMAP_H
@@ -0,0 +1,382 @@
+#ifndef __LOCKFREE_OBJECT_POOL_H
+#define __LOCKFREE_OBJECT_POOL_H
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <utility/object_pool.h>
+
+namespace utility
+{
+
+    constexpr uint32_t MaxBlockSegmentCount = 24; // 第k段容纳 MinBlockCount * 2^k 个块
+
+    // 无锁对象池：块内位图用原子CAS抢占，块目录分段增长，已发布的块在UnInit前不移动也不释放
+    // Init/UnInit不是线程安全的，其余接口可被任意线程并发调用
+    class CLockFreeObjectPool
+    {
+        struct ElemHead
+        {
+            uint64_t pOwnerBlock_ : 48; // 所属的块指针
+            uint64_t uObjIndex_ : 16;   // 在块中的编号
+            uint8_t pData_[];
+
+            void Reset(uint16_t uObjIdx, uint64_t pOwnerBlock)
+            {
+                pOwnerBlock_ = pOwnerBlock;
+                uObjIndex_ = uObjIdx;
+            }
+
+            void *GetOwnerBlockPtr() { return reinterpret_cast<void *>(pOwnerBlock_); }
+            uint16_t GetObjIndex() { return (uint16_t)uObjIndex_; }
+        };
+
+        struct ObjectBlock
+        {
+            std::atomic<uint32_t> uCurrSize_;                  // 已预留的数量，先预留再抢位
+            uint32_t uIndex_;                                  // 当前块在pool中索引
+            std::atomic<BitSetType> bitSetFree_[BlockBitSize]; // 被使用的置零，空闲的置1
+            uint8_t pData_[];
+
+            void Reset(uint32_t _uIndex)
+            {
+                uCurrSize_.store(0, std::memory_order_relaxed);
+                uIndex_ = _uIndex;
+                for (uint32_t i = 0; i < BlockBitSize; i++)
+                {
+                    bitSetFree_[i].store(~BitSetType(0), std::memory_order_relaxed);
+                }
+            }
+
+            // 预留一个名额，成功后块内必定存在空闲位
+            bool Reserve()
+            {
+                if (uCurrSize_.load(std::memory_order_relaxed) >= BlockObjectSize)
+                {
+                    return false;
+                }
+                if (uCurrSize_.fetch_add(1, std::memory_order_relaxed) >= BlockObjectSize)
+                {
+                    uCurrSize_.fetch_sub(1, std::memory_order_relaxed);
+                    return false;
+                }
+                return true;
+            }
+
+            // 调用前必须Reserve成功
+            ElemHead *GetObject(uint32_t uObjSize, uint32_t uStartWord)
+            {
+                for (uint32_t n = 0;; n++)
+                {
+                    auto i = (uStartWord + n) % BlockBitSize;
+                    auto bits = bitSetFree_[i].load(std::memory_order_relaxed);
+                    while (bits != 0)
+                    {
+                        unsigned long idx = 0;
+#ifdef _WIN32
+                        _BitScanForward64(&idx, bits);
+#else
+                        idx = __builtin_ctzll(bits);
+#endif
+                        auto mask = BitSetType(1) << idx;
+                        if (bitSetFree_[i].compare_exchange_weak(bits, bits & ~mask, std::memory_order_acquire,
+                                                                 std::memory_order_relaxed))
+                        {
+                            uint16_t uObjIdx = (i << BitSetScale) + idx;
+                            auto lpElemHead = (ElemHead *)&pData_[uObjIdx * uObjSize];
+                            lpElemHead->Reset(uObjIdx, (uint64_t)this);
+                            return lpElemHead;
+                        }
+                    }
+                }
+            }
+
+            // 返回true表示本次释放使块重新变为全部空闲
+            bool ReleaseObject(ElemHead *lpElemHead)
+            {
+                auto ObjIndex_ = lpElemHead->GetObjIndex();
+                auto bitSetIndex = ObjIndex_ >> BitSetScale;
+                auto bitIndex = ObjIndex_ & ((1 << BitSetScale) - 1);
+                bitSetFree_[bitSetIndex].fetch_or(BitSetType(1) << bitIndex, std::memory_order_release);
+                return uCurrSize_.fetch_sub(1, std::memory_order_release) == 1;
+            }
+        };
+
+        using BlockSlot = std::atomic<ObjectBlock *>;
+
+    public:
+        CLockFreeObjectPool() = default;
+        ~CLockFreeObjectPool() { UnInit(); }
+        CLockFreeObjectPool(const CLockFreeObjectPool &) = delete;
+        CLockFreeObjectPool &operator=(const CLockFreeObjectPool &) = delete;
+
+        int32_t Init(uint32_t uObjectSize, std::function<void(void *)> funcConstruct = nullptr)
+        {
+            UnInit();
+
+            m_funcConstruct = funcConstruct;
+            m_uObjectSize = sizeof(ElemHead) + ALIGN8(uObjectSize);
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                if (Expand() == nullptr)
+                {
+                    return 1;
+                }
+            }
+
+            return 0;
+        }
+
+        void UnInit()
+        {
+            for (uint32_t i = 0; i < MaxBlockSegmentCount; i++)
+            {
+                auto lpSegment = m_lppSegments[i].load(std::memory_order_acquire);
+                if (lpSegment == nullptr)
+                {
+                    continue;
+                }
+
+                // 竞争失败的线程可能在count之外发布了块，整段检查
+                for (uint32_t j = 0; j < (MinBlockCount << i); j++)
+                {
+                    auto lpBlock = lpSegment[j].load(std::memory_order_relaxed);
+                    if (lpBlock != nullptr)
+                    {
+                        free(lpBlock);
+                    }
+                }
+                delete[] lpSegment;
+                m_lppSegments[i].store(nullptr, std::memory_order_relaxed);
+            }
+            m_uBlockCount.store(0, std::memory_order_relaxed);
+            m_uCurrIndex.store(0, std::memory_order_relaxed);
+        }
+
+        void *Get()
+        {
+            while (true)
+            {
+                auto uCount = m_uBlockCount.load(std::memory_order_acquire);
+                auto uHint = m_uCurrIndex.load(std::memory_order_relaxed);
+                // 从提示位置开始绕一圈，预期只有一两次循环
+                for (uint32_t n = 0; n < uCount; n++)
+                {
+                    auto i = (uHint + n) % uCount;
+                    auto lpBlock = GetSlot(i)->load(std::memory_order_acquire);
+                    if (likely(lpBlock != nullptr && lpBlock->Reserve()))
+                    {
+                        if (i != uHint)
+                        {
+                            m_uCurrIndex.store(i, std::memory_order_relaxed);
+                        }
+                        auto lpElemHead = lpBlock->GetObject(m_uObjectSize, GetStartWord());
+                        return lpElemHead->pData_;
+                    }
+                }
+
+                // 扩容，新块可能立刻被其他线程抢空，因此重新走一遍查找
+                auto lpBlock = Expand();
+                if (unlikely(lpBlock == nullptr))
+                {
+                    return nullptr;
+                }
+                m_uCurrIndex.store(lpBlock->uIndex_, std::memory_order_relaxed);
+            }
+        }
+
+        void Release(void *ptr)
+        {
+            if (unlikely(ptr == nullptr))
+            {
+                return;
+            }
+
+            auto lpElemHead = (ElemHead *)((uint8_t *)ptr - sizeof(ElemHead));
+            auto lpOwnerBlock = (ObjectBlock *)lpElemHead->GetOwnerBlockPtr();
+            // 块不移动，只有使块变空的那一次释放把它设为下次Get的起点
+            if (unlikely(lpOwnerBlock->ReleaseObject(lpElemHead)))
+            {
+                auto uHint = m_uCurrIndex.load(std::memory_order_relaxed);
+                auto lpHintBlock = GetSlot(uHint)->load(std::memory_order_acquire);
+                if (lpHintBlock == nullptr ||
+                    lpHintBlock->uCurrSize_.load(std::memory_order_relaxed) >= BlockObjectSize)
+                {
+                    m_uCurrIndex.store(lpOwnerBlock->uIndex_, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        uint32_t GetBlockCount() { return m_uBlockCount.load(std::memory_order_relaxed); }
+
+    private:
+        // 不同线程从不同的位图字开始抢位，降低同一个字上的CAS冲突
+        static uint32_t GetStartWord()
+        {
+            static thread_local uint32_t s_uStartWord =
+                (uint32_t)(std::hash<std::thread::id>()(std::this_thread::get_id()) % BlockBitSize);
+            return s_uStartWord;
+        }
+
+        static uint32_t GetSegmentIndex(uint32_t uIndex)
+        {
+            return 31 - __builtin_clz(uIndex / MinBlockCount + 1);
+        }
+
+        // 段一旦发布就不再移动，读者无需加锁
+        BlockSlot *GetSlot(uint32_t uIndex)
+        {
+            auto uSegment = GetSegmentIndex(uIndex);
+            auto lpSegment = m_lppSegments[uSegment].load(std::memory_order_acquire);
+            if (unlikely(lpSegment == nullptr))
+            {
+                return nullptr;
+            }
+            return &lpSegment[uIndex - MinBlockCount * ((1u << uSegment) - 1)];
+        }
+
+        BlockSlot *GetOrCreateSlot(uint32_t uIndex)
+        {
+            auto uSegment = GetSegmentIndex(uIndex);
+            if (unlikely(uSegment >= MaxBlockSegmentCount))
+            {
+                return nullptr;
+            }
+
+            auto lpSegment = m_lppSegments[uSegment].load(std::memory_order_acquire);
+            if (lpSegment == nullptr)
+            {
+                auto lpNewSegment = new (std::nothrow) BlockSlot[MinBlockCount << uSegment];
+                if (unlikely(lpNewSegment == nullptr))
+                {
+                    return nullptr;
+                }
+                for (uint32_t i = 0; i < (MinBlockCount << uSegment); i++)
+                {
+                    lpNewSegment[i].store(nullptr, std::memory_order_relaxed);
+                }
+
+                if (m_lppSegments[uSegment].compare_exchange_strong(lpSegment, lpNewSegment,
+                                                                    std::memory_order_acq_rel))
+                {
+                    lpSegment = lpNewSegment;
+                }
+                else
+                {
+                    delete[] lpNewSegment;
+                }
+            }
+            return &lpSegment[uIndex - MinBlockCount * ((1u << uSegment) - 1)];
+        }
+
+        void WarnUp(void *ptr, uint32_t uSize)
+        {
+            uint32_t uPageSize = (uint32_t)sysconf(_SC_PAGESIZE);
+            auto addr = (uint8_t *)ptr;
+            for (uint32_t offset = 0; offset < uSize; offset += uPageSize)
+            {
+                addr[offset] = 0x00;
+            }
+            addr[uSize - 1] = 0x00;
+        }
+
+        ObjectBlock *AllocBlock(uint32_t uIndex)
+        {
+            uint32_t uBlockSize = sizeof(ObjectBlock) + m_uObjectSize * BlockObjectSize;
+            auto lpNewBlock = (ObjectBlock *)malloc(uBlockSize);
+            if (unlikely(lpNewBlock == nullptr))
+            {
+                return nullptr;
+            }
+
+            if (m_funcConstruct != nullptr)
+            {
+                for (uint32_t i = 0; i < BlockObjectSize; i++)
+                {
+                    auto ptr = (ElemHead *)&lpNewBlock->pData_[i * m_uObjectSize];
+                    m_funcConstruct(ptr->pData_);
+                }
+            }
+            else
+            {
+                WarnUp(lpNewBlock, uBlockSize);
+            }
+
+            new (lpNewBlock) ObjectBlock;
+            lpNewBlock->Reset(uIndex);
+            return lpNewBlock;
+        }
+
+        // 在count位置发布一个块，竞争失败的一方释放自己的块并帮忙推进count
+        ObjectBlock *Expand()
+        {
+            // 已有线程在扩容时让出CPU，等它发布后再去抢新块，避免重复申请大块内存
+            if (m_bExpanding.exchange(true, std::memory_order_acquire))
+            {
+                auto uCount = m_uBlockCount.load(std::memory_order_acquire);
+                while (m_bExpanding.load(std::memory_order_relaxed) &&
+                       uCount == m_uBlockCount.load(std::memory_order_acquire))
+                {
+                    std::this_thread::yield();
+                }
+                uCount = m_uBlockCount.load(std::memory_order_acquire);
+                if (uCount > 0)
+                {
+                    return GetSlot(uCount - 1)->load(std::memory_order_acquire);
+                }
+            }
+
+            ObjectBlock *lpResult = nullptr;
+            ObjectBlock *lpNewBlock = nullptr;
+            while (lpResult == nullptr)
+            {
+                auto uCount = m_uBlockCount.load(std::memory_order_acquire);
+                auto lpSlot = GetOrCreateSlot(uCount);
+                if (unlikely(lpSlot == nullptr))
+                {
+                    break;
+                }
+
+                auto lpPublished = lpSlot->load(std::memory_order_acquire);
+                if (lpPublished == nullptr)
+                {
+                    if (lpNewBlock == nullptr)
+                    {
+                        lpNewBlock = AllocBlock(uCount);
+                        if (unlikely(lpNewBlock == nullptr))
+                        {
+                            break;
+                        }
+                    }
+                    lpNewBlock->uIndex_ = uCount;
+                    if (lpSlot->compare_exchange_strong(lpPublished, lpNewBlock, std::memory_order_acq_rel))
+                    {
+                        lpPublished = lpNewBlock;
+                        lpResult = lpNewBlock;
+                        lpNewBlock = nullptr;
+                    }
+                }
+
+                m_uBlockCount.compare_exchange_strong(uCount, uCount + 1, std::memory_order_acq_rel);
+            }
+
+            if (lpNewBlock != nullptr)
+            {
+                free(lpNewBlock);
+            }
+            m_bExpanding.store(false, std::memory_order_release);
+            return lpResult;
+        }
+
+    private:
+        uint32_t m_uObjectSize{0};
+        std::atomic<uint32_t> m_uCurrIndex{0};
+        std::atomic<uint32_t> m_uBlockCount{0};
+        std::atomic<bool> m_bExpanding{false};
+        std::atomic<BlockSlot *> m_lppSegments[MaxBlockSegmentCount]{};
+        std::function<void(void *)> m_funcConstruct;
+    };
+
+} // end namespace utility
+
+#endif //__LOCKFREE_OBJECT_POOL_H
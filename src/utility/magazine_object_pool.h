@@ -0,0 +1,452 @@
+#ifndef __MAGAZINE_OBJECT_POOL_H
+#define __MAGAZINE_OBJECT_POOL_H
+
+#include <atomic>
+#include <mutex>
+#include <utility/object_pool.h>
+
+namespace utility
+{
+
+    constexpr uint32_t DefaultMagazineSize = 64;
+    constexpr uint32_t MaxMagazineSize = 1024;
+    constexpr uint32_t DefaultDepotSize = 16;    // 仓库默认保留的满弹夹数量
+    constexpr uint32_t MaxThreadCachePools = 16; // 单个线程最多同时缓存的池数量
+
+    // 多线程对象池：每个线程持有两个弹夹(loaded/previous)，弹夹整体与共享仓库(depot)交换，
+    // 绝大多数Get/Release只操作线程私有的弹夹，不触碰共享状态
+    class CMagazineObjectPool
+    {
+        struct Magazine
+        {
+            Magazine *lpNext_;
+            uint32_t uSize_;
+            uint32_t Reverse_;
+            void *lppObjs_[];
+        };
+
+        struct ThreadCache
+        {
+            CMagazineObjectPool *lpPool_; // 池已销毁时置空，受全局锁保护
+            uint64_t uPoolId_;
+            Magazine *lpLoaded_;
+            Magazine *lpPrevious_; // 要么满，要么空
+            ThreadCache *lpPrev_;
+            ThreadCache *lpNext_;
+        };
+
+        // 线程退出时把弹夹里的对象归还给池
+        struct ThreadCacheTable
+        {
+            ThreadCache *lppCaches_[MaxThreadCachePools]{nullptr};
+
+            ~ThreadCacheTable()
+            {
+                std::lock_guard<std::mutex> guard(GetRegistryLock());
+                for (uint32_t i = 0; i < MaxThreadCachePools; i++)
+                {
+                    DestroyCacheLocked(lppCaches_[i]);
+                    lppCaches_[i] = nullptr;
+                }
+            }
+
+            // 回收已销毁池遗留的槽位，调用方持有全局锁
+            void SweepLocked()
+            {
+                for (uint32_t i = 0; i < MaxThreadCachePools; i++)
+                {
+                    if (lppCaches_[i] != nullptr && lppCaches_[i]->lpPool_ == nullptr)
+                    {
+                        delete lppCaches_[i];
+                        lppCaches_[i] = nullptr;
+                    }
+                }
+            }
+        };
+
+    public:
+        CMagazineObjectPool() = default;
+        ~CMagazineObjectPool() { UnInit(); }
+        CMagazineObjectPool(const CMagazineObjectPool &) = delete;
+        CMagazineObjectPool &operator=(const CMagazineObjectPool &) = delete;
+
+        int32_t Init(uint32_t uObjectSize, uint32_t uMagazineSize = DefaultMagazineSize,
+                     std::function<void(void *)> funcConstruct = nullptr)
+        {
+            UnInit();
+
+            if (uMagazineSize == 0 || uMagazineSize > MaxMagazineSize)
+            {
+                return 1;
+            }
+
+            std::lock_guard<std::mutex> guard(m_lock);
+            if (m_pool.Init(uObjectSize, funcConstruct) != 0)
+            {
+                m_pool.UnInit();
+                return 1;
+            }
+
+            m_uMagazineSize = uMagazineSize;
+            m_uMaxFullMagazines = DefaultDepotSize;
+            m_uPoolId = NextPoolId();
+            return 0;
+        }
+
+        void UnInit()
+        {
+            std::lock_guard<std::mutex> guard(GetRegistryLock());
+            std::lock_guard<std::mutex> guardPool(m_lock);
+            if (m_uPoolId == 0)
+            {
+                return;
+            }
+
+            // 线程缓存由线程自己释放，这里只断开关联，弹夹中的对象随块一起释放
+            for (auto lpCache = m_lpCaches; lpCache != nullptr; lpCache = lpCache->lpNext_)
+            {
+                FreeMagazine(lpCache->lpLoaded_);
+                FreeMagazine(lpCache->lpPrevious_);
+                lpCache->lpLoaded_ = nullptr;
+                lpCache->lpPrevious_ = nullptr;
+                lpCache->lpPool_ = nullptr;
+            }
+            m_lpCaches = nullptr;
+
+            FreeMagazineList(m_lpFullMagazines);
+            FreeMagazineList(m_lpEmptyMagazines);
+            m_lpFullMagazines = nullptr;
+            m_lpEmptyMagazines = nullptr;
+            m_uFullMagazines = 0;
+
+            m_pool.UnInit();
+            m_uPoolId = 0;
+        }
+
+        void *Get()
+        {
+            auto lpCache = GetThreadCache();
+            if (unlikely(lpCache == nullptr))
+            {
+                std::lock_guard<std::mutex> guard(m_lock);
+                return m_pool.Get();
+            }
+
+            auto lpLoaded = lpCache->lpLoaded_;
+            if (likely(lpLoaded->uSize_ > 0))
+            {
+                return lpLoaded->lppObjs_[--lpLoaded->uSize_];
+            }
+
+            return GetSlow(lpCache);
+        }
+
+        void Release(void *ptr)
+        {
+            if (unlikely(ptr == nullptr))
+            {
+                return;
+            }
+
+            auto lpCache = GetThreadCache();
+            if (unlikely(lpCache == nullptr))
+            {
+                std::lock_guard<std::mutex> guard(m_lock);
+                m_pool.Release(ptr);
+                return;
+            }
+
+            auto lpLoaded = lpCache->lpLoaded_;
+            if (likely(lpLoaded->uSize_ < m_uMagazineSize))
+            {
+                lpLoaded->lppObjs_[lpLoaded->uSize_++] = ptr;
+                return;
+            }
+
+            ReleaseSlow(lpCache, ptr);
+        }
+
+        // 仓库中最多保留的满弹夹数量，超出的部分归还给底层池
+        void SetDepotSize(uint32_t uMaxFullMagazines)
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            m_uMaxFullMagazines = uMaxFullMagazines;
+        }
+
+    private:
+        static std::mutex &GetRegistryLock()
+        {
+            static std::mutex s_lock;
+            return s_lock;
+        }
+
+        static uint64_t NextPoolId()
+        {
+            static std::atomic<uint64_t> s_uPoolId{0};
+            return ++s_uPoolId;
+        }
+
+        static ThreadCacheTable &GetThreadCacheTable()
+        {
+            static thread_local ThreadCacheTable s_table;
+            return s_table;
+        }
+
+        // 调用方持有全局锁
+        static void DestroyCacheLocked(ThreadCache *lpCache)
+        {
+            if (lpCache == nullptr)
+            {
+                return;
+            }
+
+            if (lpCache->lpPool_ != nullptr)
+            {
+                lpCache->lpPool_->DetachCache(lpCache);
+            }
+            delete lpCache;
+        }
+
+        ThreadCache *GetThreadCache()
+        {
+            auto &table = GetThreadCacheTable();
+            for (uint32_t i = 0; i < MaxThreadCachePools; i++)
+            {
+                if (likely(table.lppCaches_[i] != nullptr && table.lppCaches_[i]->uPoolId_ == m_uPoolId))
+                {
+                    return table.lppCaches_[i];
+                }
+            }
+
+            return CreateThreadCache(table);
+        }
+
+        ThreadCache *CreateThreadCache(ThreadCacheTable &table)
+        {
+            std::lock_guard<std::mutex> guard(GetRegistryLock());
+            if (unlikely(m_uPoolId == 0))
+            {
+                return nullptr;
+            }
+            table.SweepLocked();
+
+            uint32_t uSlot = MaxThreadCachePools;
+            for (uint32_t i = 0; i < MaxThreadCachePools; i++)
+            {
+                if (table.lppCaches_[i] == nullptr)
+                {
+                    uSlot = i;
+                    break;
+                }
+            }
+            if (unlikely(uSlot == MaxThreadCachePools))
+            {
+                return nullptr;
+            }
+
+            auto lpCache = new (std::nothrow) ThreadCache();
+            if (unlikely(lpCache == nullptr))
+            {
+                return nullptr;
+            }
+
+            std::lock_guard<std::mutex> guardPool(m_lock);
+            lpCache->lpLoaded_ = AllocMagazine();
+            lpCache->lpPrevious_ = AllocMagazine();
+            if (unlikely(lpCache->lpLoaded_ == nullptr || lpCache->lpPrevious_ == nullptr))
+            {
+                FreeMagazine(lpCache->lpLoaded_);
+                FreeMagazine(lpCache->lpPrevious_);
+                delete lpCache;
+                return nullptr;
+            }
+
+            lpCache->lpPool_ = this;
+            lpCache->uPoolId_ = m_uPoolId;
+            lpCache->lpPrev_ = nullptr;
+            lpCache->lpNext_ = m_lpCaches;
+            if (m_lpCaches != nullptr)
+            {
+                m_lpCaches->lpPrev_ = lpCache;
+            }
+            m_lpCaches = lpCache;
+
+            table.lppCaches_[uSlot] = lpCache;
+            return lpCache;
+        }
+
+        // 线程退出，调用方持有全局锁
+        void DetachCache(ThreadCache *lpCache)
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            FlushMagazine(lpCache->lpLoaded_);
+            FlushMagazine(lpCache->lpPrevious_);
+            PushEmpty(lpCache->lpLoaded_);
+            PushEmpty(lpCache->lpPrevious_);
+
+            if (lpCache->lpPrev_ != nullptr)
+            {
+                lpCache->lpPrev_->lpNext_ = lpCache->lpNext_;
+            }
+            else
+            {
+                m_lpCaches = lpCache->lpNext_;
+            }
+            if (lpCache->lpNext_ != nullptr)
+            {
+                lpCache->lpNext_->lpPrev_ = lpCache->lpPrev_;
+            }
+            lpCache->lpPool_ = nullptr;
+        }
+
+        void *GetSlow(ThreadCache *lpCache)
+        {
+            // previous是满的，直接交换
+            if (lpCache->lpPrevious_->uSize_ > 0)
+            {
+                std::swap(lpCache->lpLoaded_, lpCache->lpPrevious_);
+                auto lpLoaded = lpCache->lpLoaded_;
+                return lpLoaded->lppObjs_[--lpLoaded->uSize_];
+            }
+
+            std::lock_guard<std::mutex> guard(m_lock);
+            if (m_lpFullMagazines != nullptr)
+            {
+                // 空的previous还给仓库，loaded降为previous，装上满弹夹
+                PushEmpty(lpCache->lpPrevious_);
+                lpCache->lpPrevious_ = lpCache->lpLoaded_;
+                lpCache->lpLoaded_ = PopFull();
+            }
+            else
+            {
+                // 仓库没有满弹夹，从底层池装填
+                FillMagazine(lpCache->lpLoaded_);
+            }
+
+            auto lpLoaded = lpCache->lpLoaded_;
+            if (unlikely(lpLoaded->uSize_ == 0))
+            {
+                return nullptr;
+            }
+            return lpLoaded->lppObjs_[--lpLoaded->uSize_];
+        }
+
+        void ReleaseSlow(ThreadCache *lpCache, void *ptr)
+        {
+            // previous是空的，直接交换
+            if (lpCache->lpPrevious_->uSize_ == 0)
+            {
+                std::swap(lpCache->lpLoaded_, lpCache->lpPrevious_);
+                auto lpLoaded = lpCache->lpLoaded_;
+                lpLoaded->lppObjs_[lpLoaded->uSize_++] = ptr;
+                return;
+            }
+
+            std::lock_guard<std::mutex> guard(m_lock);
+            if (m_uFullMagazines >= m_uMaxFullMagazines)
+            {
+                // 仓库已满，满的previous归还给底层池后与loaded交换
+                FlushMagazine(lpCache->lpPrevious_);
+                std::swap(lpCache->lpLoaded_, lpCache->lpPrevious_);
+            }
+            else
+            {
+                auto lpEmpty = PopEmpty();
+                if (unlikely(lpEmpty == nullptr))
+                {
+                    m_pool.Release(ptr);
+                    return;
+                }
+                // 满的previous交给仓库，loaded降为previous，装上空弹夹
+                PushFull(lpCache->lpPrevious_);
+                lpCache->lpPrevious_ = lpCache->lpLoaded_;
+                lpCache->lpLoaded_ = lpEmpty;
+            }
+
+            auto lpLoaded = lpCache->lpLoaded_;
+            lpLoaded->lppObjs_[lpLoaded->uSize_++] = ptr;
+        }
+
+        // 以下函数调用方持有m_lock
+        void FillMagazine(Magazine *lpMagazine)
+        {
+            lpMagazine->uSize_ += m_pool.GetBatch(m_uMagazineSize - lpMagazine->uSize_,
+                                                  lpMagazine->lppObjs_ + lpMagazine->uSize_);
+        }
+
+        void FlushMagazine(Magazine *lpMagazine)
+        {
+            m_pool.ReleaseBatch(lpMagazine->lppObjs_, lpMagazine->uSize_);
+            lpMagazine->uSize_ = 0;
+        }
+
+        Magazine *AllocMagazine()
+        {
+            auto lpMagazine = (Magazine *)malloc(sizeof(Magazine) + sizeof(void *) * m_uMagazineSize);
+            if (likely(lpMagazine != nullptr))
+            {
+                lpMagazine->lpNext_ = nullptr;
+                lpMagazine->uSize_ = 0;
+            }
+            return lpMagazine;
+        }
+
+        static void FreeMagazine(Magazine *lpMagazine) { free(lpMagazine); }
+
+        static void FreeMagazineList(Magazine *lpMagazine)
+        {
+            while (lpMagazine != nullptr)
+            {
+                auto lpNext = lpMagazine->lpNext_;
+                FreeMagazine(lpMagazine);
+                lpMagazine = lpNext;
+            }
+        }
+
+        void PushFull(Magazine *lpMagazine)
+        {
+            lpMagazine->lpNext_ = m_lpFullMagazines;
+            m_lpFullMagazines = lpMagazine;
+            m_uFullMagazines++;
+        }
+
+        Magazine *PopFull()
+        {
+            auto lpMagazine = m_lpFullMagazines;
+            m_lpFullMagazines = lpMagazine->lpNext_;
+            m_uFullMagazines--;
+            return lpMagazine;
+        }
+
+        void PushEmpty(Magazine *lpMagazine)
+        {
+            lpMagazine->lpNext_ = m_lpEmptyMagazines;
+            m_lpEmptyMagazines = lpMagazine;
+        }
+
+        Magazine *PopEmpty()
+        {
+            auto lpMagazine = m_lpEmptyMagazines;
+            if (lpMagazine != nullptr)
+            {
+                m_lpEmptyMagazines = lpMagazine->lpNext_;
+                return lpMagazine;
+            }
+            return AllocMagazine();
+        }
+
+    private:
+        uint64_t m_uPoolId{0};
+        uint32_t m_uMagazineSize{0};
+        uint32_t m_uMaxFullMagazines{0};
+        uint32_t m_uFullMagazines{0};
+        Magazine *m_lpFullMagazines{nullptr};
+        Magazine *m_lpEmptyMagazines{nullptr};
+        ThreadCache *m_lpCaches{nullptr};
+        std::mutex m_lock; // 保护仓库、线程缓存链表和底层池
+        CObjectPool m_pool;
+    };
+
+} // end namespace utility
+
+#endif //__MAGAZINE_OBJECT_POOL_H
@@ -3,7 +3,13 @@
 
 #include <functional>
 #include <include/common.h>
+#include <utility/block_allocator.h>
+#include <utility/block_provisioner.h>
+#include <utility/level_bitmap.h>
+#include <utility/pool_stats.h>
+#include <utility/pool_trace.h>
 #include <utility/perf_profiler.h>
+#include <utility/perf_trace.h>
 
 #ifdef OS_WIN
 #include <intrin.h>
@@ -17,7 +23,35 @@ namespace utility
 
     constexpr uint16_t BlockObjectSize = 1024; // 要能被64整除！
     constexpr uint32_t BlockBitSize = BlockObjectSize / (sizeof(BitSetType) * 8);
+    static_assert(BlockBitSize <= 16, "uWordFree_ only has 16 bits");
     constexpr uint32_t MinBlockCount = 128;
+    constexpr uint32_t ReleaseBatchGroupSize = 16; // 批量释放时一次最多分组的块数
+    constexpr uint16_t ForeignObjIndex = 0xFFFF;   // ElemHead中标记非池对象的编号
+    constexpr uint32_t DefaultInitBlockCount = 0;
+
+    // CObjectPool的块大小按池配置，块内对象数量不再固定
+    constexpr uint32_t PoolMinBlockObjects = 8;
+    constexpr uint32_t PoolMaxBlockObjects = 4096; // uWordFree_为64位，最多64个位图字
+    constexpr uint32_t PoolInitRingSize = 16;
+    constexpr uint32_t DefaultFirstBlockBytes = 16 * 1024;
+    constexpr uint32_t DefaultBlockBytes = 256 * 1024;
+    constexpr uint32_t PoolCacheLineSize = 64;
+    constexpr uint32_t PoolMaxSlotAlign = 4096;
+    constexpr uint32_t PoolMaxColorCount = 64;
+
+    struct ObjectPoolOption
+    {
+        IBlockAllocator *lpBlockAllocator{nullptr};      // 块内存来源，为空时使用malloc
+        uint32_t uIdleHighWatermark{0};                  // 空闲块超过该值时自动Trim，0表示不自动回收
+        uint32_t uIdleLowWatermark{0};                   // 自动Trim后保留的空闲块数量，要小于高水位
+        uint32_t uInitBlockCount{DefaultInitBlockCount}; // Init时预先创建的块数量，0表示第一次Get时再创建
+        uint32_t uFirstBlockBytes{DefaultFirstBlockBytes}; // 第一个块的对象区大小，之后每次扩容翻倍
+        uint32_t uBlockBytes{DefaultBlockBytes};           // 块的对象区大小上限，翻倍到这里为止；分配器要求更大的块(如大页)时会提高
+        uint32_t uSlotAlign{0};  // 对象地址的对齐，2的幂，设为64或128时不同对象不会共享缓存行，0表示8字节对齐
+        uint32_t uColorCount{0}; // 块着色数量，第i个块的对象区整体后移(i % uColorCount)个缓存行，0和1表示不着色
+        uint32_t uSpareBlocks{0};                        // 后台线程预备的块数量，0表示扩容时在Get中同步申请
+        uint32_t uSpareLowWatermark{0};                  // 预备块降到该值时通知后台补满，要小于uSpareBlocks
+    };
 
     class CObjectPool
     {
@@ -39,57 +73,128 @@ namespace utility
 
         struct ObjectBlock
         {
-            uint16_t uCurrSize_;                  // 当前被使用的数量
-            uint8_t Reverse_[2];                   // padding
-            uint32_t uIndex_;                     // 当前块在pool中索引
-            BitSetType bitSetFree_[BlockBitSize]; // 被使用的置零，空闲的置1
-            uint8_t pData_[];
+            uint16_t uCurrSize_;       // 当前被使用的数量
+            uint16_t uCapacity_;       // 块内对象数量
+            uint32_t uIndex_;          // 当前块在pool中索引
+            uint32_t uDataOffset_;     // 对象区相对块头的偏移
+            uint32_t uColor_;          // 着色编号
+            uint64_t uWordFree_;       // 第i位表示bitSetFree_[i]还有空闲
+            CObjectPool *lpOwnerPool_; // 所属的池
+            BitSetType bitSetFree_[];  // 被使用的置零，空闲的置1，后面是对象区
+
+            static uint32_t GetWordCount(uint32_t uCapacity) { return (uCapacity + 63) >> BitSetScale; }
+
+            static size_t GetAllocSize(uint32_t uCapacity, uint32_t uObjSize)
+            {
+                return sizeof(ObjectBlock) + sizeof(BitSetType) * GetWordCount(uCapacity) + (size_t)uObjSize * uCapacity;
+            }
+
+            uint8_t *GetData() { return (uint8_t *)this + uDataOffset_; }
 
+            // 确定对象区的位置：第一个对象按uSlotAlign对齐，再后移uColor个缓存行。
+            // 块的首地址只保证8字节对齐，需要的余量由池在申请块时预留
+            void Layout(uint32_t uCapacity, uint32_t uSlotAlign, uint32_t uColor)
+            {
+                uCapacity_ = (uint16_t)uCapacity;
+                uColor_ = uColor;
+                auto uBase = (uintptr_t)(bitSetFree_ + GetWordCount(uCapacity)) + sizeof(ElemHead);
+                auto uFirst = ((uBase + uSlotAlign - 1) & ~(uintptr_t)(uSlotAlign - 1)) + uColor * PoolCacheLineSize;
+                uDataOffset_ = (uint32_t)(uFirst - sizeof(ElemHead) - (uintptr_t)this);
+            }
+
+            // uCapacity_需要先设置好
             void Reset(uint32_t _uIndex)
             {
+                auto uWords = GetWordCount(uCapacity_);
                 uCurrSize_ = 0;
-                Reverse_[0] = 0x7F;
-                Reverse_[1] = 0x7F;
                 uIndex_ = _uIndex;
-                memset(bitSetFree_, 0XFF, sizeof(bitSetFree_));
+                memset(bitSetFree_, 0XFF, uWords * sizeof(BitSetType));
+                // 最后一个字里超出对象数量的位不能被分配
+                if ((uCapacity_ & 63) != 0)
+                {
+                    bitSetFree_[uWords - 1] = (BitSetType(1) << (uCapacity_ & 63)) - 1;
+                }
+                uWordFree_ = uWords == 64 ? ~uint64_t(0) : (uint64_t(1) << uWords) - 1;
             }
 
+            // 重新定位到新的槽位，块内状态保持不变
+            void Move(uint32_t _uIndex) { uIndex_ = _uIndex; }
+
             // 块内元素被全部耗尽
-            bool IsEmpty() { return uCurrSize_ == BlockObjectSize; }
+            bool IsEmpty() { return uCurrSize_ == uCapacity_; }
             // 块内元素未被使用
             bool IsReFill() { return uCurrSize_ == 0; }
             uint32_t GetCurrSize() { return uCurrSize_; }
 
+            // 先用uWordFree_定位到有空闲的字，再在字内定位，两次ctz
             ElemHead *GetObject(uint32_t uObjSize)
             {
-                for (uint32_t i = 0; i < BlockBitSize; i++)
+                if (unlikely(uWordFree_ == 0))
                 {
-                    if (bitSetFree_[i] != 0)
+                    return nullptr;
+                }
+
+                unsigned long i = 0;
+                unsigned long idx = 0;
+#ifdef _WIN32
+                _BitScanForward64(&i, uWordFree_);
+                _BitScanForward64(&idx, bitSetFree_[i]);
+#else
+                i = __builtin_ctzll(uWordFree_);
+                idx = __builtin_ctzll(bitSetFree_[i]);
+#endif
+                bitSetFree_[i] &= bitSetFree_[i] - 1;
+                if (bitSetFree_[i] == 0)
+                {
+                    uWordFree_ &= ~(uint64_t(1) << i);
+                }
+                uCurrSize_++;
+                uint16_t uObjIdx = (i << BitSetScale) + idx;
+                auto lpElemHead = (ElemHead *)&GetData()[(size_t)uObjIdx * uObjSize];
+                lpElemHead->Reset(uObjIdx, (uint64_t)this);
+                return lpElemHead;
+            }
+
+            // 批量取出最多uCount个对象，每个位图字用一次ctz循环取尽
+            uint32_t GetObjects(uint32_t uObjSize, void **lppObjs, uint32_t uCount)
+            {
+                uint32_t uGot = 0;
+                auto pData = GetData();
+                while (uWordFree_ != 0 && uGot < uCount)
+                {
+                    uint32_t i = __builtin_ctzll(uWordFree_);
+                    auto bits = bitSetFree_[i];
+                    while (bits != 0 && uGot < uCount)
                     {
                         unsigned long idx = 0;
 #ifdef _WIN32
-                        _BitScanForward64(&idx, bitSetFree_[i]);
+                        _BitScanForward64(&idx, bits);
 #else
-                        idx = __builtin_ctzll(bitSetFree_[i]);
+                        idx = __builtin_ctzll(bits);
 #endif
-                        bitSetFree_[i] &= ~(BitSetType(1) << idx);
-                        uCurrSize_++;
+                        bits &= bits - 1;
                         uint16_t uObjIdx = (i << BitSetScale) + idx;
-                        auto lpElemHead = (ElemHead *)&pData_[uObjIdx * uObjSize];
+                        auto lpElemHead = (ElemHead *)&pData[(size_t)uObjIdx * uObjSize];
                         lpElemHead->Reset(uObjIdx, (uint64_t)this);
-                        return lpElemHead;
+                        lppObjs[uGot++] = lpElemHead->pData_;
+                    }
+                    bitSetFree_[i] = bits;
+                    if (bits == 0)
+                    {
+                        uWordFree_ &= ~(uint64_t(1) << i);
                     }
                 }
-
-                return nullptr;
+                uCurrSize_ += uGot;
+                return uGot;
             }
 
             void ReleaseObject(ElemHead *lpElemHead)
             {
                 auto ObjIndex_ = lpElemHead->GetObjIndex();
                 auto bitSetIndex = ObjIndex_ >> BitSetScale;
-                auto bitIndex = ObjIndex_ & 0x0F;
-                bitSetFree_[bitSetIndex] |= (1 << bitIndex);
+                auto bitIndex = ObjIndex_ & ((1 << BitSetScale) - 1);
+                bitSetFree_[bitSetIndex] |= (BitSetType(1) << bitIndex);
+                uWordFree_ |= (uint64_t(1) << bitSetIndex);
                 uCurrSize_--;
             }
         };
@@ -98,22 +203,54 @@ namespace utility
         CObjectPool() = default;
         ~CObjectPool() = default;
 
-        int32_t Init(uint32_t uObjectSize, std::function<void(void*)> funcConstruct = nullptr)
+        int32_t Init(uint32_t uObjectSize, std::function<void(void*)> funcConstruct = nullptr,
+                     const ObjectPoolOption &option = ObjectPoolOption())
         {
             UnInit();
 
             m_funcConstruct = funcConstruct;
+            if (option.uIdleHighWatermark != 0 && option.uIdleLowWatermark >= option.uIdleHighWatermark)
+            {
+                return 1;
+            }
+            m_uIdleHighWatermark = option.uIdleHighWatermark;
+            m_uIdleLowWatermark = option.uIdleLowWatermark;
+            m_lpBlockAllocator = option.lpBlockAllocator;
+            if (m_lpBlockAllocator == nullptr)
+            {
+                m_lpBlockAllocator = CMallocBlockAllocator::GetInstance();
+            }
 
-            m_lppBlocks = (ObjectBlock **)calloc(MinBlockCount, sizeof(ObjectBlock *));
-            if (m_lppBlocks == nullptr)
+            if (option.uFirstBlockBytes == 0 || option.uFirstBlockBytes > option.uBlockBytes)
+            {
+                return 1;
+            }
+            m_uSlotAlign = option.uSlotAlign < 8 ? 8 : option.uSlotAlign;
+            m_uColorCount = option.uColorCount == 0 ? 1 : option.uColorCount;
+            if ((m_uSlotAlign & (m_uSlotAlign - 1)) != 0 || m_uSlotAlign > PoolMaxSlotAlign ||
+                m_uColorCount > PoolMaxColorCount)
             {
                 return 1;
             }
+            // 对齐和着色需要的最大偏移
+            m_uBlockSlack = (m_uSlotAlign - 8) + (m_uColorCount - 1) * PoolCacheLineSize;
+            m_uNextColor = 0;
 
-            m_uObjectSize = sizeof(ElemHead) + ALIGN8(uObjectSize);
-            m_uCapSize = MinBlockCount;
+            m_lppBlocks = (ObjectBlock **)calloc(PoolInitRingSize, sizeof(ObjectBlock *));
+            if (m_lppBlocks == nullptr || m_bitmapFree.Init(PoolInitRingSize) != 0)
+            {
+                return 1;
+            }
+
+            // 槽位大小取对齐的整数倍，每个对象的地址都是对齐的
+            m_uObjectSize = (sizeof(ElemHead) + ALIGN8(uObjectSize) + m_uSlotAlign - 1) & ~(m_uSlotAlign - 1);
+            m_uCapSize = PoolInitRingSize;
+            // 小块起步按需翻倍，大对象的池启动时不会一次提交很多内存，小对象的池也能很快用上大块
+            m_uMaxBlockObjects = GetBlockObjects(option.uBlockBytes, m_uObjectSize);
+            m_uNextBlockObjects = GetBlockObjects(option.uFirstBlockBytes, m_uObjectSize);
+            ApplyPreferredBlockSize();
 
-            for (uint32_t i = 0; i < 16; i++)
+            for (uint32_t i = 0; i < option.uInitBlockCount; i++)
             {
                 if (Expand() == nullptr)
                 {
@@ -121,64 +258,116 @@ namespace utility
                 }
             }
 
+            if (option.uSpareBlocks != 0)
+            {
+                // 构造函数在后台线程中执行，要求线程安全；预备块总是按最大块准备，着色在后台线程中轮转
+                auto uCapacity = m_uMaxBlockObjects;
+                auto uSlotAlign = m_uSlotAlign;
+                auto uColorCount = m_uColorCount;
+                auto uObjectSize = m_uObjectSize;
+                auto funcConstruct = m_funcConstruct;
+                uint32_t uColor = 0;
+                std::function<void(void *)> funcPrepare = [=](void *ptr) mutable {
+                    ConstructBlock((ObjectBlock *)ptr, uCapacity, uSlotAlign, uColor, uObjectSize, funcConstruct);
+                    uColor = (uColor + 1) % uColorCount;
+                };
+                m_lpProvisioner = new (std::nothrow) CBlockProvisioner();
+                if (m_lpProvisioner == nullptr ||
+                    m_lpProvisioner->Init(m_lpBlockAllocator, GetBlockAllocSize(m_uMaxBlockObjects),
+                                          m_funcConstruct == nullptr,
+                                          option.uSpareBlocks, option.uSpareLowWatermark, funcPrepare) != 0)
+                {
+                    return 1;
+                }
+            }
+
             return 0;
         }
 
         void UnInit()
         {
+            // 先停后台线程，再释放块
+            delete m_lpProvisioner;
+            m_lpProvisioner = nullptr;
             if (m_lppBlocks != nullptr)
             {
                 for (uint32_t i = 0; i < m_uCapSize; i++)
                 {
                     if (m_lppBlocks[i] != nullptr)
                     {
-                        free(m_lppBlocks[i]);
+                        FreeBlock(m_lppBlocks[i]);
                     }
                 }
                 free(m_lppBlocks);
+                m_lppBlocks = nullptr;
             }
+            m_bitmapFree.UnInit();
+            m_uCurrIndex = 0;
+            m_uCurrSize = 0;
+            m_uIdleBlocks = 0;
+            m_uFront = 0;
+            m_uRear = 0;
+            m_uCapSize = 0;
+            m_uMemorySize = 0;
+            POOL_STATS(m_stats.Reset());
         }
 
         void *Get()
         {
-            // 向后找下一个可用的块，预期只有两次循环，curr和next
-            for (uint32_t i = m_uCurrIndex; i != m_uRear; i = GetNext(i))
+            auto lpBlock = m_lppBlocks[m_uCurrIndex];
+            if (unlikely(lpBlock == nullptr || lpBlock->IsEmpty()))
             {
-                if (likely(m_lppBlocks[i] != nullptr && !m_lppBlocks[i]->IsEmpty()))
-                {
-                    // 有上面两个判断，必定是成功，否则是程序异常
-                    auto lpElemHead = m_lppBlocks[i]->GetObject(m_uObjectSize);
-                    m_uCurrIndex = i;
-                    return lpElemHead->pData_;
-                }
+                lpBlock = FindFreeBlock();
             }
-
-            // 向前找一个可用
-            auto end = GetPrev(m_uFront);
-            for (uint32_t i = m_uCurrIndex; i != end; i = GetPrev(i))
+            if (likely(lpBlock != nullptr))
             {
-                if (likely(m_lppBlocks[i] != nullptr && !m_lppBlocks[i]->IsEmpty()))
+                // FindFreeBlock返回的块必定有空位，否则是程序异常
+                if (unlikely(lpBlock->IsReFill()))
                 {
-                    // 有上面两个判断，必定是成功，否则是程序异常
-                    auto lpElemHead = m_lppBlocks[i]->GetObject(m_uObjectSize);
-                    m_uCurrIndex = i;
-                    return lpElemHead->pData_;
+                    m_uIdleBlocks--;
                 }
-            }
-
-            // 扩容
-            auto lpBlock = Expand();
-            if (likely(lpBlock != nullptr))
-            {
-                m_uCurrIndex = lpBlock->uIndex_;
                 auto lpElemHead = lpBlock->GetObject(m_uObjectSize);
+                if (unlikely(lpBlock->IsEmpty()))
+                {
+                    m_bitmapFree.Clear(lpBlock->uIndex_);
+                }
+                POOL_STATS(m_stats.OnGet(1));
+                POOL_TRACE(CPoolTrace::OnGet(lpElemHead->pData_, GetObjectSize()));
                 return lpElemHead->pData_;
             }
 
             // 内存申请不出来
+            POOL_STATS(m_stats.OnGetFail());
             return nullptr;
         }
 
+        // 批量申请，返回实际申请到的数量，只有内存不足时才会少于uCount
+        uint32_t GetBatch(uint32_t uCount, void **lppObjs)
+        {
+            uint32_t uGot = 0;
+            while (uGot < uCount)
+            {
+                auto lpBlock = FindFreeBlock();
+                if (unlikely(lpBlock == nullptr))
+                {
+                    POOL_STATS(m_stats.OnGetFail());
+                    break;
+                }
+                if (lpBlock->IsReFill())
+                {
+                    m_uIdleBlocks--;
+                }
+                uGot += lpBlock->GetObjects(m_uObjectSize, lppObjs + uGot, uCount - uGot);
+                if (lpBlock->IsEmpty())
+                {
+                    m_bitmapFree.Clear(lpBlock->uIndex_);
+                }
+            }
+            POOL_STATS(m_stats.OnGet(uGot));
+            POOL_TRACE(for (uint32_t i = 0; i < uGot; i++) { CPoolTrace::OnGet(lppObjs[i], GetObjectSize()); });
+            return uGot;
+        }
+
         void Release(void *ptr)
         {
             if (unlikely(ptr == nullptr))
@@ -186,21 +375,224 @@ namespace utility
                 return;
             }
 
+            POOL_TRACE(CPoolTrace::OnRelease(ptr, GetObjectSize()));
             auto lpElemHead = (ElemHead *)((uint8_t *)ptr - sizeof(ElemHead));
             auto lpOwnerBlock = (ObjectBlock *)lpElemHead->GetOwnerBlockPtr();
+            ReleaseToBlock(lpOwnerBlock, lpElemHead);
+            RecycleBlock(lpOwnerBlock);
+            AutoTrim();
+            POOL_STATS(m_stats.OnRelease(1));
+        }
+
+        // 批量释放，按所属块分组，每个块只做一次回收检查
+        void ReleaseBatch(void **lppObjs, uint32_t uCount)
+        {
+            ObjectBlock *lppTouched[ReleaseBatchGroupSize];
+            uint32_t uTouched = 0;
+            ObjectBlock *lpLastBlock = nullptr;
+            for (uint32_t i = 0; i < uCount; i++)
+            {
+                if (unlikely(lppObjs[i] == nullptr))
+                {
+                    continue;
+                }
+
+                POOL_TRACE(CPoolTrace::OnRelease(lppObjs[i], GetObjectSize()));
+                auto lpElemHead = (ElemHead *)((uint8_t *)lppObjs[i] - sizeof(ElemHead));
+                auto lpOwnerBlock = (ObjectBlock *)lpElemHead->GetOwnerBlockPtr();
+                ReleaseToBlock(lpOwnerBlock, lpElemHead);
+                POOL_STATS(m_stats.OnRelease(1));
+                if (likely(lpOwnerBlock == lpLastBlock))
+                {
+                    continue;
+                }
+
+                lpLastBlock = lpOwnerBlock;
+                uint32_t j = 0;
+                while (j < uTouched && lppTouched[j] != lpOwnerBlock)
+                {
+                    j++;
+                }
+                if (j < uTouched)
+                {
+                    continue;
+                }
+
+                // 分组表满了，先回收已记录的块
+                if (unlikely(uTouched == ReleaseBatchGroupSize))
+                {
+                    for (j = 0; j < uTouched; j++)
+                    {
+                        RecycleBlock(lppTouched[j]);
+                    }
+                    uTouched = 0;
+                }
+                lppTouched[uTouched++] = lpOwnerBlock;
+            }
+
+            for (uint32_t j = 0; j < uTouched; j++)
+            {
+                RecycleBlock(lppTouched[j]);
+            }
+            // 分组表里的块可能被Trim释放，所以放到最后
+            AutoTrim();
+        }
+
+        // 释放多余的空闲块，最多保留uKeepIdle个，当前块不释放，返回释放的块数
+        uint32_t Trim(uint32_t uKeepIdle = 0)
+        {
+            // 没有Init或已经UnInit
+            if (m_lppBlocks == nullptr)
+            {
+                return 0;
+            }
+
+            uint32_t uFreed = 0;
+            for (uint32_t i = m_uFront; m_uIdleBlocks > uKeepIdle; i = GetNext(i))
+            {
+                auto lpBlock = m_lppBlocks[i];
+                if (lpBlock != nullptr && lpBlock->IsReFill() && i != m_uCurrIndex)
+                {
+                    m_lppBlocks[i] = nullptr;
+                    m_bitmapFree.Clear(i);
+                    FreeBlock(lpBlock);
+                    m_uIdleBlocks--;
+                    m_uCurrSize--;
+                    uFreed++;
+                    POOL_STATS(m_stats.OnEvent(PoolEventTrim, m_uCurrSize));
+                }
+                if (GetNext(i) == m_uRear)
+                {
+                    break;
+                }
+            }
+
+            // 收缩搜索范围
+            while (m_lppBlocks[m_uFront] == nullptr && m_uFront != m_uCurrIndex)
+            {
+                m_uFront = GetNext(m_uFront);
+            }
+            return uFreed;
+        }
+
+        uint32_t GetBlockCount() { return m_uCurrSize; }
+        uint32_t GetIdleBlockCount() { return m_uIdleBlocks; }
+        // 当前持有的块占用的字节数，不含后台预备块
+        uint64_t GetMemorySize() { return m_uMemorySize; }
+        // 下一次扩容的块能放的对象数量
+        uint32_t GetNextBlockObjects() { return m_uNextBlockObjects; }
+
+        // 由对象指针找到所属的池，ptr必须来自某个CObjectPool::Get且没有被MarkForeignObject标记
+        // 块里记录的是Init时池的地址，池在Init之后不能再被拷贝或移动
+        static CObjectPool *GetOwnerPool(void *ptr)
+        {
+            auto lpElemHead = (ElemHead *)((uint8_t *)ptr - sizeof(ElemHead));
+            return ((ObjectBlock *)lpElemHead->GetOwnerBlockPtr())->lpOwnerPool_;
+        }
+
+        // 池外分配的内存可以在ptr前预留一个ElemHead，标记后与池对象用同一种方式识别
+        // uTag只保留低48位
+        static void MarkForeignObject(void *ptr, uint64_t uTag)
+        {
+            auto lpElemHead = (ElemHead *)((uint8_t *)ptr - sizeof(ElemHead));
+            lpElemHead->Reset(ForeignObjIndex, uTag);
+        }
+
+        static bool IsForeignObject(void *ptr)
+        {
+            auto lpElemHead = (ElemHead *)((uint8_t *)ptr - sizeof(ElemHead));
+            return lpElemHead->GetObjIndex() == ForeignObjIndex;
+        }
+
+        static uint64_t GetForeignTag(void *ptr)
+        {
+            auto lpElemHead = (ElemHead *)((uint8_t *)ptr - sizeof(ElemHead));
+            return lpElemHead->pOwnerBlock_;
+        }
+
+        uint32_t GetObjectSize() { return m_uObjectSize - sizeof(ElemHead); }
+
+        // 编译时没有定义OBJECT_POOL_STATS时返回1
+        int32_t GetStats(PoolStatsSnapshot &snapshot)
+        {
+#ifdef OBJECT_POOL_STATS
+            m_stats.Fill(snapshot);
+            snapshot.uObjectSize_ = GetObjectSize();
+            snapshot.uBlocks_ = m_uCurrSize;
+            snapshot.uIdleBlocks_ = m_uIdleBlocks;
+            snapshot.uCapSize_ = m_uCapSize;
+            return 0;
+#else
+            (void)snapshot;
+            return 1;
+#endif
+        }
+
+    private:
+        // 找一个有空位的块，必要时扩容，并把它设为当前块
+        ObjectBlock *FindFreeBlock()
+        {
+            // 从当前位置向后找下一个未满的块，到队尾后绕回，只需几次ctz
+            auto uIndex = m_bitmapFree.FindNext(m_uCurrIndex);
+            if (likely(uIndex != CLevelBitmap::NotFound))
+            {
+                POOL_STATS(m_stats.OnScan((uIndex + m_uCapSize - m_uCurrIndex) % m_uCapSize));
+                m_uCurrIndex = uIndex;
+                return m_lppBlocks[uIndex];
+            }
+
+            // 扩容，相当于走完了整个环
+            POOL_STATS(m_stats.OnScan(m_uCapSize));
+            auto lpBlock = Expand();
+            if (likely(lpBlock != nullptr))
+            {
+                m_uCurrIndex = lpBlock->uIndex_;
+            }
+            return lpBlock;
+        }
+
+        // 满块释放出空位时重新标记为可用
+        void ReleaseToBlock(ObjectBlock *lpOwnerBlock, ElemHead *lpElemHead)
+        {
+            auto bWasFull = lpOwnerBlock->IsEmpty();
             lpOwnerBlock->ReleaseObject(lpElemHead);
+            if (unlikely(bWasFull))
+            {
+                m_bitmapFree.Set(lpOwnerBlock->uIndex_);
+            }
+        }
+
+        // 空闲块超过高水位时回收到低水位，两者之间的间隔避免在释放和扩容之间来回抖动
+        void AutoTrim()
+        {
+            if (unlikely(m_uIdleHighWatermark != 0 && m_uIdleBlocks > m_uIdleHighWatermark))
+            {
+                Trim(m_uIdleLowWatermark);
+            }
+        }
+
+        // 块内对象全部归还后，把它移到队尾重新使用
+        void RecycleBlock(ObjectBlock *lpOwnerBlock)
+        {
+            if (unlikely(lpOwnerBlock->IsReFill()))
+            {
+                m_uIdleBlocks++;
+            }
             if (unlikely(lpOwnerBlock->IsReFill() && lpOwnerBlock->uIndex_ != m_uCurrIndex))
             {
                 m_lppBlocks[lpOwnerBlock->uIndex_] = nullptr;
+                m_bitmapFree.Clear(lpOwnerBlock->uIndex_);
                 // 存在有人长期不释放内存，那就要整理内存
                 if (unlikely(m_uRear == m_uFront))
                 {
-                    CompactFrontBlock(); // m_uFront至少前进一格，因为当前要释放的块位置置空了
+                    CompactFrontBlock(); // 当前要释放的块位置置空了，整理后队尾至少空出一格
                 }
 
                 lpOwnerBlock->Reset(m_uRear);
                 m_lppBlocks[m_uRear] = lpOwnerBlock;
+                m_bitmapFree.Set(m_uRear);
                 m_uRear = GetNext(m_uRear);
+                POOL_STATS(m_stats.OnEvent(PoolEventRecycle, m_uCurrSize));
                 // 提前调整范围，减少get的搜索范围
                 while (m_lppBlocks[m_uFront] == nullptr && m_uFront != m_uCurrIndex)
                 {
@@ -209,57 +601,116 @@ namespace utility
             }
         }
 
-    private:
         uint32_t GetNext(uint32_t uIndex) { return (uIndex + 1) % m_uCapSize; }
         uint32_t GetPrev(uint32_t uIndex) { return (uIndex + m_uCapSize - 1) % m_uCapSize; }
 
-        // 整理用过的内存块
+        // 环首尾相接时整理用过的内存块：按环的顺序把所有块紧凑到front开始的位置，空槽位集中到队尾
+        // 块内可能还有对象，只移动不重置；调用方保证环中至少有一个空槽位
         void CompactFrontBlock()
         {
-            auto begin = GetPrev(m_uCurrIndex);
-            auto end = GetPrev(m_uFront);
-            auto slow = m_uCurrIndex;
-            // 遍历 [front, curr) 范围，收缩所有非null的块
-            for (uint32_t fast = begin; fast != end; fast = GetPrev(fast))
+            auto slow = m_uFront;
+            auto fast = m_uFront;
+            for (uint32_t n = 0; n < m_uCapSize; n++, fast = GetNext(fast))
             {
                 auto lpCurBlock = m_lppBlocks[fast];
-                if (lpCurBlock != nullptr && slow != fast)
+                if (lpCurBlock == nullptr)
                 {
-                    slow = GetPrev(slow);
-                    lpCurBlock->Reset(slow);
+                    continue;
+                }
+
+                if (slow != fast)
+                {
+                    lpCurBlock->Move(slow);
                     m_lppBlocks[slow] = lpCurBlock;
                     m_lppBlocks[fast] = nullptr;
+                    m_bitmapFree.Clear(fast);
+                    if (!lpCurBlock->IsEmpty())
+                    {
+                        m_bitmapFree.Set(slow);
+                    }
+                    if (fast == m_uCurrIndex)
+                    {
+                        m_uCurrIndex = slow;
+                    }
                 }
+                slow = GetNext(slow);
             }
-            m_uFront = slow;
+            m_uRear = slow;
+            POOL_STATS(m_stats.OnEvent(PoolEventCompact, m_uCurrSize));
         }
 
-        void WarnUp(void *ptr, uint32_t uSize)
+        // 对象区能放下的对象数量，限制在[PoolMinBlockObjects, PoolMaxBlockObjects]之间
+        static uint32_t GetBlockObjects(uint32_t uBytes, uint32_t uObjectSize)
         {
-            uint32_t uPageSize = 0;
-#ifdef OS_WIN
-            SYSTEM_INFO si;
-            GetSystemInfo(&si);
-            uPageSize = (uint32_t)si.dwPageSize;
-#else
-            uPageSize = (uint32_t)sysconf(_SC_PAGESIZE);
-#endif
-            auto addr = (uint8_t *)ptr;
-            for (uint32_t offset = 0; offset < uSize; offset += uPageSize)
+            auto uObjects = uBytes / uObjectSize;
+            if (uObjects < PoolMinBlockObjects)
             {
-                addr[offset] = 0x00;
+                return PoolMinBlockObjects;
             }
-            addr[uSize - 1] = 0x00;
+            return uObjects > PoolMaxBlockObjects ? PoolMaxBlockObjects : uObjects;
+        }
+
+        static void ConstructBlock(ObjectBlock *lpBlock, uint32_t uCapacity, uint32_t uSlotAlign, uint32_t uColor,
+                                   uint32_t uObjectSize, const std::function<void(void *)> &funcConstruct)
+        {
+            lpBlock->Layout(uCapacity, uSlotAlign, uColor);
+            if (funcConstruct != nullptr)
+            {
+                auto pData = lpBlock->GetData();
+                for (uint32_t i = 0; i < uCapacity; i++)
+                {
+                    auto ptr = (ElemHead *)&pData[(size_t)i * uObjectSize];
+                    funcConstruct(ptr->pData_);
+                }
+            }
+        }
+
+        size_t GetBlockAllocSize(uint32_t uCapacity)
+        {
+            auto uSize = ObjectBlock::GetAllocSize(uCapacity, m_uObjectSize) + m_uBlockSlack;
+            return uCapacity == m_uMaxBlockObjects && uSize < m_uMaxBlockAllocSize ? m_uMaxBlockAllocSize : uSize;
+        }
+
+        // 最大的块比分配器偏好的大小(如大页)小时，增加对象数直到再放一个就超过偏好大小，
+        // 块按偏好大小申请，尾部不到一个槽位的空间不用。对象数到PoolMaxBlockObjects还凑不满时保持原样
+        void ApplyPreferredBlockSize()
+        {
+            m_uMaxBlockAllocSize = 0;
+            auto uPreferred = m_lpBlockAllocator->GetPreferredBlockSize();
+            if (uPreferred == 0 || GetBlockAllocSize(m_uMaxBlockObjects) >= uPreferred)
+            {
+                return;
+            }
+            auto uObjects = m_uMaxBlockObjects;
+            while (uObjects < PoolMaxBlockObjects && GetBlockAllocSize(uObjects + 1) <= uPreferred)
+            {
+                uObjects++;
+            }
+            if (GetBlockAllocSize(uObjects) + m_uObjectSize > uPreferred)
+            {
+                m_uMaxBlockObjects = uObjects;
+                m_uMaxBlockAllocSize = uPreferred;
+            }
+        }
+
+        void FreeBlock(ObjectBlock *lpBlock)
+        {
+            auto uSize = GetBlockAllocSize(lpBlock->uCapacity_);
+            m_lpBlockAllocator->Free(lpBlock, uSize);
+            m_uMemorySize -= uSize;
         }
 
         ObjectBlock *Expand()
         {
+            POOL_TIMELINE_SCOPE("CObjectPool::Expand");
             if (unlikely(m_uCurrSize == m_uCapSize))
             {
                 auto uNewCap = m_uCapSize * 2;
                 auto lppTmpBlocks = (ObjectBlock **)calloc(uNewCap, sizeof(ObjectBlock *));
-                if (unlikely(lppTmpBlocks == nullptr))
+                CLevelBitmap bitmapTmp;
+                if (unlikely(lppTmpBlocks == nullptr || bitmapTmp.Init(uNewCap) != 0))
                 {
+                    free(lppTmpBlocks);
                     return nullptr;
                 }
 
@@ -268,59 +719,92 @@ namespace utility
                 {
                     if (m_lppBlocks[i] != nullptr)
                     {
-                        m_lppBlocks[i]->uIndex_ = uNewRear;
+                        m_lppBlocks[i]->Move(uNewRear);
+                        if (!m_lppBlocks[i]->IsEmpty())
+                        {
+                            bitmapTmp.Set(uNewRear);
+                        }
                         lppTmpBlocks[uNewRear++] = m_lppBlocks[i];
                     }
                 }
 
+                free(m_lppBlocks);
+                m_bitmapFree.UnInit();
                 m_lppBlocks = lppTmpBlocks;
+                m_bitmapFree = bitmapTmp;
                 m_uCapSize = uNewCap;
                 m_uFront = 0;
                 m_uRear = uNewRear;
                 m_uCurrIndex = 0;
             }
 
-            if (unlikely(m_uRear == m_uFront))
+            if (unlikely(m_uRear == m_uFront && m_uCurrSize != 0))
             {
-                CompactFrontBlock(); // 这里一定可以整理出空位，因为槽位没满，所有可以进行下一步
+                CompactFrontBlock(); // 这里一定可以整理出空位，因为槽位没满，所以可以进行下一步
             }
 
-            uint32_t uBlockSize = sizeof(ObjectBlock) + m_uObjectSize * BlockObjectSize;
-            auto lpNewBlock = (ObjectBlock *)malloc(uBlockSize);
-            if (unlikely(lpNewBlock == nullptr))
+            // 优先使用后台准备好的块，没有时才同步申请
+            ObjectBlock *lpNewBlock = nullptr;
+            uint32_t uCapacity = m_uMaxBlockObjects;
+            if (m_lpProvisioner != nullptr)
             {
-                return nullptr;
+                lpNewBlock = (ObjectBlock *)m_lpProvisioner->TakeBlock();
             }
-
-            if (m_funcConstruct != nullptr)
+            if (lpNewBlock == nullptr)
             {
-                for (uint32_t i = 0; i < BlockObjectSize; i++)
+                uCapacity = m_uNextBlockObjects;
+                // 有构造函数时构造过程本身会触发缺页，无需预热
+                lpNewBlock = (ObjectBlock *)m_lpBlockAllocator->Alloc(GetBlockAllocSize(uCapacity), m_funcConstruct == nullptr);
+                if (unlikely(lpNewBlock == nullptr))
                 {
-                    auto ptr = (ElemHead *)&lpNewBlock->pData_[i + m_uObjectSize];
-                    m_funcConstruct(ptr->pData_);
+                    return nullptr;
                 }
+                ConstructBlock(lpNewBlock, uCapacity, m_uSlotAlign, m_uNextColor, m_uObjectSize, m_funcConstruct);
+                m_uNextColor = (m_uNextColor + 1) % m_uColorCount;
             }
-            else
+            if (m_uNextBlockObjects < m_uMaxBlockObjects)
             {
-                WarnUp(lpNewBlock, uBlockSize);
+                m_uNextBlockObjects = uCapacity * 2 < m_uMaxBlockObjects ? uCapacity * 2 : m_uMaxBlockObjects;
             }
+            m_uMemorySize += GetBlockAllocSize(uCapacity);
 
             lpNewBlock->Reset(m_uRear);
+            lpNewBlock->lpOwnerPool_ = this;
             m_lppBlocks[m_uRear] = lpNewBlock;
+            m_bitmapFree.Set(m_uRear);
             m_uRear = GetNext(m_uRear);
             m_uCurrSize++;
+            m_uIdleBlocks++;
+            POOL_STATS(m_stats.OnEvent(PoolEventExpand, m_uCurrSize));
             return lpNewBlock;
         }
 
     private:
         uint32_t m_uObjectSize{0};
+        uint32_t m_uMaxBlockObjects{0};
+        uint32_t m_uNextBlockObjects{0};
+        size_t m_uMaxBlockAllocSize{0}; // 最大的块按这个大小申请，0表示按实际大小
+        uint32_t m_uSlotAlign{8};
+        uint32_t m_uColorCount{1};
+        uint32_t m_uNextColor{0};
+        uint32_t m_uBlockSlack{0}; // 块尾为对齐和着色预留的字节数
+        uint64_t m_uMemorySize{0};
         uint32_t m_uCurrIndex{0};
-        uint32_t m_uCurrSize{0};
+        uint32_t m_uCurrSize{0};   // 环中块的数量
+        uint32_t m_uIdleBlocks{0}; // 没有对象被使用的块数量
+        uint32_t m_uIdleHighWatermark{0};
+        uint32_t m_uIdleLowWatermark{0};
         uint32_t m_uFront{0};
         uint32_t m_uRear{0};
         uint32_t m_uCapSize{0};
         ObjectBlock **m_lppBlocks{nullptr};
+        CLevelBitmap m_bitmapFree; // 第i位表示m_lppBlocks[i]是未满的块
         std::function<void(void*)> m_funcConstruct;
+        IBlockAllocator *m_lpBlockAllocator{nullptr};
+        CBlockProvisioner *m_lpProvisioner{nullptr};
+#ifdef OBJECT_POOL_STATS
+        CPoolStats m_stats;
+#endif
     };
 
 } // end namespace utilitiy
@@ -0,0 +1,375 @@
+#ifndef __PERCPU_OBJECT_POOL_H
+#define __PERCPU_OBJECT_POOL_H
+
+#include <mutex>
+#include <sched.h>
+#include <utility/object_pool.h>
+
+// glibc 2.35以后会为每个线程注册rseq，x86-64上直接用它的rseq区域
+#if defined(OS_LINUX) && defined(__x86_64__) && defined(__has_include)
+#if __has_include(<sys/rseq.h>)
+#include <sys/rseq.h>
+#ifdef RSEQ_SIG
+#define PERCPU_POOL_RSEQ
+#endif
+#endif
+#endif
+
+namespace utility
+{
+
+    constexpr uint32_t DefaultPerCpuCacheSize = 128;
+    constexpr uint32_t MaxPerCpuCacheSize = 4096;
+    constexpr uint32_t PerCpuCacheAlign = 64;
+
+    // 按CPU分片的多线程对象池：每个CPU一个对象缓存，缓存总量只与核数有关，与线程数无关。
+    // 支持rseq时，快速路径在rseq临界区内读写当前CPU的缓存，没有原子操作也没有锁，
+    // 被抢占、迁移或者收到信号时内核把执行流转到abort，退回加锁的共享池；
+    // 不支持rseq时用sched_getcpu选分片，每个分片一把锁，基本不会有竞争
+    class CPerCpuObjectPool
+    {
+        struct CpuCache
+        {
+            uint64_t uCount_;
+            std::mutex lock_; // 只在不支持rseq时使用
+            void *lppObjs_[];
+        };
+
+        enum CacheResult
+        {
+            CacheOk = 0,
+            CacheMiss = 1,  // 缓存空了(Get)或满了(Release)
+            CacheAbort = 2, // rseq临界区被中断
+        };
+
+    public:
+        CPerCpuObjectPool() = default;
+        ~CPerCpuObjectPool() { UnInit(); }
+        CPerCpuObjectPool(const CPerCpuObjectPool &) = delete;
+        CPerCpuObjectPool &operator=(const CPerCpuObjectPool &) = delete;
+
+        int32_t Init(uint32_t uObjectSize, uint32_t uCacheSize = DefaultPerCpuCacheSize,
+                     std::function<void(void *)> funcConstruct = nullptr,
+                     const ObjectPoolOption &option = ObjectPoolOption())
+        {
+            UnInit();
+
+            if (uCacheSize < 2 || uCacheSize > MaxPerCpuCacheSize)
+            {
+                return 1;
+            }
+
+            auto iCpuCount = sysconf(_SC_NPROCESSORS_CONF);
+            m_uCpuCount = iCpuCount > 0 ? (uint32_t)iCpuCount : 1;
+            m_uCacheSize = uCacheSize;
+            m_uCacheStride = (sizeof(CpuCache) + sizeof(void *) * uCacheSize + PerCpuCacheAlign - 1) &
+                             ~(size_t)(PerCpuCacheAlign - 1);
+            void *ptr = nullptr;
+            if (posix_memalign(&ptr, PerCpuCacheAlign, m_uCacheStride * m_uCpuCount) != 0)
+            {
+                return 1;
+            }
+            m_lpCaches = (uint8_t *)ptr;
+            for (uint32_t i = 0; i < m_uCpuCount; i++)
+            {
+                auto lpCache = new (m_lpCaches + m_uCacheStride * i) CpuCache();
+                lpCache->uCount_ = 0;
+            }
+
+#ifdef PERCPU_POOL_RSEQ
+            m_bRseq = __rseq_size >= 20; // 注册失败时为0
+#endif
+            std::lock_guard<std::mutex> guard(m_lock);
+            if (m_pool.Init(uObjectSize, funcConstruct, option) != 0)
+            {
+                m_pool.UnInit();
+                return 1;
+            }
+            return 0;
+        }
+
+        // 调用时不能有其他线程在使用池，缓存中的对象随块一起释放
+        void UnInit()
+        {
+            if (m_lpCaches != nullptr)
+            {
+                for (uint32_t i = 0; i < m_uCpuCount; i++)
+                {
+                    GetCache(i)->~CpuCache();
+                }
+                free(m_lpCaches);
+                m_lpCaches = nullptr;
+            }
+            m_uCpuCount = 0;
+            m_bRseq = false;
+
+            std::lock_guard<std::mutex> guard(m_lock);
+            m_pool.UnInit();
+        }
+
+        void *Get()
+        {
+            void *ptr = nullptr;
+            auto result = PopCache(&ptr);
+            if (likely(result == CacheOk))
+            {
+                return ptr;
+            }
+            if (result == CacheMiss)
+            {
+                return Refill();
+            }
+
+            std::lock_guard<std::mutex> guard(m_lock);
+            return m_pool.Get();
+        }
+
+        void Release(void *ptr)
+        {
+            if (unlikely(ptr == nullptr))
+            {
+                return;
+            }
+
+            auto result = PushCache(ptr);
+            if (likely(result == CacheOk))
+            {
+                return;
+            }
+            if (result == CacheMiss)
+            {
+                Drain(ptr);
+                return;
+            }
+
+            std::lock_guard<std::mutex> guard(m_lock);
+            m_pool.Release(ptr);
+        }
+
+        // 把所有CPU缓存中的对象还给共享池并回收空闲块，调用时不能有其他线程在使用池
+        uint32_t Trim(uint32_t uKeepIdle = 0)
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            for (uint32_t i = 0; i < m_uCpuCount; i++)
+            {
+                auto lpCache = GetCache(i);
+                m_pool.ReleaseBatch(lpCache->lppObjs_, (uint32_t)lpCache->uCount_);
+                lpCache->uCount_ = 0;
+            }
+            return m_pool.Trim(uKeepIdle);
+        }
+
+        uint32_t GetCpuCount() { return m_uCpuCount; }
+        bool IsRseqEnabled() { return m_bRseq; }
+
+        // 共享池的块数量，调试用
+        uint32_t GetBlockCount()
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            return m_pool.GetBlockCount();
+        }
+
+    private:
+        CpuCache *GetCache(uint32_t uCpu) { return (CpuCache *)(m_lpCaches + m_uCacheStride * uCpu); }
+
+        // 缓存空了：从共享池取半个缓存，一个返回给调用方，其余放进当前CPU的缓存
+        void *Refill()
+        {
+            void *lppObjs[MaxPerCpuCacheSize / 2];
+            uint32_t uGot = 0;
+            {
+                std::lock_guard<std::mutex> guard(m_lock);
+                uGot = m_pool.GetBatch(m_uCacheSize / 2, lppObjs);
+            }
+            if (unlikely(uGot == 0))
+            {
+                return nullptr;
+            }
+
+            // 放入过程中可能被迁移或缓存被别的线程填满，放不进去的还回共享池
+            uint32_t i = 1;
+            while (i < uGot && PushCache(lppObjs[i]) == CacheOk)
+            {
+                i++;
+            }
+            if (unlikely(i < uGot))
+            {
+                std::lock_guard<std::mutex> guard(m_lock);
+                m_pool.ReleaseBatch(lppObjs + i, uGot - i);
+            }
+            return lppObjs[0];
+        }
+
+        // 缓存满了：从当前CPU的缓存取出半个缓存，连同ptr一起还给共享池
+        void Drain(void *ptr)
+        {
+            void *lppObjs[MaxPerCpuCacheSize / 2 + 1];
+            uint32_t uCount = 0;
+            lppObjs[uCount++] = ptr;
+            while (uCount <= m_uCacheSize / 2 && PopCache(&lppObjs[uCount]) == CacheOk)
+            {
+                uCount++;
+            }
+
+            std::lock_guard<std::mutex> guard(m_lock);
+            m_pool.ReleaseBatch(lppObjs, uCount);
+        }
+
+        CacheResult PopCache(void **lppObj)
+        {
+#ifdef PERCPU_POOL_RSEQ
+            if (likely(m_bRseq))
+            {
+                return RseqPop(lppObj);
+            }
+#endif
+            auto lpCache = GetCurrentCache();
+            if (unlikely(lpCache == nullptr))
+            {
+                return CacheAbort;
+            }
+            std::lock_guard<std::mutex> guard(lpCache->lock_);
+            if (lpCache->uCount_ == 0)
+            {
+                return CacheMiss;
+            }
+            *lppObj = lpCache->lppObjs_[--lpCache->uCount_];
+            return CacheOk;
+        }
+
+        CacheResult PushCache(void *ptr)
+        {
+#ifdef PERCPU_POOL_RSEQ
+            if (likely(m_bRseq))
+            {
+                return RseqPush(ptr);
+            }
+#endif
+            auto lpCache = GetCurrentCache();
+            if (unlikely(lpCache == nullptr))
+            {
+                return CacheAbort;
+            }
+            std::lock_guard<std::mutex> guard(lpCache->lock_);
+            if (lpCache->uCount_ == m_uCacheSize)
+            {
+                return CacheMiss;
+            }
+            lpCache->lppObjs_[lpCache->uCount_++] = ptr;
+            return CacheOk;
+        }
+
+        // sched_getcpu只是提示，返回后线程可能已经迁移，所以分片还要加锁
+        CpuCache *GetCurrentCache()
+        {
+            auto iCpu = sched_getcpu();
+            if (unlikely(iCpu < 0 || (uint32_t)iCpu >= m_uCpuCount))
+            {
+                return nullptr;
+            }
+            return GetCache((uint32_t)iCpu);
+        }
+
+#ifdef PERCPU_POOL_RSEQ
+        static struct rseq *GetRseq() { return (struct rseq *)((uint8_t *)__builtin_thread_pointer() + __rseq_offset); }
+
+// 临界区描述符放在__rseq_cs段，abort入口前4字节必须是注册时的签名
+#define PERCPU_RSEQ_CS_BEGIN                                               \
+    ".pushsection __rseq_cs, \"aw\"\n\t"                                   \
+    ".balign 32\n\t"                                                       \
+    "3:\n\t"                                                               \
+    ".long 0x0, 0x0\n\t"                                                   \
+    ".quad 1f, (2f - 1f), 4f\n\t"                                          \
+    ".popsection\n\t"                                                      \
+    "leaq 3b(%%rip), %%rax\n\t"                                            \
+    "movq %%rax, %[rseq_cs]\n\t"                                           \
+    "1:\n\t"                                                               \
+    "cmpl %[cpu], %[cpu_id]\n\t"                                           \
+    "jnz %l[aborted]\n\t"
+
+#define PERCPU_RSEQ_CS_END                                                 \
+    "2:\n\t"                                                               \
+    ".pushsection __rseq_failure, \"ax\"\n\t"                              \
+    ".byte 0x0f, 0xb9, 0x3d\n\t"                                           \
+    ".long " TO_STR2(RSEQ_SIG) "\n\t"                                      \
+    "4:\n\t"                                                               \
+    "jmp %l[aborted]\n\t"                                                    \
+    ".popsection\n\t"
+
+        // 最后一条写uCount_的指令是提交点，之前任何时候被打断都没有副作用
+        CacheResult RseqPop(void **lppObj)
+        {
+            auto lpRseq = GetRseq();
+            auto uCpu = *(volatile uint32_t *)&lpRseq->cpu_id_start;
+            if (unlikely(uCpu >= m_uCpuCount))
+            {
+                return CacheAbort;
+            }
+            auto lpCache = GetCache(uCpu);
+            __asm__ __volatile__ goto(PERCPU_RSEQ_CS_BEGIN
+                                      "movq %[count], %%rbx\n\t"
+                                      "testq %%rbx, %%rbx\n\t"
+                                      "jz %l[missed]\n\t"
+                                      "movq -8(%[objs], %%rbx, 8), %%rcx\n\t"
+                                      "movq %%rcx, %[obj]\n\t"
+                                      "decq %%rbx\n\t"
+                                      "movq %%rbx, %[count]\n\t" PERCPU_RSEQ_CS_END
+                                      :
+                                      : [rseq_cs] "m"(lpRseq->rseq_cs), [cpu] "r"(uCpu), [cpu_id] "m"(lpRseq->cpu_id),
+                                        [count] "m"(lpCache->uCount_), [objs] "r"(lpCache->lppObjs_), [obj] "m"(*lppObj)
+                                      : "memory", "cc", "rax", "rbx", "rcx"
+                                      : aborted, missed);
+            return CacheOk;
+        aborted:
+            return CacheAbort;
+        missed:
+            return CacheMiss;
+        }
+
+        CacheResult RseqPush(void *ptr)
+        {
+            auto lpRseq = GetRseq();
+            auto uCpu = *(volatile uint32_t *)&lpRseq->cpu_id_start;
+            if (unlikely(uCpu >= m_uCpuCount))
+            {
+                return CacheAbort;
+            }
+            auto lpCache = GetCache(uCpu);
+            uint64_t uCacheSize = m_uCacheSize;
+            __asm__ __volatile__ goto(PERCPU_RSEQ_CS_BEGIN
+                                      "movq %[count], %%rbx\n\t"
+                                      "cmpq %[cap], %%rbx\n\t"
+                                      "jae %l[missed]\n\t"
+                                      "movq %[ptr], (%[objs], %%rbx, 8)\n\t"
+                                      "incq %%rbx\n\t"
+                                      "movq %%rbx, %[count]\n\t" PERCPU_RSEQ_CS_END
+                                      :
+                                      : [rseq_cs] "m"(lpRseq->rseq_cs), [cpu] "r"(uCpu), [cpu_id] "m"(lpRseq->cpu_id),
+                                        [count] "m"(lpCache->uCount_), [objs] "r"(lpCache->lppObjs_),
+                                        [cap] "r"(uCacheSize), [ptr] "r"(ptr)
+                                      : "memory", "cc", "rax", "rbx", "rcx"
+                                      : aborted, missed);
+            return CacheOk;
+        aborted:
+            return CacheAbort;
+        missed:
+            return CacheMiss;
+        }
+
+#undef PERCPU_RSEQ_CS_BEGIN
+#undef PERCPU_RSEQ_CS_END
+#endif
+
+    private:
+        uint32_t m_uCpuCount{0};
+        uint32_t m_uCacheSize{0};
+        size_t m_uCacheStride{0}; // 每个CPU的缓存按缓存行对齐，避免伪共享
+        uint8_t *m_lpCaches{nullptr};
+        bool m_bRseq{false};
+        std::mutex m_lock; // 保护共享池
+        CObjectPool m_pool;
+    };
+
+} // end namespace utility
+
+#endif //__PERCPU_OBJECT_POOL_H
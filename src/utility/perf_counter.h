@@ -0,0 +1,361 @@
+#ifndef __PERF_COUNTER_H
+#define __PERF_COUNTER_H
+
+#include <include/common.h>
+#include <utility/tsc_clock.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace utility
+{
+    enum PerfCounterType : uint32_t
+    {
+        PerfCycles = 0,
+        PerfInstructions = 1,
+        PerfL1dMisses = 2,
+        PerfLlcMisses = 3,
+        PerfDtlbMisses = 4,
+        PerfBranchMisses = 5,
+        PerfCounterCount = 6,
+    };
+
+    struct PerfCounterValues
+    {
+        uint64_t arrValues_[PerfCounterCount]{0};
+        uint64_t uTick_{0};
+    };
+
+    // 当前线程的一组硬件计数器(perf_event_open分组)：能用rdpmc时在用户态直接读，否则用read一次读出整组。
+    // 内核不允许或者没有PMU时IsEnabled返回false，Read只记录时间。
+    // 计数只统计打开它的线程，也只能在这个线程上读
+    class CPerfCounterGroup
+    {
+        // 组内读出的格式：PERF_FORMAT_GROUP | TOTAL_TIME_ENABLED | TOTAL_TIME_RUNNING
+        struct GroupReadFormat
+        {
+            uint64_t uNr_;
+            uint64_t uTimeEnabled_;
+            uint64_t uTimeRunning_;
+            uint64_t arrValues_[PerfCounterCount];
+        };
+
+    public:
+        CPerfCounterGroup() = default;
+        ~CPerfCounterGroup() { Close(); }
+        CPerfCounterGroup(const CPerfCounterGroup &) = delete;
+        CPerfCounterGroup &operator=(const CPerfCounterGroup &) = delete;
+
+        // 全部计数器都打不开时返回1，此时仍然可以用Read计时。
+        // 单个计数器不支持时跳过；整组排不上PMU时从后往前减少计数器直到能运行
+        int32_t Open()
+        {
+            Close();
+            for (uint32_t i = 0; i < PerfCounterCount; i++)
+            {
+                OpenCounter(i);
+            }
+            while (m_uOpened != 0 && !IsGroupRunning())
+            {
+                CloseLastCounter();
+            }
+            if (m_uOpened == 0)
+            {
+                Close();
+                return 1;
+            }
+            return 0;
+        }
+
+        void Close()
+        {
+            for (uint32_t i = 0; i < PerfCounterCount; i++)
+            {
+                if (m_arrPages[i] != nullptr)
+                {
+                    munmap(m_arrPages[i], m_uPageSize);
+                    m_arrPages[i] = nullptr;
+                }
+                if (m_arrFds[i] >= 0)
+                {
+                    close(m_arrFds[i]);
+                    m_arrFds[i] = -1;
+                }
+            }
+            m_uOpened = 0;
+            m_uValidMask = 0;
+        }
+
+        bool IsEnabled() { return m_uOpened != 0; }
+        bool IsValid(PerfCounterType type) { return (m_uValidMask & (1u << type)) != 0; }
+        uint32_t GetValidMask() { return m_uValidMask; }
+
+        // 读当前值，只有两次读数之差有意义
+        void Read(PerfCounterValues &values)
+        {
+            if (likely(m_uOpened != 0) && !ReadRdpmc(values))
+            {
+                ReadGroup(values);
+            }
+            values.uTick_ = CTscClock::GetTickEnd();
+        }
+
+        static const char *GetName(uint32_t uType)
+        {
+            static const char *s_arrNames[PerfCounterCount] = {"cycles", "instructions", "l1d_misses",
+                                                                "llc_misses", "dtlb_misses", "branch_misses"};
+            return uType < PerfCounterCount ? s_arrNames[uType] : "unknown";
+        }
+
+    private:
+        static void GetEventConfig(uint32_t uType, __u32 &uEventType, __u64 &uConfig)
+        {
+            auto funcCache = [](uint64_t uCache, uint64_t uOp, uint64_t uResult) {
+                return uCache | (uOp << 8) | (uResult << 16);
+            };
+            uEventType = PERF_TYPE_HARDWARE;
+            switch (uType)
+            {
+            case PerfCycles:
+                uConfig = PERF_COUNT_HW_CPU_CYCLES;
+                break;
+            case PerfInstructions:
+                uConfig = PERF_COUNT_HW_INSTRUCTIONS;
+                break;
+            case PerfL1dMisses:
+                uEventType = PERF_TYPE_HW_CACHE;
+                uConfig = funcCache(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+                break;
+            case PerfLlcMisses:
+                uConfig = PERF_COUNT_HW_CACHE_MISSES;
+                break;
+            case PerfDtlbMisses:
+                uEventType = PERF_TYPE_HW_CACHE;
+                uConfig = funcCache(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+                break;
+            default:
+                uConfig = PERF_COUNT_HW_BRANCH_MISSES;
+                break;
+            }
+        }
+
+        void OpenCounter(uint32_t uType)
+        {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            GetEventConfig(uType, attr.type, attr.config);
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.disabled = m_uOpened == 0 ? 1 : 0; // 组长先停着，整组打开后一起启动
+
+            auto iLeader = m_uOpened == 0 ? -1 : m_arrFds[m_arrTypes[0]];
+            auto iFd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, iLeader, 0);
+            if (iFd < 0)
+            {
+                return;
+            }
+            if (m_uOpened == 0)
+            {
+                ioctl(iFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+                ioctl(iFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+            }
+
+            // 映射一页控制页，用来判断能否rdpmc
+            auto lpPage = mmap(nullptr, m_uPageSize, PROT_READ, MAP_SHARED, iFd, 0);
+            m_arrPages[uType] = lpPage == MAP_FAILED ? nullptr : (perf_event_mmap_page *)lpPage;
+            m_arrFds[uType] = iFd;
+            m_arrTypes[m_uOpened++] = uType;
+            m_uValidMask |= 1u << uType;
+        }
+
+        void CloseLastCounter()
+        {
+            auto uType = m_arrTypes[--m_uOpened];
+            if (m_arrPages[uType] != nullptr)
+            {
+                munmap(m_arrPages[uType], m_uPageSize);
+                m_arrPages[uType] = nullptr;
+            }
+            close(m_arrFds[uType]);
+            m_arrFds[uType] = -1;
+            m_uValidMask &= ~(1u << uType);
+        }
+
+        // 组里的计数器太多时内核排不上，time_running一直为0
+        bool IsGroupRunning()
+        {
+            GroupReadFormat data;
+            volatile uint64_t uSum = 0;
+            for (uint32_t i = 0; i < 10000; i++)
+            {
+                uSum = uSum + i;
+            }
+            if (read(m_arrFds[m_arrTypes[0]], &data, sizeof(data)) <= 0)
+            {
+                return false;
+            }
+            return data.uTimeRunning_ != 0;
+        }
+
+        void ReadGroup(PerfCounterValues &values)
+        {
+            GroupReadFormat data;
+            if (read(m_arrFds[m_arrTypes[0]], &data, sizeof(data)) <= 0)
+            {
+                return;
+            }
+            for (uint32_t i = 0; i < m_uOpened && i < data.uNr_; i++)
+            {
+                values.arrValues_[m_arrTypes[i]] = data.arrValues_[i];
+            }
+        }
+
+        // 只读本线程的计数器，控制页只在本线程被调度时更新，和内核文档的示例一样用编译器屏障即可；mfence的开销会落进被测代码段
+        static void CompilerBarrier() { __asm__ __volatile__("" ::: "memory"); }
+
+        // 所有计数器都能rdpmc时在用户态读完返回true；按内核文档的方式用lock序号保证读到一致的值
+        bool ReadRdpmc(PerfCounterValues &values)
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            for (uint32_t i = 0; i < m_uOpened; i++)
+            {
+                auto uType = m_arrTypes[i];
+                auto lpPage = m_arrPages[uType];
+                if (lpPage == nullptr)
+                {
+                    return false;
+                }
+                uint32_t uSeq;
+                uint64_t uCount;
+                do
+                {
+                    uSeq = lpPage->lock;
+                    CompilerBarrier();
+                    auto uIndex = lpPage->index;
+                    if (!lpPage->cap_user_rdpmc || uIndex == 0)
+                    {
+                        return false;
+                    }
+                    uCount = lpPage->offset;
+                    auto iShift = 64 - lpPage->pmc_width;
+                    auto iPmc = (int64_t)((uint64_t)__rdpmc(uIndex - 1) << iShift) >> iShift; // 按计数器位宽符号扩展
+                    uCount += (uint64_t)iPmc;
+                    CompilerBarrier();
+                } while (lpPage->lock != uSeq);
+                values.arrValues_[uType] = uCount;
+            }
+            return true;
+#else
+            return false;
+#endif
+        }
+
+    private:
+        int m_arrFds[PerfCounterCount]{-1, -1, -1, -1, -1, -1};
+        perf_event_mmap_page *m_arrPages[PerfCounterCount]{nullptr};
+        uint32_t m_arrTypes[PerfCounterCount]{0}; // 按打开顺序，第一个是组长
+        uint32_t m_uOpened{0};
+        uint32_t m_uValidMask{0};
+        size_t m_uPageSize{(size_t)sysconf(_SC_PAGESIZE)};
+    };
+
+    // 一个被测代码段的累计值：调用次数、时间和每个计数器的增量之和
+    class CPerfCounterSection
+    {
+    public:
+        explicit CPerfCounterSection(const char *lpName) : m_lpName(lpName) {}
+
+        void Add(const PerfCounterValues &begin, const PerfCounterValues &end)
+        {
+            m_uCalls++;
+            m_uTicks += end.uTick_ - begin.uTick_;
+            for (uint32_t i = 0; i < PerfCounterCount; i++)
+            {
+                m_arrSums[i] += end.arrValues_[i] - begin.arrValues_[i];
+            }
+        }
+
+        void Merge(const CPerfCounterSection &other)
+        {
+            m_uCalls += other.m_uCalls;
+            m_uTicks += other.m_uTicks;
+            for (uint32_t i = 0; i < PerfCounterCount; i++)
+            {
+                m_arrSums[i] += other.m_arrSums[i];
+            }
+        }
+
+        void Reset()
+        {
+            m_uCalls = 0;
+            m_uTicks = 0;
+            memset(m_arrSums, 0, sizeof(m_arrSums));
+        }
+
+        uint64_t GetCalls() { return m_uCalls; }
+        uint64_t GetTimeNano() { return CTscClock::TickToNano(m_uTicks); }
+        uint64_t GetSum(PerfCounterType type) { return m_arrSums[type]; }
+
+        // uValidMask来自CPerfCounterGroup::GetValidMask，没有打开的计数器显示n/a
+        void Print(uint32_t uValidMask, FILE *fp = stdout)
+        {
+            auto uCalls = m_uCalls == 0 ? 1 : m_uCalls;
+            fprintf(fp, "%s: calls = %lu, avg = %lu ns", m_lpName, m_uCalls, GetTimeNano() / uCalls);
+            for (uint32_t i = 0; i < PerfCounterCount; i++)
+            {
+                if ((uValidMask & (1u << i)) == 0)
+                {
+                    fprintf(fp, ", %s = n/a", CPerfCounterGroup::GetName(i));
+                    continue;
+                }
+                fprintf(fp, ", %s = %.2f", CPerfCounterGroup::GetName(i), (double)m_arrSums[i] / uCalls);
+            }
+            if ((uValidMask & 3) == 3 && m_arrSums[PerfCycles] != 0)
+            {
+                fprintf(fp, ", ipc = %.2f", (double)m_arrSums[PerfInstructions] / m_arrSums[PerfCycles]);
+            }
+            fprintf(fp, "\n");
+        }
+
+    private:
+        const char *m_lpName;
+        uint64_t m_uCalls{0};
+        uint64_t m_uTicks{0};
+        uint64_t m_arrSums[PerfCounterCount]{0};
+    };
+
+    // 构造时读一次，析构时再读一次，差值累加到section
+    class CPerfCounterScope
+    {
+    public:
+        CPerfCounterScope(CPerfCounterGroup &group, CPerfCounterSection &section) : m_group(group), m_section(section)
+        {
+            m_group.Read(m_begin);
+        }
+
+        ~CPerfCounterScope()
+        {
+            PerfCounterValues end;
+            m_group.Read(end);
+            m_section.Add(m_begin, end);
+        }
+
+        CPerfCounterScope(const CPerfCounterScope &) = delete;
+        CPerfCounterScope &operator=(const CPerfCounterScope &) = delete;
+
+    private:
+        CPerfCounterGroup &m_group;
+        CPerfCounterSection &m_section;
+        PerfCounterValues m_begin;
+    };
+
+} // end namespace utility
+
+#endif //__PERF_COUNTER_H
@@ -0,0 +1,113 @@
+#ifndef __PERF_HISTOGRAM_H
+#define __PERF_HISTOGRAM_H
+
+#include <include/common.h>
+
+namespace utility
+{
+    constexpr uint32_t HistogramSubBits = 5;                              // 每个2的幂区间分成32格，相对误差不超过1/32
+    constexpr uint32_t HistogramSubCount = 1u << HistogramSubBits;
+    constexpr uint32_t HistogramMaxBits = 48;                             // 超过2^48的值都落在最后一格
+    constexpr uint32_t HistogramBucketCount = (HistogramMaxBits - HistogramSubBits + 1) * HistogramSubCount;
+
+    // 对数线性直方图(HDR风格)：小于32的值每个值一格，之后每个2的幂区间等分成32格。
+    // 大小固定，记录多少个值都不增长；同样配置的直方图可以直接按格相加合并
+    class CPerfHistogram
+    {
+    public:
+        void Record(uint64_t uValue)
+        {
+            m_arrCounts[GetBucket(uValue)]++;
+            m_uCount++;
+            m_uSum += uValue;
+            m_uMin = uValue < m_uMin ? uValue : m_uMin;
+            m_uMax = uValue > m_uMax ? uValue : m_uMax;
+        }
+
+        void Merge(const CPerfHistogram &other)
+        {
+            for (uint32_t i = 0; i < HistogramBucketCount; i++)
+            {
+                m_arrCounts[i] += other.m_arrCounts[i];
+            }
+            m_uCount += other.m_uCount;
+            m_uSum += other.m_uSum;
+            m_uMin = other.m_uMin < m_uMin ? other.m_uMin : m_uMin;
+            m_uMax = other.m_uMax > m_uMax ? other.m_uMax : m_uMax;
+        }
+
+        void Reset()
+        {
+            memset(m_arrCounts, 0, sizeof(m_arrCounts));
+            m_uCount = 0;
+            m_uSum = 0;
+            m_uMin = UINT64_MAX;
+            m_uMax = 0;
+        }
+
+        // dPercent取值0~100，返回所在格的上界，不超过实际最大值
+        uint64_t GetPercentile(double dPercent) const
+        {
+            if (m_uCount == 0)
+            {
+                return 0;
+            }
+            auto uRank = uint64_t(dPercent / 100.0 * m_uCount + 0.5);
+            uRank = uRank == 0 ? 1 : (uRank > m_uCount ? m_uCount : uRank);
+            uint64_t uSeen = 0;
+            for (uint32_t i = 0; i < HistogramBucketCount; i++)
+            {
+                uSeen += m_arrCounts[i];
+                if (uSeen >= uRank)
+                {
+                    auto uUpper = GetBucketUpper(i);
+                    return uUpper < m_uMax ? uUpper : m_uMax;
+                }
+            }
+            return m_uMax;
+        }
+
+        uint64_t GetCount() const { return m_uCount; }
+        uint64_t GetSum() const { return m_uSum; }
+        uint64_t GetMin() const { return m_uCount == 0 ? 0 : m_uMin; }
+        uint64_t GetMax() const { return m_uMax; }
+        uint64_t GetMean() const { return m_uCount == 0 ? 0 : m_uSum / m_uCount; }
+
+        static uint32_t GetBucket(uint64_t uValue)
+        {
+            if (uValue < HistogramSubCount)
+            {
+                return (uint32_t)uValue;
+            }
+            uint32_t uExp = 63 - __builtin_clzll(uValue);
+            if (unlikely(uExp >= HistogramMaxBits))
+            {
+                return HistogramBucketCount - 1;
+            }
+            uint32_t uShift = uExp - HistogramSubBits;
+            return (uShift + 1) * HistogramSubCount + (uint32_t)(uValue >> uShift) - HistogramSubCount;
+        }
+
+        // 格内的最大值
+        static uint64_t GetBucketUpper(uint32_t uBucket)
+        {
+            if (uBucket < HistogramSubCount)
+            {
+                return uBucket;
+            }
+            uint32_t uShift = uBucket / HistogramSubCount - 1;
+            uint64_t uMantissa = uBucket % HistogramSubCount + HistogramSubCount;
+            return ((uMantissa + 1) << uShift) - 1;
+        }
+
+    private:
+        uint64_t m_arrCounts[HistogramBucketCount]{0};
+        uint64_t m_uCount{0};
+        uint64_t m_uSum{0};
+        uint64_t m_uMin{UINT64_MAX};
+        uint64_t m_uMax{0};
+    };
+
+} // end namespace utility
+
+#endif //__PERF_HISTOGRAM_H
@@ -2,11 +2,14 @@
 #define __PERF_PROFILER_H
 
 #include <include/common.h>
+#include <utility/perf_histogram.h>
+#include <utility/tsc_clock.h>
+#include <memory>
 #include <vector>
 
 #define GetTimeDiff(begin, end) uint64_t((end.tv_sec - begin.tv_sec) * (1000 * 1000 * 1000) + (end.tv_nsec - begin.tv_nsec));
-#define BeginPerfTest(name) CPerfProfilerWrap ts_begin_##name, ts_end_##name; clock_gettime(CLOCK_MONOTONIC, &ts_begin_##name);
-#define EndPerfTest(name, channal) clock_gettime(CLOCK_MONOTONIC, &ts_end_##name); fprintf(channal, #name " = %lu\n", GetTimeDiff(ts_begin_##name, ts_end_##name));
+#define BeginPerfTest(name) uint64_t ts_begin_##name = utility::CTscClock::GetTick();
+#define EndPerfTest(name, channal) uint64_t ts_end_##name = utility::CTscClock::GetTickEnd(); fprintf(channal, #name " = %lu\n", utility::CTscClock::TickToNano(ts_end_##name - ts_begin_##name));
 
 namespace utility
 {
@@ -17,7 +20,7 @@ namespace utility
         struct TimePoint
         {
             const char *lpName_;
-            timespec tsTime_{0};
+            uint64_t uTick_{0}; // CTscClock的tick，输出时才换算成纳秒
         };
 
         class IObjAllocator
@@ -52,6 +55,10 @@ namespace utility
                     }
                 }
             }
+            if (m_lpTime != nullptr && m_lpTime != m_Time && m_lpAllocator != nullptr)
+            {
+                m_lpAllocator->Release(m_lpTime);
+            }
         }
 
         static void GetTime(timespec &ts)
@@ -69,6 +76,12 @@ namespace utility
             return uint64_t((end.tv_sec - begin.tv_sec) * 1000000000 + (end.tv_nsec - begin.tv_nsec));
         }
 
+        // 两个TimePoint之间的纳秒数
+        static uint64_t GetTickDiffNano(TimePoint *lpBegin, TimePoint *lpEnd)
+        {
+            return CTscClock::TickToNano(lpEnd->uTick_ - lpBegin->uTick_);
+        }
+
         void Add(const char *lpName)
         {
             if (unlikely(m_lpTime == nullptr))
@@ -86,7 +99,7 @@ namespace utility
             }
 
             m_lpTime[m_uSize].lpName_ = lpName;
-            GetTime(m_lpTime[m_uSize].tsTime_);
+            m_lpTime[m_uSize].uTick_ = CTscClock::GetTick();
             m_uSize++;
         }
 
@@ -111,8 +124,7 @@ namespace utility
     private:
         TimePoint *Expand()
         {
-            timespec tmpTs;
-            GetTime(tmpTs);
+            auto uTick = CTscClock::GetTick();
 
             m_vecTimes.push_back(m_lpTime);
             m_lpTime = nullptr;
@@ -125,7 +137,7 @@ namespace utility
             if (m_lpTime != nullptr)
             {
                 m_lpTime[m_uSize].lpName_ = "__pf_expand";
-                m_lpTime[m_uSize].tsTime_ = tmpTs;
+                m_lpTime[m_uSize].uTick_ = uTick;
                 m_uSize++;
                 return m_lpTime;
             }
@@ -142,26 +154,123 @@ namespace utility
         std::vector<TimePoint *> m_vecTimes;
     };
 
+    enum PerfProfilerMode
+    {
+        PerfModeSample = 0,    // 保存每个打点，内存随打点次数增长
+        PerfModeHistogram = 1, // 每个打点名字一个直方图，内存固定
+    };
+
+    constexpr uint32_t MaxPerfProbes = 32; // 直方图模式下最多的打点名字数量
+
     class CPerfProfilerWrap
     {
+        struct Probe
+        {
+            const char *lpName_{nullptr};
+            std::unique_ptr<CPerfHistogram> lpHist_; // 单位是tick
+        };
+
     public:
         CPerfProfilerWrap(CPerfProfiler::IObjAllocator *lpAllocator = nullptr) : m_perf(lpAllocator)
         {
             m_perf.Add("begin");
         }
 
+        // 直方图模式：记录相邻两次Add的间隔，归到后一次Add的名字下；名字指针在实例销毁前必须有效
+        explicit CPerfProfilerWrap(PerfProfilerMode mode) : m_mode(mode)
+        {
+            if (m_mode == PerfModeHistogram)
+            {
+                m_uLastTick = CTscClock::GetTick();
+                return;
+            }
+            m_perf.Add("begin");
+        }
+
         ~CPerfProfilerWrap() = default;
 
-        void Add(const char *lpName) { m_perf.Add(lpName); }
+        void Add(const char *lpName)
+        {
+            if (m_mode == PerfModeSample)
+            {
+                m_perf.Add(lpName);
+                return;
+            }
+
+            auto uTick = CTscClock::GetTick();
+            auto lpHist = GetHistogram(lpName, true);
+            if (likely(lpHist != nullptr))
+            {
+                lpHist->Record(uTick - m_uLastTick);
+            }
+            else
+            {
+                m_uDropped++;
+            }
+            m_uLastTick = uTick;
+        }
+
+        // 把另一个实例的直方图按名字合并进来，两边都必须是直方图模式
+        int32_t Merge(const CPerfProfilerWrap &other)
+        {
+            if (m_mode != PerfModeHistogram || other.m_mode != PerfModeHistogram)
+            {
+                return 1;
+            }
+            for (uint32_t i = 0; i < other.m_uProbeCount; i++)
+            {
+                auto lpHist = GetHistogram(other.m_arrProbes[i].lpName_, true);
+                if (lpHist == nullptr)
+                {
+                    m_uDropped += other.m_arrProbes[i].lpHist_->GetCount();
+                    continue;
+                }
+                lpHist->Merge(*other.m_arrProbes[i].lpHist_);
+            }
+            m_uDropped += other.m_uDropped;
+            return 0;
+        }
+
+        // 不存在时返回nullptr
+        const CPerfHistogram *GetHistogram(const char *lpName)
+        {
+            return GetHistogram(lpName, false);
+        }
+
+        uint32_t GetProbeCount() { return m_uProbeCount; }
+        uint64_t GetDroppedCount() { return m_uDropped; }
 
         void Print(const char *szTip)
         {
+            if (m_mode == PerfModeHistogram)
+            {
+                printf("\n%s:\n", szTip);
+                if (m_uProbeCount == 0)
+                {
+                    printf("empty statics!\n");
+                }
+                for (uint32_t i = 0; i < m_uProbeCount; i++)
+                {
+                    auto &hist = *m_arrProbes[i].lpHist_;
+                    printf("%s: count = %lu, avg = %lu, p50 = %lu, p90 = %lu, p99 = %lu, p99.9 = %lu, max = %lu\n",
+                           m_arrProbes[i].lpName_, hist.GetCount(), CTscClock::TickToNano(hist.GetMean()),
+                           CTscClock::TickToNano(hist.GetPercentile(50)), CTscClock::TickToNano(hist.GetPercentile(90)),
+                           CTscClock::TickToNano(hist.GetPercentile(99)), CTscClock::TickToNano(hist.GetPercentile(99.9)),
+                           CTscClock::TickToNano(hist.GetMax()));
+                }
+                if (m_uDropped != 0)
+                {
+                    printf("dropped = %lu\n", m_uDropped);
+                }
+                return;
+            }
+
             uint64_t uSum = 0;
             uint64_t uCount = 0;
             auto uSize = m_perf.GetSize();
             for (uint32_t i = 1; i < uSize; i++)
             {
-                uSum += CPerfProfiler::GetTimeDiffNano(m_perf.At(i - 1)->tsTime_, m_perf.At(i)->tsTime_);
+                uSum += CPerfProfiler::GetTickDiffNano(m_perf.At(i - 1), m_perf.At(i));
                 uCount++;
             }
             
@@ -175,6 +284,7 @@ namespace utility
             }
         }
 
+        // 直方图模式每个名字一行：name, count, avg, p50, p90, p99, p99.9, max
         void Save(const char *szName)
         {
             auto lpFile = fopen(szName, "w");
@@ -183,17 +293,64 @@ namespace utility
                 return;
             }
 
+            if (m_mode == PerfModeHistogram)
+            {
+                for (uint32_t i = 0; i < m_uProbeCount; i++)
+                {
+                    auto &hist = *m_arrProbes[i].lpHist_;
+                    fprintf(lpFile, "%s, %lu, %lu, %lu, %lu, %lu, %lu, %lu\n", m_arrProbes[i].lpName_, hist.GetCount(),
+                            CTscClock::TickToNano(hist.GetMean()), CTscClock::TickToNano(hist.GetPercentile(50)),
+                            CTscClock::TickToNano(hist.GetPercentile(90)), CTscClock::TickToNano(hist.GetPercentile(99)),
+                            CTscClock::TickToNano(hist.GetPercentile(99.9)), CTscClock::TickToNano(hist.GetMax()));
+                }
+                fclose(lpFile);
+                return;
+            }
+
             auto uSize = m_perf.GetSize();
             for (uint32_t i = 1; i < uSize; i++)
             {
-                fprintf(lpFile, "%s, %lu\n",m_perf.At(i)->lpName_,  CPerfProfiler::GetTimeDiffNano(m_perf.At(i - 1)->tsTime_, m_perf.At(i)->tsTime_));
+                fprintf(lpFile, "%s, %lu\n",m_perf.At(i)->lpName_,  CPerfProfiler::GetTickDiffNano(m_perf.At(i - 1), m_perf.At(i)));
             }
 
             fclose(lpFile);
         }
 
+    private:
+        // 名字一般是字符串常量，先比较指针再比较内容；超过MaxPerfProbes个名字时返回nullptr
+        CPerfHistogram *GetHistogram(const char *lpName, bool bCreate)
+        {
+            for (uint32_t i = 0; i < m_uProbeCount; i++)
+            {
+                if (m_arrProbes[i].lpName_ == lpName)
+                {
+                    return m_arrProbes[i].lpHist_.get();
+                }
+            }
+            for (uint32_t i = 0; i < m_uProbeCount; i++)
+            {
+                if (strcmp(m_arrProbes[i].lpName_, lpName) == 0)
+                {
+                    return m_arrProbes[i].lpHist_.get();
+                }
+            }
+            if (!bCreate || m_uProbeCount >= MaxPerfProbes)
+            {
+                return nullptr;
+            }
+            auto &probe = m_arrProbes[m_uProbeCount++];
+            probe.lpName_ = lpName;
+            probe.lpHist_.reset(new CPerfHistogram());
+            return probe.lpHist_.get();
+        }
+
     private:
         CPerfProfiler m_perf;
+        PerfProfilerMode m_mode{PerfModeSample};
+        uint64_t m_uLastTick{0};
+        uint64_t m_uDropped{0}; // 名字超过MaxPerfProbes个时丢弃的次数
+        uint32_t m_uProbeCount{0};
+        Probe m_arrProbes[MaxPerfProbes];
     };
 
 } // end namespace utility
@@ -0,0 +1,354 @@
+#ifndef __PERF_TRACE_H
+#define __PERF_TRACE_H
+
+#include <include/common.h>
+#include <utility/tsc_clock.h>
+#include <sys/syscall.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define PERF_TRACE_CONCAT1(a, b) a##b
+#define PERF_TRACE_CONCAT2(a, b) PERF_TRACE_CONCAT1(a, b)
+// lpName必须是字符串常量，记录的只是指针
+#define PERF_TRACE_SCOPE(lpName) utility::CPerfTraceScope PERF_TRACE_CONCAT2(perfTraceScope_, __LINE__)(lpName)
+#define PERF_TRACE_BEGIN(lpName) utility::CPerfTrace::Begin(lpName)
+#define PERF_TRACE_END(lpName) utility::CPerfTrace::End(lpName)
+#define PERF_TRACE_INSTANT(lpName) utility::CPerfTrace::Instant(lpName)
+
+// 池内部的打点(如Expand)只在定义OBJECT_POOL_TIMELINE时编译进去
+#ifdef OBJECT_POOL_TIMELINE
+#define POOL_TIMELINE_SCOPE(lpName) PERF_TRACE_SCOPE(lpName)
+#else
+#define POOL_TIMELINE_SCOPE(lpName) \
+    do                              \
+    {                               \
+    } while (0)
+#endif
+
+namespace utility
+{
+    constexpr uint32_t DefaultTraceRingSize = 8192;  // 每个线程的环形缓冲区能存的事件数，必须是2的幂
+    constexpr uint32_t DefaultTraceIntervalMs = 10;  // 收集线程两次收集之间的间隔
+
+    enum PerfTraceType : uint32_t
+    {
+        PerfTraceBegin = 0,
+        PerfTraceEnd = 1,
+        PerfTraceInstant = 2,
+    };
+
+    // 进程级的时间线：每个线程把事件写进自己的单生产者单消费者环形缓冲区，满了就丢弃并计数，从不阻塞。
+    // 收集线程定期取走所有缓冲区的事件，写成Chrome Trace Event格式的JSON，可以用chrome://tracing或Perfetto打开
+    class CPerfTrace
+    {
+        struct TraceEvent
+        {
+            uint64_t uTick_;
+            const char *lpName_;
+            uint32_t uType_;
+        };
+
+        struct ThreadRing
+        {
+            std::atomic<uint64_t> uHead_{0}; // 收集线程读到的位置
+            uint8_t arrPad_[64 - sizeof(uint64_t)]; // 读写位置分开在不同的缓存行
+            std::atomic<uint64_t> uTail_{0}; // 所属线程写到的位置
+            std::atomic<uint64_t> uDropped_{0};
+            std::atomic<bool> bExited_{false};
+            uint32_t uThreadId_;
+            uint32_t uMask_;
+            std::unique_ptr<TraceEvent[]> lpEvents_;
+
+            // 创建时清零整个缓冲区，缺页发生在这里而不是打点时
+            ThreadRing(uint32_t uThreadId, uint32_t uSize)
+                : uThreadId_(uThreadId), uMask_(uSize - 1), lpEvents_(new TraceEvent[uSize]())
+            {
+            }
+
+            void Push(const char *lpName, PerfTraceType type)
+            {
+                auto uTail = uTail_.load(std::memory_order_relaxed);
+                if (unlikely(uTail - uHead_.load(std::memory_order_acquire) > uMask_))
+                {
+                    uDropped_.store(uDropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                    return;
+                }
+                auto &event = lpEvents_[uTail & uMask_];
+                event.uTick_ = CTscClock::GetTick();
+                event.lpName_ = lpName;
+                event.uType_ = type;
+                uTail_.store(uTail + 1, std::memory_order_release);
+            }
+        };
+
+        // 线程退出时通知收集线程，缓冲区由收集线程取完后释放
+        struct ThreadHolder
+        {
+            ThreadRing *lpRing_{nullptr};
+
+            ~ThreadHolder()
+            {
+                if (lpRing_ != nullptr)
+                {
+                    lpRing_->bExited_.store(true, std::memory_order_release);
+                }
+            }
+        };
+
+        struct TraceState
+        {
+            std::mutex lock_; // 保护缓冲区列表和文件
+            std::vector<std::unique_ptr<ThreadRing>> vecRings_;
+            std::vector<std::pair<uint32_t, uint64_t>> vecExitedDrops_; // 已退出线程的丢弃数
+            std::atomic<bool> bEnabled_{false};
+            std::atomic<bool> bStop_{false};
+            std::thread collector_;
+            FILE *fp_{nullptr};
+            uint32_t uRingSize_{DefaultTraceRingSize};
+            uint32_t uIntervalMs_{DefaultTraceIntervalMs};
+            uint64_t uBaseTick_{0};
+            uint64_t uEvents_{0};
+            bool bFirst_{true};
+
+            // 进程退出前没有调用Stop时，至少让收集线程退出
+            ~TraceState()
+            {
+                bStop_.store(true, std::memory_order_release);
+                if (collector_.joinable())
+                {
+                    collector_.join();
+                }
+            }
+        };
+
+    public:
+        // 开始记录到lpPath，uRingSize只对之后第一次打点的线程生效；已经在记录时返回1
+        static int32_t Start(const char *lpPath, uint32_t uRingSize = DefaultTraceRingSize,
+                             uint32_t uIntervalMs = DefaultTraceIntervalMs)
+        {
+            auto &state = GetState();
+            std::lock_guard<std::mutex> guard(state.lock_);
+            if (state.fp_ != nullptr || uRingSize < 2 || (uRingSize & (uRingSize - 1)) != 0)
+            {
+                return 1;
+            }
+            state.fp_ = fopen(lpPath, "w");
+            if (state.fp_ == nullptr)
+            {
+                return 1;
+            }
+            fprintf(state.fp_, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+            state.uRingSize_ = uRingSize;
+            state.uIntervalMs_ = uIntervalMs;
+            state.uBaseTick_ = CTscClock::GetTick();
+            state.uEvents_ = 0;
+            state.bFirst_ = true;
+            state.vecExitedDrops_.clear();
+            for (auto &lpRing : state.vecRings_)
+            {
+                lpRing->uHead_.store(lpRing->uTail_.load(std::memory_order_acquire), std::memory_order_release);
+                lpRing->uDropped_.store(0, std::memory_order_relaxed);
+            }
+            state.bStop_.store(false, std::memory_order_relaxed);
+            state.collector_ = std::thread(Collect);
+            state.bEnabled_.store(true, std::memory_order_release);
+            return 0;
+        }
+
+        // 停止记录，取完剩余事件并写入丢弃统计，返回写入的事件数
+        static uint64_t Stop()
+        {
+            auto &state = GetState();
+            state.bEnabled_.store(false, std::memory_order_release);
+            state.bStop_.store(true, std::memory_order_release);
+            if (state.collector_.joinable())
+            {
+                state.collector_.join();
+            }
+
+            std::lock_guard<std::mutex> guard(state.lock_);
+            if (state.fp_ == nullptr)
+            {
+                return 0;
+            }
+            DrainLocked(state);
+            auto uPid = (uint32_t)getpid();
+            auto funcDrops = [&](uint32_t uThreadId, uint64_t uDropped) {
+                WriteSeparator(state);
+                fprintf(state.fp_, "{\"name\":\"trace_dropped\",\"ph\":\"C\",\"ts\":0,\"pid\":%u,\"tid\":%u,"
+                                   "\"args\":{\"dropped\":%lu}}", uPid, uThreadId, uDropped);
+            };
+            for (auto &lpRing : state.vecRings_)
+            {
+                if (lpRing->uDropped_.load(std::memory_order_relaxed) != 0)
+                {
+                    funcDrops(lpRing->uThreadId_, lpRing->uDropped_.load(std::memory_order_relaxed));
+                }
+            }
+            for (auto &item : state.vecExitedDrops_)
+            {
+                funcDrops(item.first, item.second);
+            }
+            fprintf(state.fp_, "]}\n");
+            fclose(state.fp_);
+            state.fp_ = nullptr;
+            return state.uEvents_;
+        }
+
+        static bool IsEnabled() { return GetState().bEnabled_.load(std::memory_order_relaxed); }
+
+        static void Begin(const char *lpName) { Record(lpName, PerfTraceBegin); }
+        static void End(const char *lpName) { Record(lpName, PerfTraceEnd); }
+        static void Instant(const char *lpName) { Record(lpName, PerfTraceInstant); }
+
+        // 当前所有线程的丢弃数之和，包括已退出的线程
+        static uint64_t GetDroppedCount()
+        {
+            auto &state = GetState();
+            std::lock_guard<std::mutex> guard(state.lock_);
+            uint64_t uDropped = 0;
+            for (auto &lpRing : state.vecRings_)
+            {
+                uDropped += lpRing->uDropped_.load(std::memory_order_relaxed);
+            }
+            for (auto &item : state.vecExitedDrops_)
+            {
+                uDropped += item.second;
+            }
+            return uDropped;
+        }
+
+    private:
+        static TraceState &GetState()
+        {
+            static TraceState s_state;
+            return s_state;
+        }
+
+        static void Record(const char *lpName, PerfTraceType type)
+        {
+            if (likely(!IsEnabled()))
+            {
+                return;
+            }
+            static thread_local ThreadHolder s_holder;
+            if (unlikely(s_holder.lpRing_ == nullptr))
+            {
+                s_holder.lpRing_ = CreateRing();
+            }
+            s_holder.lpRing_->Push(lpName, type);
+        }
+
+        static ThreadRing *CreateRing()
+        {
+            auto &state = GetState();
+            std::lock_guard<std::mutex> guard(state.lock_);
+            state.vecRings_.emplace_back(new ThreadRing((uint32_t)syscall(SYS_gettid), state.uRingSize_));
+            return state.vecRings_.back().get();
+        }
+
+        static void Collect()
+        {
+            auto &state = GetState();
+            while (!state.bStop_.load(std::memory_order_acquire))
+            {
+                {
+                    std::lock_guard<std::mutex> guard(state.lock_);
+                    DrainLocked(state);
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(state.uIntervalMs_));
+            }
+        }
+
+        static void WriteSeparator(TraceState &state)
+        {
+            if (!state.bFirst_)
+            {
+                fputc(',', state.fp_);
+            }
+            state.bFirst_ = false;
+            fputc('\n', state.fp_);
+        }
+
+        // 调用方持有锁；已退出线程的缓冲区取完后释放
+        static void DrainLocked(TraceState &state)
+        {
+            static const char *s_arrPhase[] = {"B", "E", "i"};
+            auto uPid = (uint32_t)getpid();
+            for (auto iter = state.vecRings_.begin(); iter != state.vecRings_.end();)
+            {
+                auto lpRing = iter->get();
+                auto bExited = lpRing->bExited_.load(std::memory_order_acquire);
+                auto uHead = lpRing->uHead_.load(std::memory_order_relaxed);
+                auto uTail = lpRing->uTail_.load(std::memory_order_acquire);
+                for (; uHead != uTail; uHead++)
+                {
+                    auto &event = lpRing->lpEvents_[uHead & lpRing->uMask_];
+                    auto uNano = event.uTick_ > state.uBaseTick_ ? CTscClock::TickToNano(event.uTick_ - state.uBaseTick_) : 0;
+                    WriteSeparator(state);
+                    fprintf(state.fp_, "{\"name\":\"");
+                    WriteName(state.fp_, event.lpName_);
+                    fprintf(state.fp_, "\",\"ph\":\"%s\",\"ts\":%lu.%03lu,\"pid\":%u,\"tid\":%u%s}",
+                            s_arrPhase[event.uType_], uNano / 1000, uNano % 1000, uPid, lpRing->uThreadId_,
+                            event.uType_ == PerfTraceInstant ? ",\"s\":\"t\"" : "");
+                    state.uEvents_++;
+                }
+                lpRing->uHead_.store(uHead, std::memory_order_release);
+
+                if (bExited)
+                {
+                    auto uDropped = lpRing->uDropped_.load(std::memory_order_relaxed);
+                    if (uDropped != 0)
+                    {
+                        state.vecExitedDrops_.emplace_back(lpRing->uThreadId_, uDropped);
+                    }
+                    iter = state.vecRings_.erase(iter);
+                    continue;
+                }
+                ++iter;
+            }
+            fflush(state.fp_);
+        }
+
+        // 名字里的引号、反斜杠和控制字符按JSON转义
+        static void WriteName(FILE *fp, const char *lpName)
+        {
+            for (auto lpChar = lpName; *lpChar != '\0'; lpChar++)
+            {
+                if (*lpChar == '"' || *lpChar == '\\')
+                {
+                    fputc('\\', fp);
+                    fputc(*lpChar, fp);
+                }
+                else if ((uint8_t)*lpChar < 0x20)
+                {
+                    fprintf(fp, "\\u%04x", (uint8_t)*lpChar);
+                }
+                else
+                {
+                    fputc(*lpChar, fp);
+                }
+            }
+        }
+    };
+
+    // 构造时记录开始，析构时记录结束
+    class CPerfTraceScope
+    {
+    public:
+        explicit CPerfTraceScope(const char *lpName) : m_lpName(lpName) { CPerfTrace::Begin(m_lpName); }
+        ~CPerfTraceScope() { CPerfTrace::End(m_lpName); }
+        CPerfTraceScope(const CPerfTraceScope &) = delete;
+        CPerfTraceScope &operator=(const CPerfTraceScope &) = delete;
+
+    private:
+        const char *m_lpName;
+    };
+
+} // end namespace utility
+
+#endif //__PERF_TRACE_H
@@ -0,0 +1,351 @@
+#ifndef __PERF_ZONE_H
+#define __PERF_ZONE_H
+
+#include <include/common.h>
+#include <utility/tsc_clock.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 编译时定义PERF_ZONE_ENABLE才打点，未定义时PERF_ZONE展开为空
+#ifdef PERF_ZONE_ENABLE
+#define PERF_ZONE_CONCAT1(a, b) a##b
+#define PERF_ZONE_CONCAT2(a, b) PERF_ZONE_CONCAT1(a, b)
+// 每个打点位置一个静态的PerfZoneSite，只在第一次执行时构造，之后每次调用只比较指针
+#define PERF_ZONE(lpName)                                                                                     \
+    static utility::PerfZoneSite PERF_ZONE_CONCAT2(s_perfZoneSite_, __LINE__)(lpName, __FILE__, __LINE__);  \
+    utility::CPerfZoneScope PERF_ZONE_CONCAT2(perfZoneScope_, __LINE__)(&PERF_ZONE_CONCAT2(s_perfZoneSite_, __LINE__))
+#else
+#define PERF_ZONE(lpName) \
+    do                    \
+    {                     \
+    } while (0)
+#endif
+
+namespace utility
+{
+    constexpr uint32_t MaxZoneNodes = 4096; // 每个线程调用树的最大节点数，超过后新路径上的打点被丢弃
+
+    struct PerfZoneSite
+    {
+        const char *lpName_;
+        const char *lpFile_;
+        uint32_t uLine_;
+        uint32_t uId_;
+
+        PerfZoneSite(const char *lpName, const char *lpFile, uint32_t uLine)
+            : lpName_(lpName), lpFile_(lpFile), uLine_(uLine), uId_(GetSiteSeq()++)
+        {
+        }
+
+        static std::atomic<uint32_t> &GetSiteSeq()
+        {
+            static std::atomic<uint32_t> s_uSeq{0};
+            return s_uSeq;
+        }
+    };
+
+    // 一个线程的调用树：同一个位置从不同路径进入是不同的节点。
+    // 节点同一时刻最多只有一次活跃的进入(递归会走到更深的节点)，所以开始时间直接存在节点里。
+    // 子节点的时间先挂在父节点上，父节点结束时才计入，进行中的节点被输出时包含时间和子节点时间都不含这次进入
+    class CPerfZoneTree
+    {
+    public:
+        struct ZoneNode
+        {
+            const PerfZoneSite *lpSite_{nullptr}; // 根节点为空
+            uint32_t uParent_{0};
+            uint32_t uFirstChild_{0}; // 0表示没有，根节点不会是任何节点的子节点
+            uint32_t uNextSibling_{0};
+            uint64_t uCalls_{0};
+            uint64_t uInclusiveTicks_{0};
+            uint64_t uChildTicks_{0};
+            uint64_t uPendingChildTicks_{0}; // 本次进入中已结束的子节点时间
+            uint64_t uStartTick_{0};
+
+            uint64_t GetExclusiveTicks() const { return uInclusiveTicks_ - uChildTicks_; }
+        };
+
+    public:
+        CPerfZoneTree() { m_vecNodes.emplace_back(); }
+
+        void Enter(const PerfZoneSite *lpSite)
+        {
+            if (unlikely(m_uOverflowDepth != 0))
+            {
+                m_uOverflowDepth++;
+                return;
+            }
+            auto uChild = FindChild(m_uCurrent, lpSite, true);
+            if (unlikely(uChild == 0))
+            {
+                m_uOverflowDepth = 1;
+                return;
+            }
+            m_uCurrent = uChild;
+            m_vecNodes[uChild].uStartTick_ = CTscClock::GetTick();
+        }
+
+        void Leave()
+        {
+            if (unlikely(m_uOverflowDepth != 0))
+            {
+                m_uOverflowDepth--;
+                m_uDropped++;
+                return;
+            }
+            auto uTick = CTscClock::GetTickEnd();
+            auto &node = m_vecNodes[m_uCurrent];
+            auto uTicks = uTick - node.uStartTick_;
+            node.uInclusiveTicks_ += uTicks;
+            node.uChildTicks_ += node.uPendingChildTicks_;
+            node.uPendingChildTicks_ = 0;
+            node.uCalls_++;
+            m_vecNodes[node.uParent_].uPendingChildTicks_ += uTicks;
+            m_uCurrent = node.uParent_;
+        }
+
+        // 按路径把other的计数加进来，节点不够时丢弃的次数计入GetDroppedCount
+        void Merge(const CPerfZoneTree &other) { MergeNode(other, 0, 0); m_uDropped += other.m_uDropped; }
+
+        // 计数清零，树的结构保留，正在进行中的打点不受影响
+        void ResetCounters()
+        {
+            for (auto &node : m_vecNodes)
+            {
+                node.uCalls_ = 0;
+                node.uInclusiveTicks_ = 0;
+                node.uChildTicks_ = 0;
+            }
+            m_uDropped = 0;
+        }
+
+        // 深度优先遍历，funcVisit(node, depth)，不访问根节点
+        template <typename Func>
+        void Visit(Func funcVisit) const
+        {
+            VisitNode(0, 0, funcVisit);
+        }
+
+        const ZoneNode &GetNode(uint32_t uIndex) const { return m_vecNodes[uIndex]; }
+        uint32_t GetNodeCount() const { return (uint32_t)m_vecNodes.size(); }
+        uint64_t GetDroppedCount() const { return m_uDropped; }
+
+        // 按名字路径查找节点，如{"a", "b"}，找不到返回nullptr
+        const ZoneNode *Find(const std::vector<std::string> &vecPath) const
+        {
+            uint32_t uIndex = 0;
+            for (auto &strName : vecPath)
+            {
+                uint32_t uChild = m_vecNodes[uIndex].uFirstChild_;
+                while (uChild != 0 && strName != m_vecNodes[uChild].lpSite_->lpName_)
+                {
+                    uChild = m_vecNodes[uChild].uNextSibling_;
+                }
+                if (uChild == 0)
+                {
+                    return nullptr;
+                }
+                uIndex = uChild;
+            }
+            return &m_vecNodes[uIndex];
+        }
+
+    private:
+        uint32_t FindChild(uint32_t uParent, const PerfZoneSite *lpSite, bool bCreate)
+        {
+            uint32_t uLast = 0;
+            for (auto uChild = m_vecNodes[uParent].uFirstChild_; uChild != 0; uChild = m_vecNodes[uChild].uNextSibling_)
+            {
+                if (m_vecNodes[uChild].lpSite_ == lpSite)
+                {
+                    return uChild;
+                }
+                uLast = uChild;
+            }
+            if (!bCreate || m_vecNodes.size() >= MaxZoneNodes)
+            {
+                return 0;
+            }
+
+            // 新节点挂在兄弟链表末尾，输出时保持第一次进入的顺序
+            auto uChild = (uint32_t)m_vecNodes.size();
+            m_vecNodes.emplace_back();
+            m_vecNodes[uChild].lpSite_ = lpSite;
+            m_vecNodes[uChild].uParent_ = uParent;
+            if (uLast == 0)
+            {
+                m_vecNodes[uParent].uFirstChild_ = uChild;
+            }
+            else
+            {
+                m_vecNodes[uLast].uNextSibling_ = uChild;
+            }
+            return uChild;
+        }
+
+        void MergeNode(const CPerfZoneTree &other, uint32_t uOther, uint32_t uSelf)
+        {
+            for (auto uChild = other.m_vecNodes[uOther].uFirstChild_; uChild != 0;
+                 uChild = other.m_vecNodes[uChild].uNextSibling_)
+            {
+                auto &src = other.m_vecNodes[uChild];
+                auto uDst = FindChild(uSelf, src.lpSite_, true);
+                if (uDst == 0)
+                {
+                    m_uDropped += src.uCalls_;
+                    continue;
+                }
+                m_vecNodes[uDst].uCalls_ += src.uCalls_;
+                m_vecNodes[uDst].uInclusiveTicks_ += src.uInclusiveTicks_;
+                m_vecNodes[uDst].uChildTicks_ += src.uChildTicks_;
+                MergeNode(other, uChild, uDst);
+            }
+        }
+
+        template <typename Func>
+        void VisitNode(uint32_t uIndex, uint32_t uDepth, Func &funcVisit) const
+        {
+            for (auto uChild = m_vecNodes[uIndex].uFirstChild_; uChild != 0; uChild = m_vecNodes[uChild].uNextSibling_)
+            {
+                funcVisit(m_vecNodes[uChild], uDepth);
+                VisitNode(uChild, uDepth + 1, funcVisit);
+            }
+        }
+
+    private:
+        std::vector<ZoneNode> m_vecNodes; // 0号是根节点
+        uint32_t m_uCurrent{0};
+        uint32_t m_uOverflowDepth{0}; // 大于0时正处在被丢弃的打点里
+        uint64_t m_uDropped{0};
+    };
+
+    // 每个线程写自己的调用树，线程退出或调用Flush时合并到全局树，打点本身不加锁。
+    // 输出只包含已合并的数据和调用线程自己的树，还在运行的其他线程需要先自己Flush
+    class CPerfZone
+    {
+        struct ThreadTree
+        {
+            CPerfZoneTree tree_;
+
+            ~ThreadTree() { CPerfZone::MergeGlobal(tree_); }
+        };
+
+        struct ZoneState
+        {
+            std::mutex lock_;
+            CPerfZoneTree tree_;
+        };
+
+    public:
+        static CPerfZoneTree &GetThreadTree()
+        {
+            static thread_local ThreadTree s_tree;
+            return s_tree.tree_;
+        }
+
+        // 把调用线程的计数合并到全局树并清零
+        static void Flush()
+        {
+            auto &tree = GetThreadTree();
+            MergeGlobal(tree);
+            tree.ResetCounters();
+        }
+
+        // 全局树加上调用线程自己的树
+        static void Snapshot(CPerfZoneTree &tree)
+        {
+            tree = CPerfZoneTree();
+            {
+                auto &state = GetState();
+                std::lock_guard<std::mutex> guard(state.lock_);
+                tree.Merge(state.tree_);
+            }
+            tree.Merge(GetThreadTree());
+        }
+
+        static void Reset()
+        {
+            {
+                auto &state = GetState();
+                std::lock_guard<std::mutex> guard(state.lock_);
+                state.tree_ = CPerfZoneTree();
+            }
+            GetThreadTree().ResetCounters();
+        }
+
+        // 缩进表示调用层次，时间单位ns
+        static void Print(FILE *fp = stdout)
+        {
+            CPerfZoneTree tree;
+            Snapshot(tree);
+            fprintf(fp, "%-40s %10s %14s %14s %10s\n", "zone", "calls", "inclusive", "exclusive", "avg");
+            tree.Visit([fp](const CPerfZoneTree::ZoneNode &node, uint32_t uDepth) {
+                char szName[41];
+                snprintf(szName, sizeof(szName), "%*s%s", uDepth * 2, "", node.lpSite_->lpName_);
+                auto uInclusive = CTscClock::TickToNano(node.uInclusiveTicks_);
+                fprintf(fp, "%-40s %10lu %14lu %14lu %10lu\n", szName, node.uCalls_, uInclusive,
+                        CTscClock::TickToNano(node.GetExclusiveTicks()), node.uCalls_ == 0 ? 0 : uInclusive / node.uCalls_);
+            });
+            if (tree.GetDroppedCount() != 0)
+            {
+                fprintf(fp, "dropped = %lu\n", tree.GetDroppedCount());
+            }
+        }
+
+        // 每个节点一行：用;连接的路径, calls, inclusive_ns, exclusive_ns
+        static int32_t Save(const char *lpPath)
+        {
+            auto fp = fopen(lpPath, "w");
+            if (fp == nullptr)
+            {
+                return 1;
+            }
+            CPerfZoneTree tree;
+            Snapshot(tree);
+            std::vector<const char *> vecPath;
+            tree.Visit([&](const CPerfZoneTree::ZoneNode &node, uint32_t uDepth) {
+                vecPath.resize(uDepth);
+                vecPath.push_back(node.lpSite_->lpName_);
+                for (uint32_t i = 0; i < vecPath.size(); i++)
+                {
+                    fprintf(fp, "%s%s", i == 0 ? "" : ";", vecPath[i]);
+                }
+                fprintf(fp, ", %lu, %lu, %lu\n", node.uCalls_, CTscClock::TickToNano(node.uInclusiveTicks_),
+                        CTscClock::TickToNano(node.GetExclusiveTicks()));
+            });
+            fclose(fp);
+            return 0;
+        }
+
+    private:
+        static ZoneState &GetState()
+        {
+            static ZoneState s_state;
+            return s_state;
+        }
+
+        static void MergeGlobal(const CPerfZoneTree &tree)
+        {
+            auto &state = GetState();
+            std::lock_guard<std::mutex> guard(state.lock_);
+            state.tree_.Merge(tree);
+        }
+    };
+
+    class CPerfZoneScope
+    {
+    public:
+        explicit CPerfZoneScope(const PerfZoneSite *lpSite) : m_tree(CPerfZone::GetThreadTree()) { m_tree.Enter(lpSite); }
+        ~CPerfZoneScope() { m_tree.Leave(); }
+        CPerfZoneScope(const CPerfZoneScope &) = delete;
+        CPerfZoneScope &operator=(const CPerfZoneScope &) = delete;
+
+    private:
+        CPerfZoneTree &m_tree;
+    };
+
+} // end namespace utility
+
+#endif //__PERF_ZONE_H
@@ -0,0 +1,393 @@
+#ifndef __PERSISTENT_OBJECT_POOL_H
+#define __PERSISTENT_OBJECT_POOL_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <utility/object_pool.h>
+
+namespace utility
+{
+
+    constexpr uint64_t PersistMagic = 0x4C4F4F5053525450ull; // "PTRSPOOL"
+    constexpr uint32_t PersistVersion = 1;
+    constexpr uint64_t PersistDataOffset = 4096; // 第一页放池头，块从第二页开始
+
+    // 对象放在内存映射文件或POSIX共享内存里的对象池，进程重启后重新映射即可继续使用。
+    // 映射里不存任何绝对地址：块按编号连续排列，对象所属的块和块内编号都由偏移算出，
+    // 映射到不同地址上也能直接用；进程内只保存由块位图重建出的未满块索引。
+    // 与CObjectPool一样不是线程安全的，同一时间只能有一个进程读写，其他进程可以只读映射
+    class CPersistentObjectPool
+    {
+        struct PersistHeader
+        {
+            uint64_t uMagic_; // 最后写入，创建到一半的映射不会通过校验
+            uint32_t uVersion_;
+            uint32_t uObjectSize_; // Init时传入的对象大小
+            uint32_t uSlotSize_;
+            uint32_t uBlockObjects_;
+            uint64_t uBlockBytes_;
+            uint64_t uDataOffset_;
+            uint64_t uMappingSize_;
+            uint32_t uMaxBlocks_;
+            uint32_t uBlockCount_; // 已经使用的块数量
+            uint64_t uRootOffset_; // 调用方的根对象，0表示没有
+            uint32_t uClean_;      // 正常UnInit时置1，映射期间为0
+            uint32_t uReserved_;
+        };
+
+        struct PersistBlock
+        {
+            uint16_t uCurrSize_; // 重新映射时由位图重算
+            uint16_t uWordFree_; // 第i位表示bitSetFree_[i]还有空闲
+            uint32_t uReserved_;
+            BitSetType bitSetFree_[BlockBitSize]; // 被使用的置零，空闲的置1
+            uint8_t pData_[];
+
+            void Reset()
+            {
+                uCurrSize_ = 0;
+                uWordFree_ = (uint16_t)((1u << BlockBitSize) - 1);
+                memset(bitSetFree_, 0xFF, sizeof(bitSetFree_));
+            }
+
+            // 位图是唯一可信的状态，其余字段都从位图推出来
+            void Rebuild()
+            {
+                uint32_t uFree = 0;
+                uWordFree_ = 0;
+                for (uint32_t i = 0; i < BlockBitSize; i++)
+                {
+                    uFree += __builtin_popcountll(bitSetFree_[i]);
+                    if (bitSetFree_[i] != 0)
+                    {
+                        uWordFree_ |= (uint16_t)(1u << i);
+                    }
+                }
+                uCurrSize_ = (uint16_t)(BlockObjectSize - uFree);
+            }
+        };
+
+    public:
+        enum : uint32_t
+        {
+            PersistShm = 0x01,      // lpName是shm_open的名字，否则是文件路径
+            PersistReadOnly = 0x02, // 只读映射已有的池，Get返回nullptr
+            PersistCreate = 0x04,   // 不存在时创建
+        };
+
+        CPersistentObjectPool() = default;
+        ~CPersistentObjectPool() { UnInit(); }
+        CPersistentObjectPool(const CPersistentObjectPool &) = delete;
+        CPersistentObjectPool &operator=(const CPersistentObjectPool &) = delete;
+
+        // 已有的映射通过校验时直接接管(IsReattached返回true)，uMaxBytes只在创建时使用；
+        // 已有的映射校验失败时返回1，不会覆盖，需要时先调用Remove
+        int32_t Init(const char *lpName, uint32_t uObjectSize, uint64_t uMaxBytes,
+                     uint32_t uFlags = PersistCreate)
+        {
+            UnInit();
+
+            if (lpName == nullptr || uObjectSize == 0)
+            {
+                return 1;
+            }
+            m_bReadOnly = (uFlags & PersistReadOnly) != 0;
+            int iOpenFlags = m_bReadOnly ? O_RDONLY : O_RDWR;
+            if ((uFlags & PersistCreate) && !m_bReadOnly)
+            {
+                iOpenFlags |= O_CREAT;
+            }
+            m_iFd = (uFlags & PersistShm) ? shm_open(lpName, iOpenFlags, 0600) : open(lpName, iOpenFlags, 0600);
+            if (m_iFd < 0)
+            {
+                return 1;
+            }
+
+            struct stat st;
+            if (fstat(m_iFd, &st) != 0)
+            {
+                UnInit();
+                return 1;
+            }
+            auto iRet = st.st_size == 0 ? Create(uObjectSize, uMaxBytes) : Attach(uObjectSize, (uint64_t)st.st_size);
+            if (iRet != 0)
+            {
+                UnInit();
+                return 1;
+            }
+            return 0;
+        }
+
+        void UnInit()
+        {
+            if (m_lpBase != nullptr)
+            {
+                if (!m_bReadOnly)
+                {
+                    GetHeader()->uClean_ = 1;
+                }
+                munmap(m_lpBase, m_uMappingSize);
+                m_lpBase = nullptr;
+            }
+            if (m_iFd >= 0)
+            {
+                close(m_iFd);
+                m_iFd = -1;
+            }
+            m_bitmapFree.UnInit();
+            m_uMappingSize = 0;
+            m_uCurrIndex = 0;
+            m_uLiveObjects = 0;
+            m_bReattached = false;
+            m_bReadOnly = false;
+        }
+
+        static int32_t Remove(const char *lpName, uint32_t uFlags = 0)
+        {
+            return ((uFlags & PersistShm) ? shm_unlink(lpName) : unlink(lpName)) == 0 ? 0 : 1;
+        }
+
+        void *Get()
+        {
+            if (unlikely(m_lpBase == nullptr || m_bReadOnly))
+            {
+                return nullptr;
+            }
+
+            auto lpBlock = GetBlock(m_uCurrIndex);
+            if (unlikely(m_uCurrIndex >= GetHeader()->uBlockCount_ || lpBlock->uCurrSize_ == BlockObjectSize))
+            {
+                lpBlock = FindFreeBlock();
+                if (unlikely(lpBlock == nullptr))
+                {
+                    return nullptr;
+                }
+            }
+
+            auto i = __builtin_ctz(lpBlock->uWordFree_);
+            auto idx = __builtin_ctzll(lpBlock->bitSetFree_[i]);
+            lpBlock->bitSetFree_[i] &= lpBlock->bitSetFree_[i] - 1;
+            if (lpBlock->bitSetFree_[i] == 0)
+            {
+                lpBlock->uWordFree_ &= ~(1u << i);
+            }
+            if (++lpBlock->uCurrSize_ == BlockObjectSize)
+            {
+                m_bitmapFree.Clear(m_uCurrIndex);
+            }
+            m_uLiveObjects++;
+            return &lpBlock->pData_[(size_t)((i << BitSetScale) + idx) * m_uSlotSize];
+        }
+
+        void Release(void *ptr)
+        {
+            if (unlikely(ptr == nullptr || m_bReadOnly))
+            {
+                return;
+            }
+
+            // 块号和块内编号都从偏移算出，不需要对象头
+            auto uOffset = (uint64_t)((uint8_t *)ptr - m_lpBase) - m_uDataOffset;
+            auto uBlockIndex = (uint32_t)(uOffset / m_uBlockBytes);
+            auto uObjIndex = (uint32_t)((uOffset - (uint64_t)uBlockIndex * m_uBlockBytes - sizeof(PersistBlock)) /
+                                        m_uSlotSize);
+            auto lpBlock = GetBlock(uBlockIndex);
+            if (unlikely(lpBlock->uCurrSize_ == BlockObjectSize))
+            {
+                m_bitmapFree.Set(uBlockIndex);
+            }
+            auto uWord = uObjIndex >> BitSetScale;
+            lpBlock->bitSetFree_[uWord] |= BitSetType(1) << (uObjIndex & ((1 << BitSetScale) - 1));
+            lpBlock->uWordFree_ |= (uint16_t)(1u << uWord);
+            lpBlock->uCurrSize_--;
+            m_uLiveObjects--;
+        }
+
+        // 映射内的指针与偏移互转，对象之间的引用应保存偏移，0表示空
+        uint64_t ToOffset(const void *ptr)
+        {
+            return ptr == nullptr ? 0 : (uint64_t)((const uint8_t *)ptr - m_lpBase);
+        }
+
+        void *FromOffset(uint64_t uOffset) { return uOffset == 0 ? nullptr : m_lpBase + uOffset; }
+
+        // 根对象用来在重新映射后找到调用方的数据结构
+        void SetRoot(void *ptr)
+        {
+            if (m_lpBase != nullptr && !m_bReadOnly)
+            {
+                GetHeader()->uRootOffset_ = ToOffset(ptr);
+            }
+        }
+
+        void *GetRoot() { return m_lpBase == nullptr ? nullptr : FromOffset(GetHeader()->uRootOffset_); }
+
+        // 刷到存储设备，只防止机器掉电；进程重启不需要调用
+        int32_t Sync() { return m_lpBase != nullptr && msync(m_lpBase, m_uMappingSize, MS_SYNC) == 0 ? 0 : 1; }
+
+        bool IsReattached() { return m_bReattached; }
+        // 上一个使用者是否正常UnInit，异常退出时块状态已经在接管时由位图重算
+        bool WasCleanShutdown() { return m_bWasClean; }
+        uint32_t GetBlockCount() { return m_lpBase == nullptr ? 0 : GetHeader()->uBlockCount_; }
+        uint32_t GetMaxBlockCount() { return m_lpBase == nullptr ? 0 : GetHeader()->uMaxBlocks_; }
+        uint64_t GetLiveObjectCount() { return m_uLiveObjects; }
+
+    private:
+        PersistHeader *GetHeader() { return (PersistHeader *)m_lpBase; }
+
+        PersistBlock *GetBlock(uint32_t uIndex)
+        {
+            return (PersistBlock *)(m_lpBase + m_uDataOffset + (uint64_t)uIndex * m_uBlockBytes);
+        }
+
+        int32_t Create(uint32_t uObjectSize, uint64_t uMaxBytes)
+        {
+            if (m_bReadOnly)
+            {
+                return 1;
+            }
+
+            m_uSlotSize = ALIGN8(uObjectSize);
+            m_uBlockBytes = ALIGN8(sizeof(PersistBlock) + (uint64_t)m_uSlotSize * BlockObjectSize);
+            m_uDataOffset = PersistDataOffset;
+            if (uMaxBytes < m_uDataOffset + m_uBlockBytes)
+            {
+                return 1;
+            }
+            auto uMaxBlocks = (uMaxBytes - m_uDataOffset) / m_uBlockBytes;
+            uMaxBlocks = uMaxBlocks > 0xFFFFFFFEull ? 0xFFFFFFFEull : uMaxBlocks;
+            m_uMappingSize = m_uDataOffset + uMaxBlocks * m_uBlockBytes;
+
+            // 文件是稀疏的，只有用到的块才占用存储
+            if (ftruncate(m_iFd, (off_t)m_uMappingSize) != 0 || Map() != 0 ||
+                m_bitmapFree.Init((uint32_t)uMaxBlocks) != 0)
+            {
+                return 1;
+            }
+
+            auto lpHeader = GetHeader();
+            lpHeader->uVersion_ = PersistVersion;
+            lpHeader->uObjectSize_ = uObjectSize;
+            lpHeader->uSlotSize_ = m_uSlotSize;
+            lpHeader->uBlockObjects_ = BlockObjectSize;
+            lpHeader->uBlockBytes_ = m_uBlockBytes;
+            lpHeader->uDataOffset_ = m_uDataOffset;
+            lpHeader->uMappingSize_ = m_uMappingSize;
+            lpHeader->uMaxBlocks_ = (uint32_t)uMaxBlocks;
+            lpHeader->uBlockCount_ = 0;
+            lpHeader->uRootOffset_ = 0;
+            lpHeader->uClean_ = 0;
+            __atomic_store_n(&lpHeader->uMagic_, PersistMagic, __ATOMIC_RELEASE);
+            m_bWasClean = true;
+            return 0;
+        }
+
+        int32_t Attach(uint32_t uObjectSize, uint64_t uFileSize)
+        {
+            if (uFileSize < sizeof(PersistHeader))
+            {
+                return 1;
+            }
+            m_uMappingSize = uFileSize;
+            if (Map() != 0)
+            {
+                return 1;
+            }
+
+            // 布局与当前的编译参数、调用方的对象大小都要一致
+            auto lpHeader = GetHeader();
+            if (__atomic_load_n(&lpHeader->uMagic_, __ATOMIC_ACQUIRE) != PersistMagic ||
+                lpHeader->uVersion_ != PersistVersion || lpHeader->uObjectSize_ != uObjectSize ||
+                lpHeader->uSlotSize_ != ALIGN8(uObjectSize) || lpHeader->uBlockObjects_ != BlockObjectSize ||
+                lpHeader->uBlockBytes_ != ALIGN8(sizeof(PersistBlock) + (uint64_t)lpHeader->uSlotSize_ * BlockObjectSize) ||
+                lpHeader->uDataOffset_ != PersistDataOffset || lpHeader->uMappingSize_ != uFileSize ||
+                lpHeader->uDataOffset_ + (uint64_t)lpHeader->uMaxBlocks_ * lpHeader->uBlockBytes_ > uFileSize ||
+                lpHeader->uBlockCount_ > lpHeader->uMaxBlocks_ || lpHeader->uRootOffset_ >= uFileSize)
+            {
+                return 1;
+            }
+
+            m_uSlotSize = lpHeader->uSlotSize_;
+            m_uBlockBytes = lpHeader->uBlockBytes_;
+            m_uDataOffset = lpHeader->uDataOffset_;
+            m_bWasClean = lpHeader->uClean_ != 0;
+            if (m_bitmapFree.Init(lpHeader->uMaxBlocks_) != 0)
+            {
+                return 1;
+            }
+
+            for (uint32_t i = 0; i < lpHeader->uBlockCount_; i++)
+            {
+                auto lpBlock = GetBlock(i);
+                if (!m_bReadOnly)
+                {
+                    lpBlock->Rebuild();
+                }
+                if (lpBlock->uCurrSize_ != BlockObjectSize)
+                {
+                    m_bitmapFree.Set(i);
+                }
+                m_uLiveObjects += lpBlock->uCurrSize_;
+            }
+            if (!m_bReadOnly)
+            {
+                lpHeader->uClean_ = 0;
+            }
+            m_bReattached = true;
+            return 0;
+        }
+
+        int32_t Map()
+        {
+            auto ptr = mmap(nullptr, m_uMappingSize, m_bReadOnly ? PROT_READ : PROT_READ | PROT_WRITE, MAP_SHARED,
+                            m_iFd, 0);
+            if (ptr == MAP_FAILED)
+            {
+                return 1;
+            }
+            m_lpBase = (uint8_t *)ptr;
+            return 0;
+        }
+
+        PersistBlock *FindFreeBlock()
+        {
+            auto uIndex = m_bitmapFree.FindNext(m_uCurrIndex);
+            if (likely(uIndex != CLevelBitmap::NotFound))
+            {
+                m_uCurrIndex = uIndex;
+                return GetBlock(uIndex);
+            }
+
+            // 映射大小在创建时固定，块用完后返回空
+            auto lpHeader = GetHeader();
+            if (unlikely(lpHeader->uBlockCount_ == lpHeader->uMaxBlocks_))
+            {
+                return nullptr;
+            }
+            m_uCurrIndex = lpHeader->uBlockCount_;
+            auto lpBlock = GetBlock(m_uCurrIndex);
+            lpBlock->Reset();
+            lpHeader->uBlockCount_++;
+            m_bitmapFree.Set(m_uCurrIndex);
+            return lpBlock;
+        }
+
+    private:
+        int m_iFd{-1};
+        uint8_t *m_lpBase{nullptr};
+        uint64_t m_uMappingSize{0};
+        uint64_t m_uBlockBytes{0};
+        uint64_t m_uDataOffset{0};
+        uint32_t m_uSlotSize{0};
+        uint32_t m_uCurrIndex{0};
+        uint64_t m_uLiveObjects{0};
+        bool m_bReattached{false};
+        bool m_bWasClean{false};
+        bool m_bReadOnly{false};
+        CLevelBitmap m_bitmapFree; // 第i位表示第i个块未满，进程内状态，接管时重建
+    };
+
+} // end namespace utility
+
+#endif //__PERSISTENT_OBJECT_POOL_H
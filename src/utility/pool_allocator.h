@@ -0,0 +1,143 @@
+#ifndef __POOL_ALLOCATOR_H
+#define __POOL_ALLOCATOR_H
+
+#include <utility/slab_allocator.h>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+#if __cplusplus >= 201703L
+#include <memory_resource>
+#endif
+
+namespace utility
+{
+
+    constexpr size_t SlabAlignment = 8; // CSlabAllocator保证的对齐
+
+    // 超过slab对齐要求的内存直接走posix_memalign，由调用方传回的对齐值区分释放路径
+    inline void *SlabAllocateAligned(CSlabAllocator *lpSlab, size_t uBytes, size_t uAlignment)
+    {
+        if (likely(uAlignment <= SlabAlignment))
+        {
+            return lpSlab->Allocate(uBytes);
+        }
+
+        void *ptr = nullptr;
+        if (posix_memalign(&ptr, uAlignment, uBytes) != 0)
+        {
+            return nullptr;
+        }
+        return ptr;
+    }
+
+    inline void SlabFreeAligned(CSlabAllocator *lpSlab, void *ptr, size_t uAlignment)
+    {
+        if (likely(uAlignment <= SlabAlignment))
+        {
+            lpSlab->Free(ptr);
+            return;
+        }
+        free(ptr);
+    }
+
+    // 满足标准分配器要求的适配器，容器通过rebind拿到节点类型后从slab对应的尺寸级别取内存
+    // 不持有slab，slab的生命周期要覆盖所有使用它的容器；与slab一样不是线程安全的
+    template <typename T>
+    class CPoolAllocator
+    {
+    public:
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::true_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        template <typename U>
+        struct rebind
+        {
+            using other = CPoolAllocator<U>;
+        };
+
+        explicit CPoolAllocator(CSlabAllocator *lpSlab) noexcept : m_lpSlab(lpSlab) {}
+
+        template <typename U>
+        CPoolAllocator(const CPoolAllocator<U> &other) noexcept : m_lpSlab(other.GetSlab())
+        {
+        }
+
+        T *allocate(size_t n)
+        {
+            // n * sizeof(T)溢出时会申请到过短的内存
+            if (unlikely(n > max_size()))
+            {
+                throw std::bad_array_new_length();
+            }
+            auto ptr = SlabAllocateAligned(m_lpSlab, n * sizeof(T), alignof(T));
+            if (unlikely(ptr == nullptr))
+            {
+                throw std::bad_alloc();
+            }
+            return (T *)ptr;
+        }
+
+        void deallocate(T *ptr, size_t) noexcept { SlabFreeAligned(m_lpSlab, ptr, alignof(T)); }
+
+        size_t max_size() const noexcept { return SIZE_MAX / sizeof(T); }
+
+        CSlabAllocator *GetSlab() const noexcept { return m_lpSlab; }
+
+    private:
+        CSlabAllocator *m_lpSlab;
+    };
+
+    template <typename T, typename U>
+    bool operator==(const CPoolAllocator<T> &lhs, const CPoolAllocator<U> &rhs) noexcept
+    {
+        return lhs.GetSlab() == rhs.GetSlab();
+    }
+
+    template <typename T, typename U>
+    bool operator!=(const CPoolAllocator<T> &lhs, const CPoolAllocator<U> &rhs) noexcept
+    {
+        return !(lhs == rhs);
+    }
+
+#if __cplusplus >= 201703L
+    // std::pmr::memory_resource适配器，pmr容器和polymorphic_allocator都可以直接使用
+    class CSlabMemoryResource : public std::pmr::memory_resource
+    {
+    public:
+        explicit CSlabMemoryResource(CSlabAllocator *lpSlab) noexcept : m_lpSlab(lpSlab) {}
+
+        CSlabAllocator *GetSlab() const noexcept { return m_lpSlab; }
+
+    protected:
+        void *do_allocate(size_t uBytes, size_t uAlignment) override
+        {
+            auto ptr = SlabAllocateAligned(m_lpSlab, uBytes, uAlignment);
+            if (unlikely(ptr == nullptr))
+            {
+                throw std::bad_alloc();
+            }
+            return ptr;
+        }
+
+        void do_deallocate(void *ptr, size_t, size_t uAlignment) override
+        {
+            SlabFreeAligned(m_lpSlab, ptr, uAlignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+        {
+            auto lpOther = dynamic_cast<const CSlabMemoryResource *>(&other);
+            return lpOther != nullptr && lpOther->m_lpSlab == m_lpSlab;
+        }
+
+    private:
+        CSlabAllocator *m_lpSlab;
+    };
+#endif
+
+} // end namespace utility
+
+#endif //__POOL_ALLOCATOR_H
@@ -0,0 +1,220 @@
+#ifndef __POOL_STATS_H
+#define __POOL_STATS_H
+
+#include <include/common.h>
+#include <utility/perf_profiler.h>
+#include <string>
+
+// 编译时定义OBJECT_POOL_STATS才统计，未定义时POOL_STATS展开为空，热路径没有任何开销
+#ifdef OBJECT_POOL_STATS
+#define POOL_STATS(expr) \
+    do                   \
+    {                    \
+        expr;            \
+    } while (0)
+#else
+#define POOL_STATS(expr) \
+    do                   \
+    {                    \
+    } while (0)
+#endif
+
+namespace utility
+{
+
+    constexpr uint32_t PoolScanHistSize = 16; // 第0格是距离0，第i格是[2^(i-1), 2^i)，最后一格包含更大的
+    constexpr uint32_t PoolEventSize = 64;    // 保留最近的事件数量
+
+    enum PoolEventType : uint32_t
+    {
+        PoolEventExpand = 0,  // 新申请了一个块
+        PoolEventCompact = 1, // 整理了环
+        PoolEventRecycle = 2, // 全空的块被移到队尾
+        PoolEventTrim = 3,    // 空闲块还给了系统
+    };
+
+    struct PoolEvent
+    {
+        uint64_t uTimeNano_; // CLOCK_MONOTONIC
+        uint32_t uType_;     // PoolEventType
+        uint32_t uBlocks_;   // 事件发生后块的数量
+    };
+
+    struct PoolStatsSnapshot
+    {
+        uint32_t uObjectSize_{0};
+        uint32_t uBlocks_{0};
+        uint32_t uIdleBlocks_{0};
+        uint32_t uCapSize_{0};
+        uint64_t uGets_{0};
+        uint64_t uReleases_{0};
+        uint64_t uGetFails_{0};
+        uint64_t uLiveObjects_{0};
+        uint64_t uPeakLiveObjects_{0};
+        uint64_t uExpands_{0};
+        uint64_t uCompacts_{0};
+        uint64_t uRecycles_{0};
+        uint64_t uTrimmedBlocks_{0};
+        uint64_t arrScanHist_[PoolScanHistSize]{}; // 当前块满了以后找到下一个可用块走过的环距离
+        uint32_t uEventCount_{0};
+        PoolEvent arrEvents_[PoolEventSize]{}; // 从旧到新
+
+        static const char *GetEventName(uint32_t uType)
+        {
+            static const char *s_arrNames[] = {"expand", "compact", "recycle", "trim"};
+            return uType < sizeof(s_arrNames) / sizeof(s_arrNames[0]) ? s_arrNames[uType] : "unknown";
+        }
+
+        std::string ToText() const
+        {
+            std::string strText;
+            char szBuf[256];
+            snprintf(szBuf, sizeof(szBuf),
+                     "object size = %u, blocks = %u, idle blocks = %u, cap = %u\n"
+                     "gets = %lu, releases = %lu, get fails = %lu, live = %lu, peak live = %lu\n",
+                     uObjectSize_, uBlocks_, uIdleBlocks_, uCapSize_, uGets_, uReleases_, uGetFails_, uLiveObjects_,
+                     uPeakLiveObjects_);
+            strText += szBuf;
+            snprintf(szBuf, sizeof(szBuf), "expands = %lu, compacts = %lu, recycles = %lu, trimmed blocks = %lu\n",
+                     uExpands_, uCompacts_, uRecycles_, uTrimmedBlocks_);
+            strText += szBuf;
+
+            strText += "scan length:";
+            for (uint32_t i = 0; i < PoolScanHistSize; i++)
+            {
+                if (arrScanHist_[i] != 0)
+                {
+                    snprintf(szBuf, sizeof(szBuf), " [%u]=%lu", i == 0 ? 0 : (1u << (i - 1)), arrScanHist_[i]);
+                    strText += szBuf;
+                }
+            }
+            strText += "\n";
+
+            for (uint32_t i = 0; i < uEventCount_; i++)
+            {
+                snprintf(szBuf, sizeof(szBuf), "event %lu %s blocks = %u\n", arrEvents_[i].uTimeNano_,
+                         GetEventName(arrEvents_[i].uType_), arrEvents_[i].uBlocks_);
+                strText += szBuf;
+            }
+            return strText;
+        }
+
+        std::string ToJson() const
+        {
+            std::string strJson;
+            char szBuf[512];
+            snprintf(szBuf, sizeof(szBuf),
+                     "{\"object_size\":%u,\"blocks\":%u,\"idle_blocks\":%u,\"cap\":%u,"
+                     "\"gets\":%lu,\"releases\":%lu,\"get_fails\":%lu,\"live\":%lu,\"peak_live\":%lu,"
+                     "\"expands\":%lu,\"compacts\":%lu,\"recycles\":%lu,\"trimmed_blocks\":%lu,\"scan_hist\":[",
+                     uObjectSize_, uBlocks_, uIdleBlocks_, uCapSize_, uGets_, uReleases_, uGetFails_, uLiveObjects_,
+                     uPeakLiveObjects_, uExpands_, uCompacts_, uRecycles_, uTrimmedBlocks_);
+            strJson += szBuf;
+            for (uint32_t i = 0; i < PoolScanHistSize; i++)
+            {
+                snprintf(szBuf, sizeof(szBuf), i == 0 ? "%lu" : ",%lu", arrScanHist_[i]);
+                strJson += szBuf;
+            }
+            strJson += "],\"events\":[";
+            for (uint32_t i = 0; i < uEventCount_; i++)
+            {
+                snprintf(szBuf, sizeof(szBuf), "%s{\"time_ns\":%lu,\"type\":\"%s\",\"blocks\":%u}", i == 0 ? "" : ",",
+                         arrEvents_[i].uTimeNano_, GetEventName(arrEvents_[i].uType_), arrEvents_[i].uBlocks_);
+                strJson += szBuf;
+            }
+            strJson += "]}";
+            return strJson;
+        }
+    };
+
+    // 单个池的统计数据，与池一样不是线程安全的
+    class CPoolStats
+    {
+    public:
+        void OnGet(uint64_t uCount)
+        {
+            m_uGets += uCount;
+            if (m_uGets - m_uReleases > m_uPeakLive)
+            {
+                m_uPeakLive = m_uGets - m_uReleases;
+            }
+        }
+
+        void OnGetFail() { m_uGetFails++; }
+        void OnRelease(uint64_t uCount) { m_uReleases += uCount; }
+
+        void OnScan(uint32_t uDistance)
+        {
+            uint32_t uSlot = uDistance == 0 ? 0 : 32 - __builtin_clz(uDistance);
+            m_arrScanHist[uSlot < PoolScanHistSize ? uSlot : PoolScanHistSize - 1]++;
+        }
+
+        void OnEvent(PoolEventType type, uint32_t uBlocks)
+        {
+            switch (type)
+            {
+            case PoolEventExpand:
+                m_uExpands++;
+                break;
+            case PoolEventCompact:
+                m_uCompacts++;
+                break;
+            case PoolEventRecycle:
+                m_uRecycles++;
+                break;
+            case PoolEventTrim:
+                m_uTrimmedBlocks++;
+                break;
+            }
+
+            timespec ts;
+            CPerfProfiler::GetTime(ts);
+            auto &event = m_arrEvents[m_uEventTotal % PoolEventSize];
+            event.uTimeNano_ = CPerfProfiler::GetTimeNano(ts);
+            event.uType_ = type;
+            event.uBlocks_ = uBlocks;
+            m_uEventTotal++;
+        }
+
+        void Fill(PoolStatsSnapshot &snapshot)
+        {
+            snapshot.uGets_ = m_uGets;
+            snapshot.uReleases_ = m_uReleases;
+            snapshot.uGetFails_ = m_uGetFails;
+            snapshot.uLiveObjects_ = m_uGets - m_uReleases;
+            snapshot.uPeakLiveObjects_ = m_uPeakLive;
+            snapshot.uExpands_ = m_uExpands;
+            snapshot.uCompacts_ = m_uCompacts;
+            snapshot.uRecycles_ = m_uRecycles;
+            snapshot.uTrimmedBlocks_ = m_uTrimmedBlocks;
+            memcpy(snapshot.arrScanHist_, m_arrScanHist, sizeof(m_arrScanHist));
+
+            // 事件环里按时间顺序拷出
+            auto uCount = m_uEventTotal < PoolEventSize ? (uint32_t)m_uEventTotal : PoolEventSize;
+            auto uFirst = m_uEventTotal - uCount;
+            for (uint32_t i = 0; i < uCount; i++)
+            {
+                snapshot.arrEvents_[i] = m_arrEvents[(uFirst + i) % PoolEventSize];
+            }
+            snapshot.uEventCount_ = uCount;
+        }
+
+        void Reset() { *this = CPoolStats(); }
+
+    private:
+        uint64_t m_uGets{0};
+        uint64_t m_uReleases{0};
+        uint64_t m_uGetFails{0};
+        uint64_t m_uPeakLive{0};
+        uint64_t m_uExpands{0};
+        uint64_t m_uCompacts{0};
+        uint64_t m_uRecycles{0};
+        uint64_t m_uTrimmedBlocks{0};
+        uint64_t m_uEventTotal{0};
+        uint64_t m_arrScanHist[PoolScanHistSize]{};
+        PoolEvent m_arrEvents[PoolEventSize]{};
+    };
+
+} // end namespace utility
+
+#endif //__POOL_STATS_H
@@ -0,0 +1,493 @@
+#ifndef __POOL_TRACE_H
+#define __POOL_TRACE_H
+
+#include <include/common.h>
+#include <utility/perf_profiler.h>
+#include <utility/tsc_clock.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// 编译时定义OBJECT_POOL_TRACE才记录，未定义时POOL_TRACE展开为空
+#ifdef OBJECT_POOL_TRACE
+#define POOL_TRACE(expr) \
+    do                   \
+    {                    \
+        expr;            \
+    } while (0)
+#else
+#define POOL_TRACE(expr) \
+    do                   \
+    {                    \
+    } while (0)
+#endif
+
+namespace utility
+{
+
+    constexpr uint32_t PoolTraceMagic = 0x54504F50; // "POPT"
+    constexpr uint32_t PoolTraceVersion = 1;
+    constexpr uint32_t PoolTraceBufferSize = 4096; // 每个线程攒够这么多条记录再写文件
+
+    enum PoolTraceType : uint32_t
+    {
+        PoolTraceGet = 0,
+        PoolTraceRelease = 1,
+    };
+
+    // 每条24字节
+    struct PoolTraceRecord
+    {
+        uint64_t uTimeNano_; // CLOCK_MONOTONIC
+        uint64_t uObjectId_; // 对象地址，只用来配对Get和Release
+        uint32_t uThreadId_; // 线程编号，从1开始
+        uint32_t uSizeType_; // 高31位是对象大小，最低位是PoolTraceType
+
+        uint32_t GetSize() const { return uSizeType_ >> 1; }
+        uint32_t GetType() const { return uSizeType_ & 1; }
+    };
+
+    struct PoolTraceFileHeader
+    {
+        uint32_t uMagic_;
+        uint32_t uVersion_;
+        uint32_t uRecordSize_;
+        uint32_t uReserved_;
+    };
+
+    // 进程内全局的记录器：每个线程先写自己的缓冲区，满了以后加锁追加到文件。
+    // 文件里的记录只在单个线程内有序，读取时再按时间排序
+    class CPoolTrace
+    {
+        struct ThreadBuffer;
+
+        struct TraceState
+        {
+            std::mutex lock_; // 保护文件和缓冲区列表
+            FILE *fp_{nullptr};
+            uint64_t uRecords_{0};
+            std::atomic<bool> bEnabled_{false};
+            std::atomic<uint32_t> uThreadSeq_{0};
+            std::vector<ThreadBuffer *> vecBuffers_;
+        };
+
+        struct ThreadBuffer
+        {
+            std::mutex lock_; // 只有Stop会和所属线程竞争
+            uint32_t uThreadId_{0};
+            uint32_t uCount_{0};
+            PoolTraceRecord arrRecords_[PoolTraceBufferSize];
+
+            ThreadBuffer()
+            {
+                uThreadId_ = ++GetState().uThreadSeq_;
+                std::lock_guard<std::mutex> guard(GetState().lock_);
+                GetState().vecBuffers_.push_back(this);
+            }
+
+            ~ThreadBuffer()
+            {
+                auto &state = GetState();
+                std::lock_guard<std::mutex> guard(state.lock_);
+                {
+                    std::lock_guard<std::mutex> guardBuffer(lock_);
+                    FlushLocked(state);
+                }
+                state.vecBuffers_.erase(std::find(state.vecBuffers_.begin(), state.vecBuffers_.end(), this));
+            }
+
+            // 调用方持有全局锁和缓冲区锁
+            void FlushLocked(TraceState &state)
+            {
+                if (uCount_ != 0 && state.fp_ != nullptr)
+                {
+                    state.uRecords_ += fwrite(arrRecords_, sizeof(PoolTraceRecord), uCount_, state.fp_);
+                }
+                uCount_ = 0;
+            }
+        };
+
+    public:
+        // 开始记录到lpPath，已经在记录时返回1
+        static int32_t Start(const char *lpPath)
+        {
+            auto &state = GetState();
+            std::lock_guard<std::mutex> guard(state.lock_);
+            if (state.fp_ != nullptr)
+            {
+                return 1;
+            }
+            state.fp_ = fopen(lpPath, "wb");
+            if (state.fp_ == nullptr)
+            {
+                return 1;
+            }
+            PoolTraceFileHeader header{PoolTraceMagic, PoolTraceVersion, sizeof(PoolTraceRecord), 0};
+            fwrite(&header, sizeof(header), 1, state.fp_);
+            state.uRecords_ = 0;
+            state.bEnabled_.store(true, std::memory_order_release);
+            return 0;
+        }
+
+        // 停止记录并把所有线程的缓冲区写入文件，返回写入的记录数
+        static uint64_t Stop()
+        {
+            auto &state = GetState();
+            state.bEnabled_.store(false, std::memory_order_release);
+            std::lock_guard<std::mutex> guard(state.lock_);
+            for (auto lpBuffer : state.vecBuffers_)
+            {
+                std::lock_guard<std::mutex> guardBuffer(lpBuffer->lock_);
+                lpBuffer->FlushLocked(state);
+            }
+            if (state.fp_ != nullptr)
+            {
+                fclose(state.fp_);
+                state.fp_ = nullptr;
+            }
+            return state.uRecords_;
+        }
+
+        static bool IsEnabled() { return GetState().bEnabled_.load(std::memory_order_relaxed); }
+
+        static void OnGet(void *ptr, uint32_t uSize)
+        {
+            if (unlikely(IsEnabled() && ptr != nullptr))
+            {
+                Append(ptr, uSize, PoolTraceGet);
+            }
+        }
+
+        static void OnRelease(void *ptr, uint32_t uSize)
+        {
+            if (unlikely(IsEnabled() && ptr != nullptr))
+            {
+                Append(ptr, uSize, PoolTraceRelease);
+            }
+        }
+
+        // 读取整个文件并按时间排序
+        static int32_t Load(const char *lpPath, std::vector<PoolTraceRecord> &vecRecords)
+        {
+            vecRecords.clear();
+            auto fp = fopen(lpPath, "rb");
+            if (fp == nullptr)
+            {
+                return 1;
+            }
+            PoolTraceFileHeader header;
+            if (fread(&header, sizeof(header), 1, fp) != 1 || header.uMagic_ != PoolTraceMagic ||
+                header.uVersion_ != PoolTraceVersion || header.uRecordSize_ != sizeof(PoolTraceRecord))
+            {
+                fclose(fp);
+                return 1;
+            }
+            PoolTraceRecord arrRecords[PoolTraceBufferSize];
+            size_t uRead = 0;
+            while ((uRead = fread(arrRecords, sizeof(PoolTraceRecord), PoolTraceBufferSize, fp)) > 0)
+            {
+                vecRecords.insert(vecRecords.end(), arrRecords, arrRecords + uRead);
+            }
+            fclose(fp);
+            std::stable_sort(vecRecords.begin(), vecRecords.end(),
+                             [](const PoolTraceRecord &a, const PoolTraceRecord &b) { return a.uTimeNano_ < b.uTimeNano_; });
+            return 0;
+        }
+
+    private:
+        static TraceState &GetState()
+        {
+            static TraceState s_state;
+            return s_state;
+        }
+
+        static void Append(void *ptr, uint32_t uSize, PoolTraceType type)
+        {
+            static thread_local ThreadBuffer s_buffer;
+            timespec ts;
+            CPerfProfiler::GetTime(ts);
+
+            std::lock_guard<std::mutex> guard(s_buffer.lock_);
+            auto &record = s_buffer.arrRecords_[s_buffer.uCount_++];
+            record.uTimeNano_ = CPerfProfiler::GetTimeNano(ts);
+            record.uObjectId_ = (uint64_t)ptr;
+            record.uThreadId_ = s_buffer.uThreadId_;
+            record.uSizeType_ = (uSize << 1) | type;
+            if (unlikely(s_buffer.uCount_ == PoolTraceBufferSize))
+            {
+                // 写文件时不持有自己的缓冲区锁，避免和Stop的加锁顺序相反
+                PoolTraceRecord arrRecords[PoolTraceBufferSize];
+                memcpy(arrRecords, s_buffer.arrRecords_, sizeof(arrRecords));
+                s_buffer.uCount_ = 0;
+                auto &state = GetState();
+                s_buffer.lock_.unlock();
+                {
+                    std::lock_guard<std::mutex> guardState(state.lock_);
+                    if (state.fp_ != nullptr)
+                    {
+                        state.uRecords_ += fwrite(arrRecords, sizeof(PoolTraceRecord), PoolTraceBufferSize, state.fp_);
+                    }
+                }
+                s_buffer.lock_.lock();
+            }
+        }
+    };
+
+    // 回放目标：按对象大小申请和释放，线程安全由目标自己保证
+    class IPoolReplayTarget
+    {
+    public:
+        virtual ~IPoolReplayTarget() = default;
+        virtual const char *GetName() = 0;
+        // 回放前按轨迹里出现过的所有对象大小做准备
+        virtual int32_t Prepare(const std::vector<uint32_t> &vecSizes) = 0;
+        virtual void *Get(uint32_t uSize) = 0;
+        virtual void Release(void *ptr, uint32_t uSize) = 0;
+    };
+
+    struct PoolReplayResult
+    {
+        uint64_t uOps_{0};
+        uint64_t uTimeNano_{0}; // 回放的墙钟时间
+        uint64_t uTimerNano_{0}; // 空计时的耗时，已从每次操作的延迟中扣除
+        uint64_t uP50_{0};
+        uint64_t uP90_{0};
+        uint64_t uP99_{0};
+        uint64_t uP999_{0};
+        uint64_t uMax_{0};
+        uint64_t uPeakLive_{0}; // 同时存活的对象数量峰值
+        uint32_t uThreads_{0};
+    };
+
+    // 把轨迹编译成回放用的操作序列：每个Get分配一个槽位，Release引用它配对的Get的槽位。
+    // 轨迹开始前申请的对象的Release和到结束都没有释放的Get都会被跳过或在回放后统一释放。
+    // 每次操作用CTscClock计时，再扣除空计时的耗时
+    class CPoolTraceReplayer
+    {
+        struct ReplayOp
+        {
+            uint32_t uSlot_;
+            uint32_t uSizeType_;
+        };
+
+    public:
+        int32_t Init(const std::vector<PoolTraceRecord> &vecRecords)
+        {
+            m_vecOps.clear();
+            m_vecMerged.clear();
+            m_vecSlotSizes.clear();
+            m_vecSizes.clear();
+            m_uSlots = 0;
+            m_uPeakLive = 0;
+
+            std::unordered_map<uint64_t, uint32_t> mapLive; // 对象 -> 槽位
+            std::unordered_map<uint32_t, uint32_t> mapThreads; // 线程编号 -> 回放线程下标
+            uint64_t uLive = 0;
+            for (auto &record : vecRecords)
+            {
+                uint32_t uSlot = 0;
+                if (record.GetType() == PoolTraceGet)
+                {
+                    uSlot = m_uSlots++;
+                    mapLive[record.uObjectId_] = uSlot;
+                    m_vecSlotSizes.push_back(record.GetSize());
+                    if (std::find(m_vecSizes.begin(), m_vecSizes.end(), record.GetSize()) == m_vecSizes.end())
+                    {
+                        m_vecSizes.push_back(record.GetSize());
+                    }
+                    m_uPeakLive = ++uLive > m_uPeakLive ? uLive : m_uPeakLive;
+                }
+                else
+                {
+                    auto iter = mapLive.find(record.uObjectId_);
+                    if (iter == mapLive.end())
+                    {
+                        continue;
+                    }
+                    uSlot = iter->second;
+                    mapLive.erase(iter);
+                    uLive--;
+                }
+
+                auto iterThread = mapThreads.find(record.uThreadId_);
+                if (iterThread == mapThreads.end())
+                {
+                    iterThread = mapThreads.emplace(record.uThreadId_, (uint32_t)m_vecOps.size()).first;
+                    m_vecOps.emplace_back();
+                }
+                m_vecOps[iterThread->second].push_back(ReplayOp{uSlot, record.uSizeType_});
+                m_vecMerged.push_back(ReplayOp{uSlot, record.uSizeType_});
+            }
+            return m_vecOps.empty() ? 1 : 0;
+        }
+
+        uint32_t GetThreadCount() { return (uint32_t)m_vecOps.size(); }
+        const std::vector<uint32_t> &GetSizes() { return m_vecSizes; }
+        uint64_t GetPeakLive() { return m_uPeakLive; }
+
+        // bThreaded为false时所有操作按时间顺序在当前线程执行；
+        // 为true时每个轨迹线程对应一个回放线程，跨线程释放等待配对的Get完成
+        int32_t Run(IPoolReplayTarget *lpTarget, bool bThreaded, PoolReplayResult &result)
+        {
+            if (lpTarget->Prepare(m_vecSizes) != 0)
+            {
+                return 1;
+            }
+
+            std::vector<std::atomic<void *>> vecSlots(m_uSlots);
+            for (auto &slot : vecSlots)
+            {
+                slot.store(nullptr, std::memory_order_relaxed);
+            }
+            std::vector<std::vector<uint32_t>> vecCosts(m_vecOps.size());
+            m_uTimerTicks = MeasureTimerTicks();
+
+            timespec begin, end;
+            CPerfProfiler::GetTime(begin);
+            if (bThreaded)
+            {
+                std::vector<std::thread> vecThreads;
+                for (uint32_t i = 0; i < m_vecOps.size(); i++)
+                {
+                    vecThreads.emplace_back([&, i]() { RunOps(lpTarget, m_vecOps[i], vecSlots, vecCosts[i]); });
+                }
+                for (auto &th : vecThreads)
+                {
+                    th.join();
+                }
+            }
+            else
+            {
+                RunMerged(lpTarget, vecSlots, vecCosts[0]);
+            }
+            CPerfProfiler::GetTime(end);
+
+            // 没有释放的对象不计入耗时
+            for (uint32_t i = 0; i < m_uSlots; i++)
+            {
+                auto ptr = vecSlots[i].load(std::memory_order_relaxed);
+                if (ptr != nullptr && ptr != ReleasedMark())
+                {
+                    lpTarget->Release(ptr, m_vecSlotSizes[i]);
+                }
+            }
+
+            std::vector<uint32_t> vecAll;
+            for (auto &vecCost : vecCosts)
+            {
+                vecAll.insert(vecAll.end(), vecCost.begin(), vecCost.end());
+            }
+            std::sort(vecAll.begin(), vecAll.end());
+            result = PoolReplayResult();
+            result.uOps_ = vecAll.size();
+            result.uTimeNano_ = CPerfProfiler::GetTimeDiffNano(begin, end);
+            result.uTimerNano_ = CTscClock::TickToNano(m_uTimerTicks);
+            result.uPeakLive_ = m_uPeakLive;
+            result.uThreads_ = bThreaded ? (uint32_t)m_vecOps.size() : 1;
+            if (!vecAll.empty())
+            {
+                result.uP50_ = CTscClock::TickToNano(vecAll[vecAll.size() / 2]);
+                result.uP90_ = CTscClock::TickToNano(vecAll[vecAll.size() * 9 / 10]);
+                result.uP99_ = CTscClock::TickToNano(vecAll[vecAll.size() * 99 / 100]);
+                result.uP999_ = CTscClock::TickToNano(vecAll[vecAll.size() * 999 / 1000]);
+                result.uMax_ = CTscClock::TickToNano(vecAll.back());
+            }
+            return 0;
+        }
+
+    private:
+        static void *ReleasedMark() { return (void *)uintptr_t(1); }
+
+        // 空计时取多次中的最小值，单次操作只有几纳秒，不扣除时延迟主要是计时本身
+        static uint64_t MeasureTimerTicks()
+        {
+            uint64_t uMin = UINT64_MAX;
+            for (uint32_t i = 0; i < 1000; i++)
+            {
+                auto uBegin = CTscClock::GetTick();
+                auto uEnd = CTscClock::GetTickEnd();
+                uMin = uEnd - uBegin < uMin ? uEnd - uBegin : uMin;
+            }
+            return uMin;
+        }
+
+        // 扣除空计时后的tick数
+        uint32_t GetCost(uint64_t uBegin, uint64_t uEnd)
+        {
+            auto uTicks = uEnd - uBegin;
+            uTicks = uTicks > m_uTimerTicks ? uTicks - m_uTimerTicks : 0;
+            return uTicks > UINT32_MAX ? UINT32_MAX : (uint32_t)uTicks;
+        }
+
+        // 执行一个操作，返回耗时的tick数
+        uint32_t RunOp(IPoolReplayTarget *lpTarget, const ReplayOp &op, std::vector<std::atomic<void *>> &vecSlots)
+        {
+            auto uSize = op.uSizeType_ >> 1;
+            if ((op.uSizeType_ & 1) == PoolTraceGet)
+            {
+                auto uBegin = CTscClock::GetTick();
+                auto ptr = lpTarget->Get(uSize);
+                auto uEnd = CTscClock::GetTickEnd();
+                if (ptr != nullptr)
+                {
+                    *(volatile uint8_t *)ptr = 0; // 模拟使用方的首次写入
+                }
+                // 申请失败时标记为已释放，配对的Release直接跳过
+                vecSlots[op.uSlot_].store(ptr != nullptr ? ptr : ReleasedMark(), std::memory_order_release);
+                return GetCost(uBegin, uEnd);
+            }
+
+            // 跨线程释放时等待另一个线程完成配对的Get
+            void *ptr = nullptr;
+            while ((ptr = vecSlots[op.uSlot_].load(std::memory_order_acquire)) == nullptr)
+            {
+                std::this_thread::yield();
+            }
+            if (ptr == ReleasedMark())
+            {
+                return 0;
+            }
+            vecSlots[op.uSlot_].store(ReleasedMark(), std::memory_order_relaxed);
+            auto uBegin = CTscClock::GetTick();
+            lpTarget->Release(ptr, uSize);
+            auto uEnd = CTscClock::GetTickEnd();
+            return GetCost(uBegin, uEnd);
+        }
+
+        void RunOps(IPoolReplayTarget *lpTarget, const std::vector<ReplayOp> &vecOps,
+                    std::vector<std::atomic<void *>> &vecSlots, std::vector<uint32_t> &vecCost)
+        {
+            vecCost.reserve(vecOps.size());
+            for (auto &op : vecOps)
+            {
+                vecCost.push_back(RunOp(lpTarget, op, vecSlots));
+            }
+        }
+
+        // 单线程回放：所有操作按轨迹里的时间顺序执行
+        void RunMerged(IPoolReplayTarget *lpTarget, std::vector<std::atomic<void *>> &vecSlots,
+                       std::vector<uint32_t> &vecCost)
+        {
+            vecCost.reserve(m_vecMerged.size());
+            for (auto &op : m_vecMerged)
+            {
+                vecCost.push_back(RunOp(lpTarget, op, vecSlots));
+            }
+        }
+
+    private:
+        std::vector<std::vector<ReplayOp>> m_vecOps; // 每个轨迹线程的操作
+        std::vector<ReplayOp> m_vecMerged;           // 所有操作按时间排列
+        std::vector<uint32_t> m_vecSlotSizes;        // 每个槽位的对象大小
+        std::vector<uint32_t> m_vecSizes;            // 出现过的对象大小
+        uint32_t m_uSlots{0};
+        uint64_t m_uPeakLive{0};
+        uint64_t m_uTimerTicks{0}; // 空计时的tick数
+    };
+
+} // end namespace utility
+
+#endif //__POOL_TRACE_H
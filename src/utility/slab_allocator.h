@@ -0,0 +1,163 @@
+#ifndef __SLAB_ALLOCATOR_H
+#define __SLAB_ALLOCATOR_H
+
+#include <utility/object_pool.h>
+
+namespace utility
+{
+
+    constexpr uint32_t MinSizeClass = 16;
+    constexpr uint32_t DefaultMaxSizeClass = 64 * 1024;
+    constexpr uint32_t MaxSizeClassCount = 64;
+    constexpr uint32_t LargeObjectHeadSize = 16; // 大对象头部，保证返回地址16字节对齐
+
+    // 多尺寸分配器：按几何级数划分尺寸级别，每一级一个CObjectPool，每个2的幂区间分两级
+    // (16, 24, 32, 48, 64, 96 ...)，内部碎片不超过1/3；超过最大级别的走malloc
+    // Free通过对象头找到所属的池，不需要传入大小；与CObjectPool一样不是线程安全的
+    class CSlabAllocator
+    {
+    public:
+        CSlabAllocator() = default;
+        ~CSlabAllocator() { UnInit(); }
+        CSlabAllocator(const CSlabAllocator &) = delete;
+        CSlabAllocator &operator=(const CSlabAllocator &) = delete;
+
+        // uMaxClassSize必须是2的幂；各级的池在第一次用到时才创建
+        int32_t Init(uint32_t uMaxClassSize = DefaultMaxSizeClass, const ObjectPoolOption &option = ObjectPoolOption())
+        {
+            UnInit();
+
+            if (uMaxClassSize < MinSizeClass || (uMaxClassSize & (uMaxClassSize - 1)) != 0)
+            {
+                return 1;
+            }
+
+            m_uClassCount = GetSizeClass(uMaxClassSize) + 1;
+            m_uMaxClassSize = uMaxClassSize;
+            m_option = option;
+            m_option.uInitBlockCount = 0;
+            return 0;
+        }
+
+        void UnInit()
+        {
+            for (uint32_t i = 0; i < m_uClassCount; i++)
+            {
+                if (m_bInited[i])
+                {
+                    m_arrPools[i].UnInit();
+                    m_bInited[i] = false;
+                }
+            }
+            m_uClassCount = 0;
+            m_uMaxClassSize = 0;
+        }
+
+        // 返回的内存8字节对齐，大对象16字节对齐
+        void *Allocate(size_t uSize)
+        {
+            if (unlikely(uSize > m_uMaxClassSize))
+            {
+                return AllocateLarge(uSize);
+            }
+
+            auto uClass = GetSizeClass((uint32_t)uSize);
+            if (unlikely(!m_bInited[uClass]))
+            {
+                if (m_arrPools[uClass].Init(GetClassSize(uClass), nullptr, m_option) != 0)
+                {
+                    m_arrPools[uClass].UnInit();
+                    return nullptr;
+                }
+                m_bInited[uClass] = true;
+            }
+            return m_arrPools[uClass].Get();
+        }
+
+        void Free(void *ptr)
+        {
+            if (unlikely(ptr == nullptr))
+            {
+                return;
+            }
+
+            if (unlikely(CObjectPool::IsForeignObject(ptr)))
+            {
+                free((uint8_t *)ptr - LargeObjectHeadSize);
+                return;
+            }
+            CObjectPool::GetOwnerPool(ptr)->Release(ptr);
+        }
+
+        // 分配时实际可用的大小
+        static size_t GetUsableSize(void *ptr)
+        {
+            if (CObjectPool::IsForeignObject(ptr))
+            {
+                return (size_t)CObjectPool::GetForeignTag(ptr);
+            }
+            return CObjectPool::GetOwnerPool(ptr)->GetObjectSize();
+        }
+
+        // 把所有级别多余的空闲块还给系统
+        void Trim()
+        {
+            for (uint32_t i = 0; i < m_uClassCount; i++)
+            {
+                if (m_bInited[i])
+                {
+                    m_arrPools[i].Trim();
+                }
+            }
+        }
+
+        static uint32_t GetSizeClass(uint32_t uSize)
+        {
+            if (uSize <= MinSizeClass)
+            {
+                return 0;
+            }
+
+            // uSize落在(2^p, 2^(p+1)]，前半段(2^p, 1.5*2^p]是奇数级，后半段是偶数级
+            uint32_t p = 31 - __builtin_clz(uSize - 1);
+            uint32_t uHalf = (1u << p) + (1u << (p - 1));
+            return 2 * (p - 4) + (uSize > uHalf ? 2 : 1);
+        }
+
+        static uint32_t GetClassSize(uint32_t uClass)
+        {
+            if (uClass == 0)
+            {
+                return MinSizeClass;
+            }
+
+            uint32_t k = (uClass - 1) / 2;
+            return (uClass & 1) ? (3u << (k + 3)) : (1u << (k + 5));
+        }
+
+    private:
+        // 大对象头部的最后8字节按池对象头的格式标记，tag记录大小
+        void *AllocateLarge(size_t uSize)
+        {
+            auto lpRaw = (uint8_t *)malloc(LargeObjectHeadSize + uSize);
+            if (unlikely(lpRaw == nullptr))
+            {
+                return nullptr;
+            }
+
+            auto ptr = lpRaw + LargeObjectHeadSize;
+            CObjectPool::MarkForeignObject(ptr, uSize);
+            return ptr;
+        }
+
+    private:
+        uint32_t m_uClassCount{0};
+        uint32_t m_uMaxClassSize{0};
+        ObjectPoolOption m_option;
+        bool m_bInited[MaxSizeClassCount]{};
+        CObjectPool m_arrPools[MaxSizeClassCount];
+    };
+
+} // end namespace utility
+
+#endif //__SLAB_ALLOCATOR_H
@@ -0,0 +1,353 @@
+#ifndef __THREAD_HEAP_OBJECT_POOL_H
+#define __THREAD_HEAP_OBJECT_POOL_H
+
+#include <atomic>
+#include <mutex>
+#include <utility/object_pool.h>
+
+namespace utility
+{
+
+    constexpr uint32_t MaxThreadHeapPools = 16; // 单个线程最多同时持有堆的池数量
+    constexpr uint32_t RemoteDrainBatchSize = 64;
+
+    // 按线程划分所有权的对象池：每个线程有自己的堆(一个CObjectPool)，块只属于一个堆。
+    // 本线程归还的对象直接放回自己的堆；其他线程归还的对象无锁压入所属堆的远程释放链表(MPSC)，
+    // 由所属线程在下一次Get时批量取回，生产者/消费者之间不需要共享锁。
+    // 线程退出时堆里还有对象在外面的，堆被挂到孤儿链表，由之后新来的线程接管
+    class CThreadHeapObjectPool
+    {
+        struct RemoteNode
+        {
+            RemoteNode *lpNext_;
+        };
+
+        struct ThreadHeap : public CObjectPool
+        {
+            CThreadHeapObjectPool *lpPool_{nullptr}; // 池已销毁时置空，受全局锁保护
+            uint64_t uPoolId_{0};
+            std::atomic<RemoteNode *> lpRemoteHead_{nullptr};
+            ThreadHeap *lpPrev_{nullptr};
+            ThreadHeap *lpNext_{nullptr};
+        };
+
+        // 线程退出时交出自己的堆
+        struct ThreadHeapTable
+        {
+            ThreadHeap *lppHeaps_[MaxThreadHeapPools]{nullptr};
+
+            ~ThreadHeapTable()
+            {
+                std::lock_guard<std::mutex> guard(GetRegistryLock());
+                for (uint32_t i = 0; i < MaxThreadHeapPools; i++)
+                {
+                    AbandonHeapLocked(lppHeaps_[i]);
+                    lppHeaps_[i] = nullptr;
+                }
+            }
+
+            // 回收已销毁池遗留的槽位，调用方持有全局锁
+            void SweepLocked()
+            {
+                for (uint32_t i = 0; i < MaxThreadHeapPools; i++)
+                {
+                    if (lppHeaps_[i] != nullptr && lppHeaps_[i]->lpPool_ == nullptr)
+                    {
+                        delete lppHeaps_[i];
+                        lppHeaps_[i] = nullptr;
+                    }
+                }
+            }
+        };
+
+    public:
+        CThreadHeapObjectPool() = default;
+        ~CThreadHeapObjectPool() { UnInit(); }
+        CThreadHeapObjectPool(const CThreadHeapObjectPool &) = delete;
+        CThreadHeapObjectPool &operator=(const CThreadHeapObjectPool &) = delete;
+
+        // 对象内存的前8字节在远程释放时被用作链表指针，所以不支持构造函数
+        int32_t Init(uint32_t uObjectSize, const ObjectPoolOption &option = ObjectPoolOption())
+        {
+            UnInit();
+
+            std::lock_guard<std::mutex> guard(m_lock);
+            m_uObjectSize = uObjectSize < sizeof(RemoteNode) ? sizeof(RemoteNode) : uObjectSize;
+            m_option = option;
+            if (InitHeap(&m_sharedHeap) != 0)
+            {
+                m_sharedHeap.UnInit();
+                return 1;
+            }
+            m_uPoolId = NextPoolId();
+            return 0;
+        }
+
+        void UnInit()
+        {
+            std::lock_guard<std::mutex> guard(GetRegistryLock());
+            std::lock_guard<std::mutex> guardPool(m_lock);
+            if (m_uPoolId == 0)
+            {
+                return;
+            }
+
+            // 线程持有的堆由线程自己释放，这里只释放块并断开关联
+            for (auto lpHeap = m_lpHeaps; lpHeap != nullptr; lpHeap = lpHeap->lpNext_)
+            {
+                lpHeap->UnInit();
+                lpHeap->lpPool_ = nullptr;
+            }
+            m_lpHeaps = nullptr;
+
+            while (m_lpOrphanHeaps != nullptr)
+            {
+                auto lpNext = m_lpOrphanHeaps->lpNext_;
+                m_lpOrphanHeaps->UnInit();
+                delete m_lpOrphanHeaps;
+                m_lpOrphanHeaps = lpNext;
+            }
+
+            m_sharedHeap.UnInit();
+            m_sharedHeap.lpRemoteHead_.store(nullptr, std::memory_order_relaxed);
+            m_uPoolId = 0;
+        }
+
+        void *Get()
+        {
+            auto lpHeap = GetThreadHeap();
+            if (unlikely(lpHeap == nullptr))
+            {
+                std::lock_guard<std::mutex> guard(m_lock);
+                DrainRemote(&m_sharedHeap);
+                return m_sharedHeap.Get();
+            }
+
+            if (unlikely(lpHeap->lpRemoteHead_.load(std::memory_order_relaxed) != nullptr))
+            {
+                DrainRemote(lpHeap);
+            }
+            return lpHeap->Get();
+        }
+
+        // 可以在任意线程释放任意线程申请的对象
+        void Release(void *ptr)
+        {
+            if (unlikely(ptr == nullptr))
+            {
+                return;
+            }
+
+            auto lpOwnerHeap = static_cast<ThreadHeap *>(CObjectPool::GetOwnerPool(ptr));
+            if (likely(lpOwnerHeap == FindThreadHeap()))
+            {
+                lpOwnerHeap->Release(ptr);
+                return;
+            }
+
+            // Treiber栈压入，只有所属线程会整体取走，不存在ABA
+            auto lpNode = (RemoteNode *)ptr;
+            auto lpHead = lpOwnerHeap->lpRemoteHead_.load(std::memory_order_relaxed);
+            do
+            {
+                lpNode->lpNext_ = lpHead;
+            } while (!lpOwnerHeap->lpRemoteHead_.compare_exchange_weak(lpHead, lpNode, std::memory_order_release,
+                                                                       std::memory_order_relaxed));
+        }
+
+        // 线程已退出、等待被接管的堆数量
+        uint32_t GetOrphanHeapCount()
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            uint32_t uCount = 0;
+            for (auto lpHeap = m_lpOrphanHeaps; lpHeap != nullptr; lpHeap = lpHeap->lpNext_)
+            {
+                uCount++;
+            }
+            return uCount;
+        }
+
+    private:
+        static std::mutex &GetRegistryLock()
+        {
+            static std::mutex s_lock;
+            return s_lock;
+        }
+
+        static uint64_t NextPoolId()
+        {
+            static std::atomic<uint64_t> s_uPoolId{0};
+            return ++s_uPoolId;
+        }
+
+        static ThreadHeapTable &GetThreadHeapTable()
+        {
+            static thread_local ThreadHeapTable s_table;
+            return s_table;
+        }
+
+        // 调用方持有全局锁
+        static void AbandonHeapLocked(ThreadHeap *lpHeap)
+        {
+            if (lpHeap == nullptr)
+            {
+                return;
+            }
+
+            if (lpHeap->lpPool_ == nullptr || lpHeap->lpPool_->DetachHeap(lpHeap))
+            {
+                delete lpHeap;
+            }
+        }
+
+        int32_t InitHeap(ThreadHeap *lpHeap)
+        {
+            lpHeap->lpPool_ = this;
+            return lpHeap->Init(m_uObjectSize, nullptr, m_option);
+        }
+
+        // 只查找不创建
+        ThreadHeap *FindThreadHeap()
+        {
+            auto &table = GetThreadHeapTable();
+            for (uint32_t i = 0; i < MaxThreadHeapPools; i++)
+            {
+                if (likely(table.lppHeaps_[i] != nullptr && table.lppHeaps_[i]->uPoolId_ == m_uPoolId))
+                {
+                    return table.lppHeaps_[i];
+                }
+            }
+            return nullptr;
+        }
+
+        ThreadHeap *GetThreadHeap()
+        {
+            auto lpHeap = FindThreadHeap();
+            if (likely(lpHeap != nullptr))
+            {
+                return lpHeap;
+            }
+            return CreateThreadHeap(GetThreadHeapTable());
+        }
+
+        ThreadHeap *CreateThreadHeap(ThreadHeapTable &table)
+        {
+            std::lock_guard<std::mutex> guard(GetRegistryLock());
+            if (unlikely(m_uPoolId == 0))
+            {
+                return nullptr;
+            }
+            table.SweepLocked();
+
+            uint32_t uSlot = MaxThreadHeapPools;
+            for (uint32_t i = 0; i < MaxThreadHeapPools; i++)
+            {
+                if (table.lppHeaps_[i] == nullptr)
+                {
+                    uSlot = i;
+                    break;
+                }
+            }
+            if (unlikely(uSlot == MaxThreadHeapPools))
+            {
+                return nullptr;
+            }
+
+            std::lock_guard<std::mutex> guardPool(m_lock);
+            // 优先接管退出线程留下的堆
+            auto lpHeap = m_lpOrphanHeaps;
+            if (lpHeap != nullptr)
+            {
+                m_lpOrphanHeaps = lpHeap->lpNext_;
+            }
+            else
+            {
+                lpHeap = new (std::nothrow) ThreadHeap();
+                if (unlikely(lpHeap == nullptr))
+                {
+                    return nullptr;
+                }
+                if (unlikely(InitHeap(lpHeap) != 0))
+                {
+                    lpHeap->UnInit();
+                    delete lpHeap;
+                    return nullptr;
+                }
+                lpHeap->uPoolId_ = m_uPoolId;
+            }
+
+            lpHeap->lpPrev_ = nullptr;
+            lpHeap->lpNext_ = m_lpHeaps;
+            if (m_lpHeaps != nullptr)
+            {
+                m_lpHeaps->lpPrev_ = lpHeap;
+            }
+            m_lpHeaps = lpHeap;
+
+            table.lppHeaps_[uSlot] = lpHeap;
+            return lpHeap;
+        }
+
+        // 线程退出，调用方持有全局锁；返回true表示堆已经没有对象在外面，可以直接删除
+        bool DetachHeap(ThreadHeap *lpHeap)
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            if (lpHeap->lpPrev_ != nullptr)
+            {
+                lpHeap->lpPrev_->lpNext_ = lpHeap->lpNext_;
+            }
+            else
+            {
+                m_lpHeaps = lpHeap->lpNext_;
+            }
+            if (lpHeap->lpNext_ != nullptr)
+            {
+                lpHeap->lpNext_->lpPrev_ = lpHeap->lpPrev_;
+            }
+
+            // 取回远程释放的对象后所有块都空闲，说明不会再有线程往这个堆里还对象
+            DrainRemote(lpHeap);
+            if (lpHeap->GetIdleBlockCount() == lpHeap->GetBlockCount())
+            {
+                lpHeap->UnInit();
+                return true;
+            }
+
+            lpHeap->lpPrev_ = nullptr;
+            lpHeap->lpNext_ = m_lpOrphanHeaps;
+            m_lpOrphanHeaps = lpHeap;
+            return false;
+        }
+
+        // 只能由堆的所属线程调用(共享堆和孤儿堆由m_lock保护)
+        static void DrainRemote(ThreadHeap *lpHeap)
+        {
+            auto lpNode = lpHeap->lpRemoteHead_.exchange(nullptr, std::memory_order_acquire);
+            void *lppObjs[RemoteDrainBatchSize];
+            uint32_t uCount = 0;
+            while (lpNode != nullptr)
+            {
+                lppObjs[uCount++] = lpNode;
+                lpNode = lpNode->lpNext_;
+                if (uCount == RemoteDrainBatchSize)
+                {
+                    lpHeap->ReleaseBatch(lppObjs, uCount);
+                    uCount = 0;
+                }
+            }
+            lpHeap->ReleaseBatch(lppObjs, uCount);
+        }
+
+    private:
+        uint64_t m_uPoolId{0};
+        uint32_t m_uObjectSize{0};
+        ObjectPoolOption m_option;
+        ThreadHeap *m_lpHeaps{nullptr};       // 有线程持有的堆
+        ThreadHeap *m_lpOrphanHeaps{nullptr}; // 线程已退出但还有对象在外面的堆
+        std::mutex m_lock;                    // 保护堆链表和共享堆
+        ThreadHeap m_sharedHeap;              // 线程槽位用完时退回到加锁的共享堆
+    };
+
+} // end namespace utility
+
+#endif //__THREAD_HEAP_OBJECT_POOL_H
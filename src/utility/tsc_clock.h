@@ -0,0 +1,138 @@
+#ifndef __TSC_CLOCK_H
+#define __TSC_CLOCK_H
+
+#include <include/common.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define TSC_CLOCK_X86 1
+#endif
+
+namespace utility
+{
+    constexpr uint64_t TscCalibrateNano = 5 * 1000 * 1000; // 校准时忙等的时长
+
+    // 基于不变TSC的时间戳：热路径只读TSC，换算成纳秒放到输出时再做。
+    // CPU不支持不变TSC(或不是x86)时退化为clock_gettime，此时tick就是纳秒
+    class CTscClock
+    {
+        struct TscState
+        {
+            bool bTsc_{false};
+            double dTicksPerNano_{1.0};
+
+            TscState()
+            {
+                if (!IsInvariantTscSupported())
+                {
+                    return;
+                }
+                dTicksPerNano_ = Calibrate();
+                bTsc_ = dTicksPerNano_ > 0.0;
+                if (!bTsc_)
+                {
+                    dTicksPerNano_ = 1.0;
+                }
+            }
+        };
+
+    public:
+        // 测量开始处使用：lfence保证之前的指令都已执行完再读TSC
+        static uint64_t GetTick()
+        {
+#ifdef TSC_CLOCK_X86
+            if (likely(GetState().bTsc_))
+            {
+                _mm_lfence();
+                return __rdtsc();
+            }
+#endif
+            return GetMonotonicNano();
+        }
+
+        // 测量结束处使用：rdtscp等待之前的指令完成，lfence阻止之后的指令提前执行
+        static uint64_t GetTickEnd()
+        {
+#ifdef TSC_CLOCK_X86
+            if (likely(GetState().bTsc_))
+            {
+                uint32_t uAux;
+                auto uTick = __rdtscp(&uAux);
+                _mm_lfence();
+                return uTick;
+            }
+#endif
+            return GetMonotonicNano();
+        }
+
+        static uint64_t TickToNano(uint64_t uTicks) { return uint64_t(uTicks / GetState().dTicksPerNano_); }
+
+        static bool IsTscEnabled() { return GetState().bTsc_; }
+
+        static double GetTicksPerNano() { return GetState().dTicksPerNano_; }
+
+    private:
+        static TscState &GetState()
+        {
+            static TscState s_state;
+            return s_state;
+        }
+
+        static uint64_t GetMonotonicNano()
+        {
+            timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return uint64_t(ts.tv_sec * 1000000000 + ts.tv_nsec);
+        }
+
+        // CPUID 0x80000007 EDX bit8 表示不变TSC，0x80000001 EDX bit27 表示支持rdtscp
+        static bool IsInvariantTscSupported()
+        {
+#ifdef TSC_CLOCK_X86
+            uint32_t eax, ebx, ecx, edx;
+            if (__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) == 0 || eax < 0x80000007)
+            {
+                return false;
+            }
+            __get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx);
+            if ((edx & (1u << 27)) == 0)
+            {
+                return false;
+            }
+            __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+            return (edx & (1u << 8)) != 0;
+#else
+            return false;
+#endif
+        }
+
+        // 用CLOCK_MONOTONIC计时忙等一小段时间，得到每纳秒的tick数；TSC倒退时返回0
+        static double Calibrate()
+        {
+#ifdef TSC_CLOCK_X86
+            auto uNanoBegin = GetMonotonicNano();
+            _mm_lfence();
+            auto uTickBegin = __rdtsc();
+            uint64_t uNanoEnd = uNanoBegin;
+            while (uNanoEnd - uNanoBegin < TscCalibrateNano)
+            {
+                uNanoEnd = GetMonotonicNano();
+            }
+            _mm_lfence();
+            auto uTickEnd = __rdtsc();
+            if (uTickEnd <= uTickBegin)
+            {
+                return 0.0;
+            }
+            return double(uTickEnd - uTickBegin) / double(uNanoEnd - uNanoBegin);
+#else
+            return 0.0;
+#endif
+        }
+    };
+
+} // end namespace utility
+
+#endif //__TSC_CLOCK_H
@@ -0,0 +1,274 @@
+#ifndef __TYPED_OBJECT_POOL_H
+#define __TYPED_OBJECT_POOL_H
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <utility/object_pool.h>
+
+namespace utility
+{
+
+    // 类型化对象池：对象步长和位图大小都是编译期常量，Get/Release可被完全内联
+    // Recycle为false时Get原地构造、Release析构；为true时对象在块创建时默认构造一次，
+    // Get/Release只借出和归还，直到UnInit才析构
+    template <typename T, uint32_t BlockObjects = BlockObjectSize, bool Recycle = false>
+    class CTypedObjectPool
+    {
+        static_assert(BlockObjects > 0 && BlockObjects % (sizeof(BitSetType) * 8) == 0,
+                      "BlockObjects must be a multiple of 64");
+        static_assert(BlockObjects <= 65536, "object index is 16 bits");
+
+        static constexpr uint32_t BitSetCount = BlockObjects / (sizeof(BitSetType) * 8);
+
+        struct ObjectBlock;
+
+        struct ElemHead
+        {
+            uint64_t pOwnerBlock_ : 48; // 所属的块指针
+            uint64_t uObjIndex_ : 16;   // 在块中的编号
+
+            ObjectBlock *GetOwnerBlockPtr() { return reinterpret_cast<ObjectBlock *>(pOwnerBlock_); }
+            uint32_t GetObjIndex() { return (uint32_t)uObjIndex_; }
+        };
+
+        struct Slot
+        {
+            ElemHead head_;
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type data_;
+
+            T *GetObject() { return reinterpret_cast<T *>(&data_); }
+        };
+
+        struct ObjectBlock
+        {
+            uint32_t uCurrSize_;                 // 当前被使用的数量
+            uint32_t uIndex_;                    // 当前块在pool中索引
+            BitSetType bitSetFree_[BitSetCount]; // 被使用的置零，空闲的置1
+            Slot slots_[BlockObjects];
+
+            void Reset(uint32_t _uIndex)
+            {
+                uCurrSize_ = 0;
+                uIndex_ = _uIndex;
+                memset(bitSetFree_, 0XFF, sizeof(bitSetFree_));
+                for (uint32_t i = 0; i < BlockObjects; i++)
+                {
+                    slots_[i].head_.pOwnerBlock_ = (uint64_t)this;
+                    slots_[i].head_.uObjIndex_ = i;
+                }
+            }
+
+            bool IsEmpty() { return uCurrSize_ == BlockObjects; }
+
+            Slot *GetSlot()
+            {
+                for (uint32_t i = 0; i < BitSetCount; i++)
+                {
+                    if (bitSetFree_[i] != 0)
+                    {
+                        unsigned long idx = 0;
+#ifdef _WIN32
+                        _BitScanForward64(&idx, bitSetFree_[i]);
+#else
+                        idx = __builtin_ctzll(bitSetFree_[i]);
+#endif
+                        bitSetFree_[i] &= bitSetFree_[i] - 1;
+                        uCurrSize_++;
+                        return &slots_[(i << BitSetScale) + idx];
+                    }
+                }
+
+                return nullptr;
+            }
+
+            void ReleaseSlot(uint32_t uObjIndex)
+            {
+                bitSetFree_[uObjIndex >> BitSetScale] |= BitSetType(1) << (uObjIndex & ((1 << BitSetScale) - 1));
+                uCurrSize_--;
+            }
+
+            bool IsUsed(uint32_t uObjIndex)
+            {
+                return (bitSetFree_[uObjIndex >> BitSetScale] & (BitSetType(1) << (uObjIndex & ((1 << BitSetScale) - 1)))) == 0;
+            }
+        };
+
+    public:
+        CTypedObjectPool() = default;
+        ~CTypedObjectPool() { UnInit(); }
+        CTypedObjectPool(const CTypedObjectPool &) = delete;
+        CTypedObjectPool &operator=(const CTypedObjectPool &) = delete;
+
+        int32_t Init(uint32_t uInitBlockCount = 1)
+        {
+            UnInit();
+
+            for (uint32_t i = 0; i < uInitBlockCount; i++)
+            {
+                if (Expand() == nullptr)
+                {
+                    return 1;
+                }
+            }
+
+            return 0;
+        }
+
+        void UnInit()
+        {
+            for (auto lpBlock : m_vecBlocks)
+            {
+                for (uint32_t i = 0; i < BlockObjects; i++)
+                {
+                    // 回收模式下所有对象都是活的，否则只析构未归还的对象
+                    if (Recycle || lpBlock->IsUsed(i))
+                    {
+                        lpBlock->slots_[i].GetObject()->~T();
+                    }
+                }
+                FreeBlock(lpBlock);
+            }
+            m_vecBlocks.clear();
+            m_lpCurrBlock = nullptr;
+        }
+
+        template <typename... Args>
+        T *Get(Args &&...args)
+        {
+            static_assert(!Recycle || sizeof...(Args) == 0, "recycled objects are constructed once by the pool");
+
+            if (unlikely(m_lpCurrBlock == nullptr || m_lpCurrBlock->IsEmpty()))
+            {
+                if (unlikely(FindFreeBlock() == nullptr))
+                {
+                    return nullptr;
+                }
+            }
+
+            auto lpSlot = m_lpCurrBlock->GetSlot();
+            auto lpObj = lpSlot->GetObject();
+            if (!Recycle)
+            {
+                // 构造函数抛异常时先归还槽位，否则槽位泄漏，UnInit还会析构没构造过的对象
+                try
+                {
+                    new (lpObj) T(std::forward<Args>(args)...);
+                }
+                catch (...)
+                {
+                    m_lpCurrBlock->ReleaseSlot(lpSlot->head_.GetObjIndex());
+                    throw;
+                }
+            }
+            return lpObj;
+        }
+
+        void Release(T *ptr)
+        {
+            if (unlikely(ptr == nullptr))
+            {
+                return;
+            }
+
+            if (!Recycle)
+            {
+                ptr->~T();
+            }
+
+            auto lpSlot = reinterpret_cast<Slot *>((uint8_t *)ptr - offsetof(Slot, data_));
+            auto lpOwnerBlock = lpSlot->head_.GetOwnerBlockPtr();
+            lpOwnerBlock->ReleaseSlot(lpSlot->head_.GetObjIndex());
+            // 当前块已满时，直接切换到刚有空位的块，省去下次Get的查找
+            if (unlikely(m_lpCurrBlock->IsEmpty()))
+            {
+                m_lpCurrBlock = lpOwnerBlock;
+            }
+        }
+
+        uint32_t GetBlockCount() { return (uint32_t)m_vecBlocks.size(); }
+
+    private:
+        ObjectBlock *FindFreeBlock()
+        {
+            for (auto lpBlock : m_vecBlocks)
+            {
+                if (!lpBlock->IsEmpty())
+                {
+                    m_lpCurrBlock = lpBlock;
+                    return lpBlock;
+                }
+            }
+
+            m_lpCurrBlock = Expand();
+            return m_lpCurrBlock;
+        }
+
+        ObjectBlock *Expand()
+        {
+            void *ptr = nullptr;
+            constexpr size_t uAlign = alignof(ObjectBlock) < sizeof(void *) ? sizeof(void *) : alignof(ObjectBlock);
+#ifdef OS_WIN
+            ptr = _aligned_malloc(sizeof(ObjectBlock), uAlign);
+#else
+            if (posix_memalign(&ptr, uAlign, sizeof(ObjectBlock)) != 0)
+            {
+                ptr = nullptr;
+            }
+#endif
+            if (unlikely(ptr == nullptr))
+            {
+                return nullptr;
+            }
+
+            auto lpNewBlock = (ObjectBlock *)ptr;
+            lpNewBlock->Reset((uint32_t)m_vecBlocks.size());
+            ConstructBlock(lpNewBlock, std::integral_constant<bool, Recycle>());
+
+            m_vecBlocks.push_back(lpNewBlock);
+            return lpNewBlock;
+        }
+
+        // 回收模式下整块预先构造，非回收模式不要求T可默认构造。
+        // 构造抛异常时析构已构造的对象并释放块，块还没加入m_vecBlocks
+        static void ConstructBlock(ObjectBlock *lpBlock, std::true_type)
+        {
+            uint32_t i = 0;
+            try
+            {
+                for (; i < BlockObjects; i++)
+                {
+                    new (lpBlock->slots_[i].GetObject()) T();
+                }
+            }
+            catch (...)
+            {
+                while (i > 0)
+                {
+                    lpBlock->slots_[--i].GetObject()->~T();
+                }
+                FreeBlock(lpBlock);
+                throw;
+            }
+        }
+
+        static void ConstructBlock(ObjectBlock *, std::false_type) {}
+
+        static void FreeBlock(ObjectBlock *lpBlock)
+        {
+#ifdef OS_WIN
+            _aligned_free(lpBlock);
+#else
+            free(lpBlock);
+#endif
+        }
+
+    private:
+        ObjectBlock *m_lpCurrBlock{nullptr};
+        std::vector<ObjectBlock *> m_vecBlocks;
+    };
+
+} // end namespace utility
+
+#endif //__TYPED_OBJECT_POOL_H
@@ -0,0 +1,264 @@
+// 用记录下来的Get/Release轨迹驱动各种池和malloc，对比吞吐、延迟分位数和内存峰值。
+// 每个目标在单独的子进程里回放，互不影响内存峰值
+#include <utility/object_pool.h>
+#include <utility/slab_allocator.h>
+#include <utility/magazine_object_pool.h>
+#include <utility/thread_heap_object_pool.h>
+#include <utility/percpu_object_pool.h>
+#include <utility/lockfree_object_pool.h>
+#include <utility/pool_trace.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <memory>
+#include <string>
+
+using namespace utility;
+
+class CMallocTarget : public IPoolReplayTarget
+{
+public:
+    const char *GetName() override { return "malloc"; }
+    int32_t Prepare(const std::vector<uint32_t> &vecSizes) override { return 0; }
+    void *Get(uint32_t uSize) override { return malloc(uSize); }
+    void Release(void *ptr, uint32_t uSize) override { free(ptr); }
+};
+
+// 每种对象大小一个池；bLocked为true时用一把锁保护所有池
+template <typename Pool>
+class CPerSizeTarget : public IPoolReplayTarget
+{
+public:
+    CPerSizeTarget(const char *lpName, bool bLocked, std::function<int32_t(Pool &, uint32_t)> funcInit)
+        : m_lpName(lpName), m_bLocked(bLocked), m_funcInit(funcInit)
+    {
+    }
+
+    const char *GetName() override { return m_lpName; }
+
+    int32_t Prepare(const std::vector<uint32_t> &vecSizes) override
+    {
+        for (auto uSize : vecSizes)
+        {
+            m_vecPools.emplace_back(new Pool());
+            if (m_funcInit(*m_vecPools.back(), uSize) != 0)
+            {
+                return 1;
+            }
+            m_mapPools[uSize] = m_vecPools.back().get();
+        }
+        return 0;
+    }
+
+    void *Get(uint32_t uSize) override
+    {
+        auto lpPool = m_mapPools.find(uSize)->second;
+        if (m_bLocked)
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            return lpPool->Get();
+        }
+        return lpPool->Get();
+    }
+
+    void Release(void *ptr, uint32_t uSize) override
+    {
+        auto lpPool = m_mapPools.find(uSize)->second;
+        if (m_bLocked)
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            lpPool->Release(ptr);
+            return;
+        }
+        lpPool->Release(ptr);
+    }
+
+private:
+    const char *m_lpName;
+    bool m_bLocked;
+    std::function<int32_t(Pool &, uint32_t)> m_funcInit;
+    std::mutex m_lock;
+    std::vector<std::unique_ptr<Pool>> m_vecPools;
+    std::unordered_map<uint32_t, Pool *> m_mapPools;
+};
+
+class CSlabTarget : public IPoolReplayTarget
+{
+public:
+    explicit CSlabTarget(bool bLocked) : m_bLocked(bLocked) {}
+
+    const char *GetName() override { return "slab"; }
+
+    int32_t Prepare(const std::vector<uint32_t> &vecSizes) override { return m_slab.Init(); }
+
+    void *Get(uint32_t uSize) override
+    {
+        if (m_bLocked)
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            return m_slab.Allocate(uSize);
+        }
+        return m_slab.Allocate(uSize);
+    }
+
+    void Release(void *ptr, uint32_t uSize) override
+    {
+        if (m_bLocked)
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            m_slab.Free(ptr);
+            return;
+        }
+        m_slab.Free(ptr);
+    }
+
+private:
+    bool m_bLocked;
+    std::mutex m_lock;
+    CSlabAllocator m_slab;
+};
+
+static IPoolReplayTarget *CreateTarget(const std::string &strName, bool bThreaded)
+{
+    if (strName == "malloc")
+    {
+        return new CMallocTarget();
+    }
+    if (strName == "object")
+    {
+        return new CPerSizeTarget<CObjectPool>("object", bThreaded,
+                                               [](CObjectPool &pool, uint32_t uSize) { return pool.Init(uSize); });
+    }
+    if (strName == "slab")
+    {
+        return new CSlabTarget(bThreaded);
+    }
+    if (strName == "magazine")
+    {
+        return new CPerSizeTarget<CMagazineObjectPool>(
+            "magazine", false, [](CMagazineObjectPool &pool, uint32_t uSize) { return pool.Init(uSize); });
+    }
+    if (strName == "thread_heap")
+    {
+        return new CPerSizeTarget<CThreadHeapObjectPool>(
+            "thread_heap", false, [](CThreadHeapObjectPool &pool, uint32_t uSize) { return pool.Init(uSize); });
+    }
+    if (strName == "percpu")
+    {
+        return new CPerSizeTarget<CPerCpuObjectPool>(
+            "percpu", false, [](CPerCpuObjectPool &pool, uint32_t uSize) { return pool.Init(uSize); });
+    }
+    if (strName == "lockfree")
+    {
+        return new CPerSizeTarget<CLockFreeObjectPool>(
+            "lockfree", false, [](CLockFreeObjectPool &pool, uint32_t uSize) { return pool.Init(uSize); });
+    }
+    return nullptr;
+}
+
+// 当前常驻内存，单位KB
+static uint64_t GetCurrentRss()
+{
+    uint64_t uSize = 0, uResident = 0;
+    auto fp = fopen("/proc/self/statm", "r");
+    if (fp != nullptr)
+    {
+        if (fscanf(fp, "%lu %lu", &uSize, &uResident) != 2)
+        {
+            uResident = 0;
+        }
+        fclose(fp);
+    }
+    return uResident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static int32_t RunTarget(CPoolTraceReplayer &replayer, const std::string &strName, bool bThreaded)
+{
+    std::unique_ptr<IPoolReplayTarget> target(CreateTarget(strName, bThreaded));
+    if (target == nullptr)
+    {
+        fprintf(stderr, "unknown target %s\n", strName.c_str());
+        return 1;
+    }
+
+    auto uBaseRss = GetCurrentRss();
+    PoolReplayResult result;
+    if (replayer.Run(target.get(), bThreaded, result) != 0)
+    {
+        fprintf(stderr, "%s: prepare fail\n", strName.c_str());
+        return 1;
+    }
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    auto uPeakRss = (uint64_t)usage.ru_maxrss;
+
+    printf("%s,%u,%lu,%.0f,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu\n", target->GetName(), result.uThreads_, result.uOps_,
+           result.uTimeNano_ == 0 ? 0.0 : result.uOps_ * 1e9 / result.uTimeNano_, result.uP50_, result.uP90_,
+           result.uP99_, result.uP999_, result.uMax_, result.uTimerNano_, uPeakRss,
+           uPeakRss > uBaseRss ? uPeakRss - uBaseRss : 0);
+    fflush(stdout);
+    return 0;
+}
+
+int main(int argc, const char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <trace> [-t] [target ...]\n", argv[0]);
+        fprintf(stderr, "  -t      replay each traced thread on its own thread, default replays in time order\n");
+        fprintf(stderr, "  target  malloc object slab magazine thread_heap percpu lockfree, default all\n");
+        fprintf(stderr, "latency is timed with TSC ticks (clock_gettime without an invariant TSC) and has\n"
+                        "the empty timer cost, reported as timer_ns, subtracted\n");
+        return 1;
+    }
+
+    bool bThreaded = false;
+    std::vector<std::string> vecTargets;
+    for (int i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-t") == 0)
+        {
+            bThreaded = true;
+        }
+        else
+        {
+            vecTargets.push_back(argv[i]);
+        }
+    }
+    if (vecTargets.empty())
+    {
+        vecTargets = {"malloc", "object", "slab", "magazine", "thread_heap", "percpu", "lockfree"};
+    }
+
+    CPoolTraceReplayer replayer;
+    {
+        std::vector<PoolTraceRecord> vecRecords;
+        if (CPoolTrace::Load(argv[1], vecRecords) != 0 || replayer.Init(vecRecords) != 0)
+        {
+            fprintf(stderr, "load %s fail\n", argv[1]);
+            return 1;
+        }
+        fprintf(stderr, "records = %lu, threads = %u, sizes = %lu, peak live = %lu\n", vecRecords.size(),
+                replayer.GetThreadCount(), replayer.GetSizes().size(), replayer.GetPeakLive());
+    }
+
+    // 延迟单位ns，已扣除空计时的耗时timer_ns；内存单位KB
+    printf("target,threads,ops,ops_per_sec,p50_ns,p90_ns,p99_ns,p999_ns,max_ns,timer_ns,peak_rss_kb,replay_rss_kb\n");
+    fflush(stdout);
+    int32_t iRet = 0;
+    for (auto &strName : vecTargets)
+    {
+        auto pid = fork();
+        if (pid == 0)
+        {
+            _exit(RunTarget(replayer, strName, bThreaded));
+        }
+        int iStatus = 0;
+        if (pid < 0 || waitpid(pid, &iStatus, 0) != pid || !WIFEXITED(iStatus) || WEXITSTATUS(iStatus) != 0)
+        {
+            fprintf(stderr, "%s: replay fail\n", strName.c_str());
+            iRet = 1;
+        }
+    }
+    return iRet;
+}
@@ -0,0 +1,7 @@
+#!/bin/bash
+
+target=pool_replay.out
+
+rm $target
+g++ -O2 -DNDEBUG main.cpp -I ../../src -o $target -lpthread -std=c++11
+./$target "$@"
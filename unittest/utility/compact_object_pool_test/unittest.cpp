@@ -0,0 +1,222 @@
+#include <utility/compact_object_pool.h>
+#include <utility/perf_profiler.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace utility;
+
+struct ObjSmall
+{
+    uint64_t uKey;
+    uint64_t uValue;
+};
+
+void CaseLayout()
+{
+    PRINT_INFO("=================");
+    // 各种大小的对象都能正确找回编号，不越界、不重叠
+    for (uint32_t uSize : {1u, 3u, 4u, 8u, 12u, 16u, 24u, 40u, 100u, 1000u, 4000u})
+    {
+        CCompactObjectPool pool;
+        if (pool.Init(uSize) != 0)
+        {
+            PRINT_FAIL("pool Init Fail, size = %u", uSize);
+            exit(1);
+        }
+
+        uint32_t count = pool.GetBlockObjects() * 4;
+        std::vector<uint8_t *> vecObjs;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            auto ptr = (uint8_t *)pool.Get();
+            if (ptr == nullptr || ((uintptr_t)ptr & (std::min(pool.GetSlotSize(), 8u) - 1)) != 0)
+            {
+                PRINT_ERROR("size %u Get Fail, ptr = %p", uSize, ptr);
+                exit(1);
+            }
+            memset(ptr, (uint8_t)i, uSize);
+            vecObjs.push_back(ptr);
+        }
+
+        std::shuffle(vecObjs.begin(), vecObjs.end(), std::mt19937(uSize));
+        for (uint32_t i = 0; i < count / 2; i++)
+        {
+            pool.Release(vecObjs[i]);
+        }
+        // 释放的位置要能被再次申请到，说明编号计算正确
+        std::vector<uint8_t *> vecAgain;
+        for (uint32_t i = 0; i < count / 2; i++)
+        {
+            vecAgain.push_back((uint8_t *)pool.Get());
+        }
+        std::sort(vecAgain.begin(), vecAgain.end());
+        std::vector<uint8_t *> vecReleased(vecObjs.begin(), vecObjs.begin() + count / 2);
+        std::sort(vecReleased.begin(), vecReleased.end());
+        if (vecAgain != vecReleased || pool.GetBlockCount() != 4)
+        {
+            PRINT_ERROR("size %u reuse fail, blocks = %u", uSize, pool.GetBlockCount());
+            exit(1);
+        }
+        for (uint32_t i = count / 2; i < count; i++)
+        {
+            auto ptr = vecObjs[i];
+            if (ptr[0] != ptr[uSize - 1])
+            {
+                PRINT_ERROR("size %u object %p overwritten", uSize, ptr);
+                exit(1);
+            }
+        }
+        printf("size = %4u, slot = %4u, block = %7u, objects per block = %u\n", uSize, pool.GetSlotSize(),
+               pool.GetBlockSize(), pool.GetBlockObjects());
+    }
+    PRINT_INFO("=================");
+}
+
+void CaseTrim()
+{
+    PRINT_INFO("=================");
+    CCompactObjectPool pool;
+    pool.Init(sizeof(ObjSmall), 1024, 0);
+    std::vector<void *> vecObjs;
+    for (uint32_t i = 0; i < pool.GetBlockObjects() * 10; i++)
+    {
+        vecObjs.push_back(pool.Get());
+    }
+    // 留下第一个和最后一个块各一个对象
+    for (uint32_t i = 1; i + 1 < vecObjs.size(); i++)
+    {
+        pool.Release(vecObjs[i]);
+    }
+    auto uFreed = pool.Trim();
+    if (pool.GetIdleBlockCount() > 1 || pool.GetBlockCount() > 3 || uFreed < 7)
+    {
+        PRINT_ERROR("Trim fail, blocks = %u, idle = %u, freed = %u", pool.GetBlockCount(), pool.GetIdleBlockCount(),
+                    uFreed);
+        exit(1);
+    }
+    for (uint32_t i = 0; i < pool.GetBlockObjects() * 10; i++)
+    {
+        vecObjs[i] = pool.Get();
+    }
+    pool.UnInit();
+
+    // 满的块被挪到空闲块的位置后，不能再被当成有空位的块
+    pool.Init(sizeof(ObjSmall), 64, 1);
+    auto uObjects = pool.GetBlockObjects();
+    vecObjs.clear();
+    for (uint32_t i = 0; i < uObjects * 3; i++)
+    {
+        vecObjs.push_back(pool.Get());
+    }
+    for (uint32_t i = 0; i <= uObjects; i++)
+    {
+        pool.Release(vecObjs[i]);
+    }
+    uFreed = pool.Trim();
+    if (uFreed != 1 || pool.GetBlockCount() != 2)
+    {
+        PRINT_ERROR("Trim fail, blocks = %u, freed = %u", pool.GetBlockCount(), uFreed);
+        exit(1);
+    }
+    auto lpObj = (ObjSmall *)pool.Get();
+    if (lpObj != vecObjs[uObjects])
+    {
+        PRINT_ERROR("Get after trim fail, %p != %p", (void *)lpObj, vecObjs[uObjects]);
+        exit(1);
+    }
+    lpObj->uValue = 1;
+    pool.Release(lpObj);
+    for (uint32_t i = uObjects + 1; i < vecObjs.size(); i++)
+    {
+        pool.Release(vecObjs[i]);
+    }
+    pool.UnInit();
+    PRINT_INFO("=================");
+}
+
+// 16字节对象：占用内存，以及按申请顺序遍历全部对象的耗时
+void CasePerf()
+{
+    PRINT_INFO("=================");
+    constexpr uint32_t count = 1 << 21;
+    std::vector<ObjSmall *> vecObjs(count);
+    timespec begin, end;
+
+    CObjectPool pool;
+    ObjectPoolOption option;
+    option.uInitBlockCount = 0;
+    pool.Init(sizeof(ObjSmall), nullptr, option);
+    CPerfProfiler::GetTime(begin);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        vecObjs[i] = (ObjSmall *)pool.Get();
+        vecObjs[i]->uValue = i;
+    }
+    CPerfProfiler::GetTime(end);
+    auto uPoolGet = CPerfProfiler::GetTimeDiffNano(begin, end) / count;
+    uint64_t uSum = 0;
+    CPerfProfiler::GetTime(begin);
+    for (uint32_t n = 0; n < 10; n++)
+    {
+        for (auto ptr : vecObjs)
+        {
+            uSum += ptr->uValue;
+        }
+    }
+    CPerfProfiler::GetTime(end);
+    auto uPoolScan = CPerfProfiler::GetTimeDiffNano(begin, end) / (count * 10);
+    auto uPoolBytes = (uint64_t)pool.GetBlockCount() * (sizeof(ObjSmall) + 8) * BlockObjectSize;
+    CPerfProfiler::GetTime(begin);
+    for (auto ptr : vecObjs)
+    {
+        pool.Release(ptr);
+    }
+    CPerfProfiler::GetTime(end);
+    auto uPoolRelease = CPerfProfiler::GetTimeDiffNano(begin, end) / count;
+    pool.UnInit();
+
+    CCompactObjectPool compactPool;
+    compactPool.Init(sizeof(ObjSmall), 1024, 0);
+    CPerfProfiler::GetTime(begin);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        vecObjs[i] = (ObjSmall *)compactPool.Get();
+        vecObjs[i]->uValue = i;
+    }
+    CPerfProfiler::GetTime(end);
+    auto uCompactGet = CPerfProfiler::GetTimeDiffNano(begin, end) / count;
+    CPerfProfiler::GetTime(begin);
+    for (uint32_t n = 0; n < 10; n++)
+    {
+        for (auto ptr : vecObjs)
+        {
+            uSum += ptr->uValue;
+        }
+    }
+    CPerfProfiler::GetTime(end);
+    auto uCompactScan = CPerfProfiler::GetTimeDiffNano(begin, end) / (count * 10);
+    auto uCompactBytes = (uint64_t)compactPool.GetBlockCount() * compactPool.GetBlockSize();
+    CPerfProfiler::GetTime(begin);
+    for (auto ptr : vecObjs)
+    {
+        compactPool.Release(ptr);
+    }
+    CPerfProfiler::GetTime(end);
+    auto uCompactRelease = CPerfProfiler::GetTimeDiffNano(begin, end) / count;
+    compactPool.UnInit();
+
+    printf("CObjectPool       : %lu MB, get = %lu ns, release = %lu ns, scan = %lu ns/obj\n", uPoolBytes >> 20,
+           uPoolGet, uPoolRelease, uPoolScan);
+    printf("CCompactObjectPool: %lu MB, get = %lu ns, release = %lu ns, scan = %lu ns/obj (sum %lu)\n",
+           uCompactBytes >> 20, uCompactGet, uCompactRelease, uCompactScan, uSum);
+    PRINT_INFO("=================");
+}
+
+int main(int argc, const char *argv[])
+{
+    CaseLayout();
+    CaseTrim();
+    CasePerf();
+    return 0;
+}
@@ -0,0 +1,235 @@
+#include <utility/handle_object_pool.h>
+#include <utility/perf_profiler.h>
+#include <algorithm>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using namespace utility;
+
+struct ObjDemo
+{
+    uint64_t uKey;
+    uint64_t uValue;
+};
+
+void CaseHandle()
+{
+    PRINT_INFO("=================");
+    CHandleObjectPool pool;
+    if (pool.Init(sizeof(ObjDemo)) != 0)
+    {
+        PRINT_FAIL("pool Init Fail");
+        exit(1);
+    }
+
+    std::vector<uint32_t> vecHandles;
+    for (uint32_t i = 0; i < BlockObjectSize * 3; i++)
+    {
+        auto uHandle = pool.Get();
+        auto ptr = (ObjDemo *)pool.Resolve(uHandle);
+        if (uHandle == InvalidHandle || ptr == nullptr)
+        {
+            PRINT_ERROR("Get Fail");
+            exit(1);
+        }
+        ptr->uKey = i;
+        vecHandles.push_back(uHandle);
+    }
+
+    // 归还后旧句柄失效，再次归还也失败
+    auto uStale = vecHandles[5];
+    if (pool.Release(uStale) != 0 || pool.Resolve(uStale) != nullptr || pool.Release(uStale) == 0)
+    {
+        PRINT_ERROR("stale handle not rejected");
+        exit(1);
+    }
+    // 同一槽位被重新使用，旧句柄仍然失效
+    auto uReused = pool.Get();
+    if (((uReused ^ uStale) >> HandleGenBits) != 0 || uReused == uStale || pool.Resolve(uStale) != nullptr)
+    {
+        PRINT_ERROR("reused slot handle %x, stale %x", uReused, uStale);
+        exit(1);
+    }
+    vecHandles[5] = uReused;
+    ((ObjDemo *)pool.Resolve(uReused))->uKey = 5;
+
+    // 代数绕回后仍不会是0
+    for (uint32_t n = 0; n < 200; n++)
+    {
+        pool.Release(vecHandles[7]);
+        vecHandles[7] = pool.Get();
+        if ((vecHandles[7] & HandleGenMask) == 0)
+        {
+            PRINT_ERROR("generation 0 issued");
+            exit(1);
+        }
+    }
+    ((ObjDemo *)pool.Resolve(vecHandles[7]))->uKey = 7;
+
+    if (pool.Resolve(InvalidHandle) != nullptr || pool.Resolve(0xFFFFFFFF) != nullptr)
+    {
+        PRINT_ERROR("invalid handle resolved");
+        exit(1);
+    }
+    for (uint32_t i = 0; i < vecHandles.size(); i++)
+    {
+        if (((ObjDemo *)pool.Resolve(vecHandles[i]))->uKey != i)
+        {
+            PRINT_ERROR("handle %u Is Not OK", i);
+            exit(1);
+        }
+    }
+    pool.UnInit();
+    PRINT_INFO("=================");
+}
+
+void CaseCompact()
+{
+    PRINT_INFO("=================");
+    CHandleObjectPool pool;
+    pool.Init(sizeof(ObjDemo));
+
+    // 索引表保存句柄，模拟使用方
+    constexpr uint32_t count = BlockObjectSize * 20;
+    std::vector<uint32_t> vecTable(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        vecTable[i] = pool.Get();
+        auto ptr = (ObjDemo *)pool.Resolve(vecTable[i]);
+        ptr->uKey = i;
+        ptr->uValue = i * 3;
+    }
+
+    // 随机释放90%，所有块都变得稀疏
+    std::vector<uint32_t> vecOrder(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        vecOrder[i] = i;
+    }
+    std::shuffle(vecOrder.begin(), vecOrder.end(), std::mt19937(11));
+    for (uint32_t i = 0; i < count * 9 / 10; i++)
+    {
+        pool.Release(vecTable[vecOrder[i]]);
+        vecTable[vecOrder[i]] = InvalidHandle;
+    }
+
+    std::unordered_map<uint32_t, uint32_t> mapRow;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (vecTable[i] != InvalidHandle)
+        {
+            mapRow[vecTable[i]] = i;
+        }
+    }
+    auto uBlocksBefore = pool.GetBlockCount();
+    uint32_t uMoved = 0;
+    auto uFreed = pool.Compact(BlockObjectSize / 2, [&](uint32_t uOld, uint32_t uNew, void *lpNewObj) {
+        auto uRow = mapRow[uOld];
+        if (((ObjDemo *)lpNewObj)->uKey != uRow)
+        {
+            PRINT_ERROR("relocated object %u Is Not OK", uRow);
+            exit(1);
+        }
+        vecTable[uRow] = uNew;
+        uMoved++;
+    });
+
+    // 2048个存活对象最多需要3个块
+    if (pool.GetBlockCount() > 3 || uFreed != uBlocksBefore - pool.GetBlockCount())
+    {
+        PRINT_ERROR("Compact fail, blocks %u -> %u, freed = %u", uBlocksBefore, pool.GetBlockCount(), uFreed);
+        exit(1);
+    }
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (vecTable[i] == InvalidHandle)
+        {
+            continue;
+        }
+        auto ptr = (ObjDemo *)pool.Resolve(vecTable[i]);
+        if (ptr == nullptr || ptr->uKey != i || ptr->uValue != i * 3)
+        {
+            PRINT_ERROR("row %u Is Not OK after Compact", i);
+            exit(1);
+        }
+    }
+    // 搬走之前的句柄都已失效，释放的块编号被新块复用后也一样
+    for (auto &item : mapRow)
+    {
+        if (vecTable[item.second] != item.first && pool.Resolve(item.first) != nullptr)
+        {
+            PRINT_ERROR("stale handle %x resolved", item.first);
+            exit(1);
+        }
+    }
+    for (uint32_t i = 0; i < count; i++)
+    {
+        pool.Get();
+    }
+    for (auto &item : mapRow)
+    {
+        if (vecTable[item.second] != item.first && pool.Resolve(item.first) != nullptr)
+        {
+            PRINT_ERROR("stale handle %x resolved after block reuse", item.first);
+            exit(1);
+        }
+    }
+    printf("blocks %u -> %u, moved = %u\n", uBlocksBefore, uBlocksBefore - uFreed, uMoved);
+    pool.UnInit();
+    PRINT_INFO("=================");
+}
+
+// 句柄表与指针表：表的大小和随机访问的开销
+void CasePerf()
+{
+    PRINT_INFO("=================");
+    constexpr uint32_t count = 1 << 20;
+    CHandleObjectPool pool;
+    pool.Init(sizeof(ObjDemo));
+    std::vector<uint32_t> vecHandles(count);
+    std::vector<ObjDemo *> vecPtrs(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        vecHandles[i] = pool.Get();
+        vecPtrs[i] = (ObjDemo *)pool.Resolve(vecHandles[i]);
+        vecPtrs[i]->uValue = i;
+    }
+    std::vector<uint32_t> vecOrder(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        vecOrder[i] = i;
+    }
+    std::shuffle(vecOrder.begin(), vecOrder.end(), std::mt19937(5));
+
+    timespec begin, end;
+    uint64_t uSum = 0;
+    CPerfProfiler::GetTime(begin);
+    for (auto i : vecOrder)
+    {
+        uSum += vecPtrs[i]->uValue;
+    }
+    CPerfProfiler::GetTime(end);
+    auto uPtrCost = CPerfProfiler::GetTimeDiffNano(begin, end) / count;
+
+    CPerfProfiler::GetTime(begin);
+    for (auto i : vecOrder)
+    {
+        uSum += ((ObjDemo *)pool.Resolve(vecHandles[i]))->uValue;
+    }
+    CPerfProfiler::GetTime(end);
+    auto uHandleCost = CPerfProfiler::GetTimeDiffNano(begin, end) / count;
+
+    printf("pointer table = %lu KB, %lu ns/access; handle table = %lu KB, %lu ns/access (sum %lu)\n",
+           count * sizeof(void *) >> 10, uPtrCost, count * sizeof(uint32_t) >> 10, uHandleCost, uSum);
+    pool.UnInit();
+    PRINT_INFO("=================");
+}
+
+int main(int argc, const char *argv[])
+{
+    CaseHandle();
+    CaseCompact();
+    CasePerf();
+    return 0;
+}
@@ -0,0 +1,265 @@
+#include <utility/lockfree_object_pool.h>
+#include <utility/perf_profiler.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+using namespace utility;
+
+struct ObjDemo
+{
+    uint64_t uOwner;
+    uint64_t uSeq;
+    char f[48];
+
+    void Set(uint64_t owner, uint64_t seq)
+    {
+        uOwner = owner;
+        uSeq = seq;
+        memset(f, (char)owner, sizeof(f));
+    }
+
+    bool IsOk(uint64_t owner, uint64_t seq)
+    {
+        if (uOwner != owner || uSeq != seq)
+        {
+            return false;
+        }
+        for (uint32_t i = 0; i < sizeof(f); i++)
+        {
+            if (f[i] != (char)owner)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// 多线程批量持有再释放，同一对象被重复分配时内容校验失败
+void CaseMultiThreadStress()
+{
+    PRINT_INFO("=================");
+    CLockFreeObjectPool pool;
+    if (pool.Init(sizeof(ObjDemo)) != 0)
+    {
+        PRINT_FAIL("pool Init Fail");
+        exit(1);
+    }
+
+    std::atomic<uint32_t> uErrors{0};
+    auto func = [&](uint64_t uOwner) {
+        std::vector<ObjDemo *> vecObjs;
+        for (uint32_t round = 0; round < 100; round++)
+        {
+            // 批量大小交替变化，使块反复被抢空、释放空并扩容
+            uint32_t uBatch = (round % 2 == 0) ? 5000 : 17;
+            for (uint32_t i = 0; i < uBatch; i++)
+            {
+                auto ptr = (ObjDemo *)pool.Get();
+                if (ptr == nullptr)
+                {
+                    uErrors++;
+                    continue;
+                }
+                ptr->Set(uOwner, i);
+                vecObjs.push_back(ptr);
+            }
+            for (uint32_t i = 0; i < vecObjs.size(); i++)
+            {
+                if (!vecObjs[i]->IsOk(uOwner, i))
+                {
+                    uErrors++;
+                }
+                pool.Release(vecObjs[i]);
+            }
+            vecObjs.clear();
+        }
+    };
+
+    std::thread th[8];
+    for (uint32_t i = 0; i < sizeof(th) / sizeof(std::thread); i++)
+    {
+        th[i] = std::thread(func, i + 1);
+    }
+    for (uint32_t i = 0; i < sizeof(th) / sizeof(std::thread); i++)
+    {
+        th[i].join();
+    }
+
+    if (uErrors != 0)
+    {
+        PRINT_ERROR("errors = %u", uErrors.load());
+        exit(1);
+    }
+    printf("block count = %u\n", pool.GetBlockCount());
+    pool.UnInit();
+    PRINT_INFO("=================");
+}
+
+// 生产者申请，消费者释放，多个线程同时释放到同一个块
+void CaseCrossThreadRelease()
+{
+    PRINT_INFO("=================");
+    CLockFreeObjectPool pool;
+    if (pool.Init(sizeof(ObjDemo)) != 0)
+    {
+        PRINT_FAIL("pool Init Fail");
+        exit(1);
+    }
+
+    constexpr uint32_t count = 200000;
+    std::mutex lock;
+    std::vector<ObjDemo *> vecQueue;
+    std::atomic<bool> bRunning{true};
+    std::atomic<uint32_t> uErrors{0};
+    std::atomic<uint32_t> uReleased{0};
+
+    auto producer = [&]() {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            auto ptr = (ObjDemo *)pool.Get();
+            if (ptr == nullptr)
+            {
+                uErrors++;
+                continue;
+            }
+            ptr->Set(7, i);
+            std::lock_guard<std::mutex> guard(lock);
+            vecQueue.push_back(ptr);
+        }
+    };
+
+    auto consumer = [&]() {
+        std::vector<ObjDemo *> vecObjs;
+        while (true)
+        {
+            auto bStop = !bRunning;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                vecObjs.swap(vecQueue);
+            }
+            if (bStop && vecObjs.empty())
+            {
+                break;
+            }
+            for (auto ptr : vecObjs)
+            {
+                if (ptr->uOwner != 7)
+                {
+                    uErrors++;
+                }
+                pool.Release(ptr);
+                uReleased++;
+            }
+            vecObjs.clear();
+            std::this_thread::yield();
+        }
+    };
+
+    std::thread thProducer[2];
+    std::thread thConsumer[3];
+    for (auto &th : thConsumer)
+    {
+        th = std::thread(consumer);
+    }
+    for (auto &th : thProducer)
+    {
+        th = std::thread(producer);
+    }
+    for (auto &th : thProducer)
+    {
+        th.join();
+    }
+    bRunning = false;
+    for (auto &th : thConsumer)
+    {
+        th.join();
+    }
+
+    if (uErrors != 0 || uReleased != count * 2)
+    {
+        PRINT_ERROR("errors = %u, released = %u", uErrors.load(), uReleased.load());
+        exit(1);
+    }
+    pool.UnInit();
+    PRINT_INFO("=================");
+}
+
+// 竞争下的吞吐：全局锁包裹的CObjectPool对比无锁池
+void CasePerf()
+{
+    PRINT_INFO("=================");
+    constexpr uint32_t count = 1000000;
+
+    auto runner = [](uint32_t uThreads, const std::function<void()> &func) {
+        std::vector<std::thread> vecThreads;
+        timespec begin, end;
+        CPerfProfiler::GetTime(begin);
+        for (uint32_t i = 0; i < uThreads; i++)
+        {
+            vecThreads.emplace_back(func);
+        }
+        for (auto &th : vecThreads)
+        {
+            th.join();
+        }
+        CPerfProfiler::GetTime(end);
+        return CPerfProfiler::GetTimeDiffNano(begin, end);
+    };
+
+    for (uint32_t uThreads = 1; uThreads <= 8; uThreads *= 2)
+    {
+        CObjectPool lockPool;
+        lockPool.Init(sizeof(ObjDemo));
+        std::mutex lock;
+        auto uLockCost = runner(uThreads, [&]() {
+            void *ptrArr[32];
+            for (uint32_t i = 0; i < count / 32; i++)
+            {
+                for (uint32_t j = 0; j < 32; j++)
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    ptrArr[j] = lockPool.Get();
+                }
+                for (uint32_t j = 0; j < 32; j++)
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    lockPool.Release(ptrArr[j]);
+                }
+            }
+        });
+        lockPool.UnInit();
+
+        CLockFreeObjectPool lockFreePool;
+        lockFreePool.Init(sizeof(ObjDemo));
+        auto uLockFreeCost = runner(uThreads, [&]() {
+            void *ptrArr[32];
+            for (uint32_t i = 0; i < count / 32; i++)
+            {
+                for (uint32_t j = 0; j < 32; j++)
+                {
+                    ptrArr[j] = lockFreePool.Get();
+                }
+                for (uint32_t j = 0; j < 32; j++)
+                {
+                    lockFreePool.Release(ptrArr[j]);
+                }
+            }
+        });
+        lockFreePool.UnInit();
+
+        printf("threads = %u, mutex pool = %lu ns/op, lock-free pool = %lu ns/op\n", uThreads,
+               uLockCost / count, uLockFreeCost / count);
+    }
+    PRINT_INFO("=================");
+}
+
+int main(int argc, const char *argv[])
+{
+    CaseMultiThreadStress();
+    CaseCrossThreadRelease();
+    CasePerf();
+    return 0;
+}
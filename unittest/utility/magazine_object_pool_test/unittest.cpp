@@ -0,0 +1,218 @@
+#include <utility/magazine_object_pool.h>
+#include <utility/perf_profiler.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+using namespace utility;
+
+struct ObjDemo
+{
+    uint64_t uOwner;
+    uint64_t uSeq;
+    char f[48];
+
+    void Set(uint64_t owner, uint64_t seq)
+    {
+        uOwner = owner;
+        uSeq = seq;
+        memset(f, (char)owner, sizeof(f));
+    }
+
+    bool IsOk(uint64_t owner, uint64_t seq)
+    {
+        if (uOwner != owner || uSeq != seq)
+        {
+            return false;
+        }
+        for (uint32_t i = 0; i < sizeof(f); i++)
+        {
+            if (f[i] != (char)owner)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+void CaseManyGet2Release()
+{
+    PRINT_INFO("=================");
+    CMagazineObjectPool pool;
+    if (pool.Init(sizeof(ObjDemo), 32) != 0)
+    {
+        PRINT_FAIL("pool Init Fail");
+        exit(1);
+    }
+
+    uint32_t count = 10240;
+    std::vector<ObjDemo *> vecObjs;
+    for (uint32_t round = 0; round < 4; round++)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            auto ptr = (ObjDemo *)pool.Get();
+            if (ptr == nullptr)
+            {
+                PRINT_ERROR("Get Fail");
+                exit(1);
+            }
+            ptr->Set(1, i);
+            vecObjs.push_back(ptr);
+        }
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (!vecObjs[i]->IsOk(1, i))
+            {
+                PRINT_ERROR("vecObjs[%u] Is Not OK", i);
+                exit(1);
+            }
+            pool.Release(vecObjs[i]);
+        }
+        vecObjs.clear();
+    }
+    pool.UnInit();
+    PRINT_INFO("=================");
+}
+
+void CaseMultiThread()
+{
+    PRINT_INFO("=================");
+    CMagazineObjectPool pool;
+    if (pool.Init(sizeof(ObjDemo), 16) != 0)
+    {
+        PRINT_FAIL("pool Init Fail");
+        exit(1);
+    }
+
+    std::atomic<uint32_t> uErrors{0};
+    // 每个线程持有一批对象再释放，若同一对象被发给两个线程，内容会被覆盖
+    auto func = [&](uint64_t uOwner) {
+        std::vector<ObjDemo *> vecObjs;
+        for (uint32_t round = 0; round < 200; round++)
+        {
+            uint32_t uBatch = 1 + (round * 7 + uOwner * 13) % 100;
+            for (uint32_t i = 0; i < uBatch; i++)
+            {
+                auto ptr = (ObjDemo *)pool.Get();
+                if (ptr == nullptr)
+                {
+                    uErrors++;
+                    continue;
+                }
+                ptr->Set(uOwner, i);
+                vecObjs.push_back(ptr);
+            }
+            std::this_thread::yield();
+            for (uint32_t i = 0; i < vecObjs.size(); i++)
+            {
+                if (!vecObjs[i]->IsOk(uOwner, i))
+                {
+                    uErrors++;
+                }
+                pool.Release(vecObjs[i]);
+            }
+            vecObjs.clear();
+        }
+    };
+
+    // 两轮线程，第二轮复用第一轮线程退出时归还到仓库的对象
+    for (uint32_t loop = 0; loop < 2; loop++)
+    {
+        std::thread th[4];
+        for (uint32_t i = 0; i < sizeof(th) / sizeof(std::thread); i++)
+        {
+            th[i] = std::thread(func, i + 1);
+        }
+        for (uint32_t i = 0; i < sizeof(th) / sizeof(std::thread); i++)
+        {
+            th[i].join();
+        }
+    }
+
+    if (uErrors != 0)
+    {
+        PRINT_ERROR("errors = %u", uErrors.load());
+        exit(1);
+    }
+    pool.UnInit();
+    PRINT_INFO("=================");
+}
+
+void CasePerf()
+{
+    PRINT_INFO("=================");
+    constexpr uint32_t count = 1000000;
+
+    auto runner = [](uint32_t uThreads, const std::function<void()> &func) {
+        std::vector<std::thread> vecThreads;
+        timespec begin, end;
+        CPerfProfiler::GetTime(begin);
+        for (uint32_t i = 0; i < uThreads; i++)
+        {
+            vecThreads.emplace_back(func);
+        }
+        for (auto &th : vecThreads)
+        {
+            th.join();
+        }
+        CPerfProfiler::GetTime(end);
+        return CPerfProfiler::GetTimeDiffNano(begin, end);
+    };
+
+    for (uint32_t uThreads = 1; uThreads <= 4; uThreads *= 2)
+    {
+        CObjectPool lockPool;
+        lockPool.Init(sizeof(ObjDemo));
+        std::mutex lock;
+        auto uLockCost = runner(uThreads, [&]() {
+            void *ptrArr[32];
+            for (uint32_t i = 0; i < count / 32; i++)
+            {
+                for (uint32_t j = 0; j < 32; j++)
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    ptrArr[j] = lockPool.Get();
+                }
+                for (uint32_t j = 0; j < 32; j++)
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    lockPool.Release(ptrArr[j]);
+                }
+            }
+        });
+        lockPool.UnInit();
+
+        CMagazineObjectPool magazinePool;
+        magazinePool.Init(sizeof(ObjDemo));
+        auto uMagazineCost = runner(uThreads, [&]() {
+            void *ptrArr[32];
+            for (uint32_t i = 0; i < count / 32; i++)
+            {
+                for (uint32_t j = 0; j < 32; j++)
+                {
+                    ptrArr[j] = magazinePool.Get();
+                }
+                for (uint32_t j = 0; j < 32; j++)
+                {
+                    magazinePool.Release(ptrArr[j]);
+                }
+            }
+        });
+        magazinePool.UnInit();
+
+        printf("threads = %u, mutex pool = %lu ns/op, magazine pool = %lu ns/op\n", uThreads,
+               uLockCost / count, uMagazineCost / count);
+    }
+    PRINT_INFO("=================");
+}
+
+int main(int argc, const char *argv[])
+{
+    CaseManyGet2Release();
+    CaseMultiThread();
+    CasePerf();
+    return 0;
+}
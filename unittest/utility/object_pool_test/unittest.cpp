@@ -3,6 +3,12 @@
 #include <vector>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
 
 using namespace utility;
 
@@ -71,7 +77,7 @@ void CaseOneByOne()
 {
     PRINT_INFO("=================");
     TestHelper helper;
-    auto pool = helper.m_pool;
+    auto &pool = helper.m_pool;
 
     for (uint32_t i = 0; i < 10240; i++)
     {
@@ -89,7 +95,7 @@ void CaseManyGet2Release()
 {
     PRINT_INFO("=================");
     TestHelper helper;
-    auto pool = helper.m_pool;
+    auto &pool = helper.m_pool;
     uint32_t count = 10240;
     auto ptrArr = (ObjDemo **)malloc(sizeof(ObjDemo *)*count);
     auto newCount = 0;
@@ -118,7 +124,7 @@ void CaseMultiThreadOneByOne()
 {
     PRINT_INFO("=================");
     TestHelper helper;
-    auto pool = helper.m_pool;
+    auto &pool = helper.m_pool;
     auto bRunning = true;
     std::mutex lock;
 
@@ -173,7 +179,7 @@ void CasePerf()
 {
     PRINT_INFO("=================");
     TestHelper helper;
-    auto pool = helper.m_pool;
+    auto &pool = helper.m_pool;
     
     uint32_t count = 32;
     auto ptrArr = (ObjDemo **)malloc(sizeof(ObjDemo *)*count * 1024);
@@ -217,11 +223,707 @@ void CasePerf()
     PRINT_INFO("=================");
 }
 
+void CaseBatch()
+{
+    PRINT_INFO("=================");
+    TestHelper helper;
+    auto &pool = helper.m_pool;
+    uint32_t count = 5000;
+    auto ptrArr = (ObjDemo **)malloc(sizeof(ObjDemo *) * count);
+
+    for (uint32_t round = 0; round < 4; round++)
+    {
+        auto newCount = pool.GetBatch(count, (void **)ptrArr);
+        if (newCount != count)
+        {
+            PRINT_ERROR("GetBatch = %u", newCount);
+            exit(1);
+        }
+        for (uint32_t i = 0; i < newCount; i++)
+        {
+            ptrArr[i]->Set('a' + (i % 26));
+        }
+        for (uint32_t i = 0; i < newCount; i++)
+        {
+            if (ptrArr[i]->a != 'a' + (i % 26) || !ptrArr[i]->IsOk())
+            {
+                PRINT_ERROR("ptrArr[%u] Is Not OK", i);
+                exit(1);
+            }
+        }
+        // 交错释放一半，再批量释放剩余部分
+        for (uint32_t i = 0; i < newCount; i += 2)
+        {
+            pool.Release(ptrArr[i]);
+            ptrArr[i] = nullptr;
+        }
+        pool.ReleaseBatch((void **)ptrArr, newCount);
+    }
+
+    free(ptrArr);
+    PRINT_INFO("=================");
+}
+
+void CasePerfBatch()
+{
+    PRINT_INFO("=================");
+    TestHelper helper;
+    auto &pool = helper.m_pool;
+
+    constexpr uint32_t count = 256;
+    constexpr uint32_t loop = 1000;
+    void *ptrArr[count];
+    timespec begin, end;
+
+    CPerfProfiler::GetTime(begin);
+    for (uint32_t n = 0; n < loop; n++)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            ptrArr[i] = pool.Get();
+        }
+        for (uint32_t i = 0; i < count; i++)
+        {
+            pool.Release(ptrArr[i]);
+        }
+    }
+    CPerfProfiler::GetTime(end);
+    auto uSingleCost = CPerfProfiler::GetTimeDiffNano(begin, end);
+
+    CPerfProfiler::GetTime(begin);
+    for (uint32_t n = 0; n < loop; n++)
+    {
+        pool.GetBatch(count, ptrArr);
+        pool.ReleaseBatch(ptrArr, count);
+    }
+    CPerfProfiler::GetTime(end);
+    auto uBatchCost = CPerfProfiler::GetTimeDiffNano(begin, end);
+
+    printf("burst = %u, one by one = %lu ns/op, batch = %lu ns/op\n", count,
+           uSingleCost / (count * loop), uBatchCost / (count * loop));
+    PRINT_INFO("=================");
+}
+
+// dTLB读缺失计数，内核不允许时返回-1
+static int OpenDTlbMissCounter()
+{
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static uint64_t GetMinorFaults()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (uint64_t)usage.ru_minflt;
+}
+
+// 对比不同块内存后端：扩容时首次触碰的延迟、缺页次数，以及随机访问的dTLB缺失
+void CasePerfBlockAllocator()
+{
+    PRINT_INFO("=================");
+    constexpr uint32_t count = 64 * BlockObjectSize; // 64个块
+    auto ptrArr = (ObjDemo **)malloc(sizeof(ObjDemo *) * count);
+    auto iTlbFd = OpenDTlbMissCounter();
+
+    CMmapBlockAllocator mmapAllocator(CMmapBlockAllocator::MmapPopulate);
+    CMmapBlockAllocator hugeAllocator;
+    struct
+    {
+        const char *lpName;
+        IBlockAllocator *lpAllocator;
+    } arrBackends[] = {
+        {"malloc", CMallocBlockAllocator::GetInstance()},
+        {"mmap+populate", &mmapAllocator},
+        {"mmap+hugepage", &hugeAllocator},
+    };
+
+    for (auto &backend : arrBackends)
+    {
+        CObjectPool pool;
+        ObjectPoolOption option;
+        option.lpBlockAllocator = backend.lpAllocator;
+        // 固定块大小，每块BlockObjectSize个对象约4M，不小于大页才会用上大页
+        option.uFirstBlockBytes = option.uBlockBytes = sizeof(ObjDemo) * BlockObjectSize;
+        if (pool.Init(sizeof(ObjDemo), nullptr, option) != 0)
+        {
+            PRINT_ERROR("%s Init Fail", backend.lpName);
+            continue;
+        }
+
+        // 扩容路径：新块的申请与预热全部计入首次触碰
+        timespec begin, end;
+        auto uFaults = GetMinorFaults();
+        CPerfProfiler::GetTime(begin);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            ptrArr[i] = (ObjDemo *)pool.Get();
+            ptrArr[i]->a = 'a';
+        }
+        CPerfProfiler::GetTime(end);
+        auto uFirstTouch = CPerfProfiler::GetTimeDiffNano(begin, end);
+        uFaults = GetMinorFaults() - uFaults;
+
+        // 随机访问已分配的对象
+        uint64_t uTlbMiss = 0;
+        uint32_t uSeed = 12345;
+        uint64_t uSum = 0;
+        if (iTlbFd >= 0)
+        {
+            ioctl(iTlbFd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(iTlbFd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+        CPerfProfiler::GetTime(begin);
+        for (uint32_t i = 0; i < count * 4; i++)
+        {
+            uSeed = uSeed * 1103515245 + 12345;
+            uSum += ptrArr[uSeed % count]->a;
+        }
+        CPerfProfiler::GetTime(end);
+        if (iTlbFd >= 0)
+        {
+            ioctl(iTlbFd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(iTlbFd, &uTlbMiss, sizeof(uTlbMiss)) != sizeof(uTlbMiss))
+            {
+                uTlbMiss = 0;
+            }
+        }
+        auto uRandom = CPerfProfiler::GetTimeDiffNano(begin, end);
+
+        printf("%-14s first touch = %lu ns/op, minor faults = %lu, random access = %lu ns/op, dTLB miss = %s%lu (sum %lu)\n",
+               backend.lpName, uFirstTouch / count, uFaults, uRandom / (count * 4), iTlbFd >= 0 ? "" : "n/a ",
+               uTlbMiss, uSum);
+
+        pool.ReleaseBatch((void **)ptrArr, count);
+        pool.UnInit();
+    }
+
+    if (iTlbFd >= 0)
+    {
+        close(iTlbFd);
+    }
+    free(ptrArr);
+    PRINT_INFO("=================");
+}
+
+// 随机申请释放，覆盖扩容、块回收和整理，校验对象不会被重复分配
+void CaseRandomChurn()
+{
+    PRINT_INFO("=================");
+    CObjectPool pool;
+    if (pool.Init(sizeof(uint64_t) * 2) != 0)
+    {
+        PRINT_FAIL("pool Init Fail");
+        exit(1);
+    }
+
+    std::vector<uint64_t *> vecLive;
+    uint32_t uSeed = 1;
+    uint64_t uStamp = 0;
+    for (uint32_t i = 0; i < 2000000; i++)
+    {
+        uSeed = uSeed * 1103515245 + 12345;
+        // 前半程偏向申请，后半程偏向释放
+        bool bGet = vecLive.empty() || ((uSeed >> 8) % 100) < (i < 1000000 ? 60u : 40u);
+        if (bGet)
+        {
+            auto ptr = (uint64_t *)pool.Get();
+            ptr[0] = ++uStamp;
+            ptr[1] = ~uStamp;
+            vecLive.push_back(ptr);
+        }
+        else
+        {
+            auto uPos = (uSeed >> 4) % vecLive.size();
+            auto ptr = vecLive[uPos];
+            if (ptr[1] != ~ptr[0])
+            {
+                PRINT_ERROR("object %p corrupted", ptr);
+                exit(1);
+            }
+            ptr[1] = 0;
+            pool.Release(ptr);
+            vecLive[uPos] = vecLive.back();
+            vecLive.pop_back();
+        }
+    }
+
+    for (auto ptr : vecLive)
+    {
+        if (ptr[1] != ~ptr[0])
+        {
+            PRINT_ERROR("object %p corrupted", ptr);
+            exit(1);
+        }
+    }
+    pool.ReleaseBatch((void **)vecLive.data(), (uint32_t)vecLive.size());
+    pool.UnInit();
+    PRINT_INFO("=================");
+}
+
+// 最坏碎片：所有块都满，每次只在随机的一个块里释放一个对象，再Get
+// 线性扫描时Get的耗时随块数线性增长，位图查找应保持平稳
+void CasePerfFragmented()
+{
+    PRINT_INFO("=================");
+    for (uint32_t uBlocks = 256; uBlocks <= 2048; uBlocks *= 2)
+    {
+        // 固定块大小，每块BlockObjectSize个对象
+        CObjectPool pool;
+        ObjectPoolOption option;
+        option.uFirstBlockBytes = option.uBlockBytes = (sizeof(uint64_t) + 8) * BlockObjectSize;
+        pool.Init(sizeof(uint64_t), nullptr, option);
+        uint32_t count = uBlocks * BlockObjectSize;
+        std::vector<void *> vecObjs(count);
+        pool.GetBatch(count, vecObjs.data());
+
+        uint64_t uSum = 0;
+        uint64_t uMax = 0;
+        uint32_t uSeed = 7;
+        constexpr uint32_t loop = 20000;
+        for (uint32_t i = 0; i < loop; i++)
+        {
+            uSeed = uSeed * 1103515245 + 12345;
+            auto uPos = (uSeed >> 4) % count;
+            pool.Release(vecObjs[uPos]);
+
+            timespec begin, end;
+            CPerfProfiler::GetTime(begin);
+            vecObjs[uPos] = pool.Get();
+            CPerfProfiler::GetTime(end);
+            auto uCost = CPerfProfiler::GetTimeDiffNano(begin, end);
+            uSum += uCost;
+            uMax = uCost > uMax ? uCost : uMax;
+        }
+
+        printf("blocks = %u, Get avg = %lu ns, max = %lu ns\n", uBlocks, uSum / loop, uMax);
+        pool.ReleaseBatch(vecObjs.data(), count);
+        pool.UnInit();
+    }
+    PRINT_INFO("=================");
+}
+
+// 空闲块超过高水位后回收到低水位，并且在边界附近来回申请释放时不会反复扩容
+void CaseTrim()
+{
+    PRINT_INFO("=================");
+    CObjectPool pool;
+    ObjectPoolOption option;
+    option.uIdleHighWatermark = 8;
+    option.uIdleLowWatermark = 2;
+    if (pool.Init(sizeof(uint64_t), nullptr, option) != 0)
+    {
+        PRINT_FAIL("pool Init Fail");
+        exit(1);
+    }
+
+    uint32_t count = 100 * BlockObjectSize;
+    std::vector<void *> vecObjs(count);
+    if (pool.GetBatch(count, vecObjs.data()) != count || pool.GetIdleBlockCount() != 0)
+    {
+        PRINT_ERROR("GetBatch fail, idle = %u", pool.GetIdleBlockCount());
+        exit(1);
+    }
+    auto uPeakBlocks = pool.GetBlockCount();
+    pool.ReleaseBatch(vecObjs.data(), count);
+    if (pool.GetIdleBlockCount() > option.uIdleHighWatermark || pool.GetBlockCount() >= uPeakBlocks)
+    {
+        PRINT_ERROR("auto trim fail, idle = %u, blocks = %u", pool.GetIdleBlockCount(), pool.GetBlockCount());
+        exit(1);
+    }
+
+    // 在一个块的边界上来回抖动，第一轮扩容后块数应保持不变
+    auto uAfterTrim = pool.GetBlockCount();
+    pool.GetBatch(BlockObjectSize * 3 + 1, vecObjs.data());
+    pool.ReleaseBatch(vecObjs.data(), BlockObjectSize * 3 + 1);
+    auto uBlocks = pool.GetBlockCount();
+    for (uint32_t round = 0; round < 100; round++)
+    {
+        pool.GetBatch(BlockObjectSize * 3 + 1, vecObjs.data());
+        pool.ReleaseBatch(vecObjs.data(), BlockObjectSize * 3 + 1);
+        if (pool.GetBlockCount() != uBlocks)
+        {
+            PRINT_ERROR("thrash, blocks %u -> %u", uBlocks, pool.GetBlockCount());
+            exit(1);
+        }
+    }
+
+    auto uFreed = pool.Trim();
+    if (pool.GetIdleBlockCount() > 1)
+    {
+        PRINT_ERROR("Trim fail, idle = %u", pool.GetIdleBlockCount());
+        exit(1);
+    }
+    printf("peak blocks = %u, after auto trim = %u, steady = %u, Trim() freed = %u, left = %u\n", uPeakBlocks,
+           uAfterTrim, uBlocks, uFreed, pool.GetBlockCount());
+
+    // 回收后仍可正常使用
+    pool.GetBatch(count, vecObjs.data());
+    pool.ReleaseBatch(vecObjs.data(), count);
+    pool.UnInit();
+
+    // 没有Init或UnInit之后调用Trim什么也不做
+    CObjectPool emptyPool;
+    if (pool.Trim() != 0 || emptyPool.Trim() != 0)
+    {
+        PRINT_ERROR("Trim after UnInit fail");
+        exit(1);
+    }
+    PRINT_INFO("=================");
+}
+
+void CaseProvision()
+{
+    PRINT_INFO("=================");
+    std::atomic<uint32_t> uConstructed{0};
+    CObjectPool pool;
+    ObjectPoolOption option;
+    option.uInitBlockCount = 1;
+    option.uFirstBlockBytes = option.uBlockBytes = (sizeof(uint64_t) + 8) * BlockObjectSize;
+    option.uSpareBlocks = 4;
+    option.uSpareLowWatermark = 2;
+    if (pool.Init(
+            sizeof(uint64_t),
+            [&uConstructed](void *ptr) {
+                *(uint64_t *)ptr = 0xCAFE;
+                uConstructed++;
+            },
+            option) != 0)
+    {
+        PRINT_FAIL("pool Init Fail");
+        exit(1);
+    }
+    // Init返回时备用块已经构造好
+    if (uConstructed != BlockObjectSize * 5)
+    {
+        PRINT_ERROR("constructed = %u", uConstructed.load());
+        exit(1);
+    }
+
+    // 后台构造的块与同步构造的块一样可用
+    std::vector<uint64_t *> vecObjs;
+    for (uint32_t i = 0; i < BlockObjectSize * 40; i++)
+    {
+        auto ptr = (uint64_t *)pool.Get();
+        if (ptr == nullptr || *ptr != 0xCAFE)
+        {
+            PRINT_ERROR("Get Fail, ptr = %p", ptr);
+            exit(1);
+        }
+        *ptr = i;
+        vecObjs.push_back(ptr);
+    }
+    for (uint32_t i = 0; i < vecObjs.size(); i++)
+    {
+        if (*vecObjs[i] != i)
+        {
+            PRINT_ERROR("vecObjs[%u] Is Not OK", i);
+            exit(1);
+        }
+        pool.Release(vecObjs[i]);
+    }
+    pool.UnInit();
+    PRINT_INFO("=================");
+}
+
+// 持续增长时单次Get的尾延迟，对比同步扩容和后台预备块
+void CasePerfProvision()
+{
+    PRINT_INFO("=================");
+    constexpr uint32_t count = 512 * BlockObjectSize;
+    std::vector<void *> vecObjs(count);
+    std::vector<uint64_t> vecCost(count);
+    for (uint32_t uSpare : {0u, 16u})
+    {
+        CObjectPool pool;
+        ObjectPoolOption option;
+        option.uInitBlockCount = 1;
+        option.uSpareBlocks = uSpare;
+        option.uSpareLowWatermark = uSpare / 2;
+        pool.Init(256, nullptr, option);
+
+        timespec begin, end;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            CPerfProfiler::GetTime(begin);
+            vecObjs[i] = pool.Get();
+            CPerfProfiler::GetTime(end);
+            vecCost[i] = CPerfProfiler::GetTimeDiffNano(begin, end);
+            // 模拟请求处理，给后台线程留出补充的时间
+            if ((i & 63) == 0)
+            {
+                std::this_thread::yield();
+            }
+        }
+        std::sort(vecCost.begin(), vecCost.end());
+        printf("spare blocks = %2u: p50 = %lu ns, p99 = %lu ns, p99.9 = %lu ns, p99.99 = %lu ns, max = %lu ns\n", uSpare,
+               vecCost[count / 2], vecCost[(uint64_t)count * 99 / 100], vecCost[(uint64_t)count * 999 / 1000],
+               vecCost[(uint64_t)count * 9999 / 10000], vecCost[count - 1]);
+        pool.ReleaseBatch(vecObjs.data(), count);
+        pool.UnInit();
+    }
+    PRINT_INFO("=================");
+}
+
+// 块从小到大翻倍，启动时不占内存，大对象和小对象的池占用都与实际使用量成比例
+void CaseGeometry()
+{
+    PRINT_INFO("=================");
+    for (uint32_t uSize : {8u, 64u, 4096u})
+    {
+        CObjectPool pool;
+        if (pool.Init(uSize) != 0 || pool.GetBlockCount() != 0 || pool.GetMemorySize() != 0)
+        {
+            PRINT_ERROR("size %u lazy Init fail, blocks = %u", uSize, pool.GetBlockCount());
+            exit(1);
+        }
+
+        // 一个对象只占第一个小块
+        auto ptr = pool.Get();
+        auto uFirstBytes = pool.GetMemorySize();
+        if (ptr == nullptr || pool.GetBlockCount() != 1 || uFirstBytes > 2 * DefaultFirstBlockBytes + (uSize + 8) * 8)
+        {
+            PRINT_ERROR("size %u first block = %lu bytes", uSize, uFirstBytes);
+            exit(1);
+        }
+        pool.Release(ptr);
+
+        // 块的容量翻倍增长直到上限，多出的内存不超过使用量的一倍加一个最大块
+        constexpr uint32_t count = 100000;
+        std::vector<void *> vecObjs(count);
+        if (pool.GetBatch(count, vecObjs.data()) != count)
+        {
+            PRINT_ERROR("size %u GetBatch fail", uSize);
+            exit(1);
+        }
+        auto uUsedBytes = (uint64_t)count * (uSize + 8);
+        auto uMaxBlockBytes = (uint64_t)DefaultBlockBytes + (uSize + 8) * PoolMinBlockObjects + 4096;
+        if (pool.GetMemorySize() < uUsedBytes || pool.GetMemorySize() > uUsedBytes * 2 + uMaxBlockBytes)
+        {
+            PRINT_ERROR("size %u memory = %lu, used = %lu", uSize, pool.GetMemorySize(), uUsedBytes);
+            exit(1);
+        }
+        printf("object size = %4u: first block = %6lu bytes, blocks = %4u, memory = %9lu bytes, used = %9lu bytes, "
+               "block objects = %u\n",
+               uSize, uFirstBytes, pool.GetBlockCount(), pool.GetMemorySize(), uUsedBytes, pool.GetNextBlockObjects());
+
+        pool.ReleaseBatch(vecObjs.data(), count);
+        pool.Trim();
+        if (pool.GetBlockCount() != 1 || pool.GetMemorySize() == 0)
+        {
+            PRINT_ERROR("size %u Trim fail, blocks = %u", uSize, pool.GetBlockCount());
+            exit(1);
+        }
+        pool.UnInit();
+    }
+    PRINT_INFO("=================");
+}
+
+// mmap分配器偏好大页：槽位够大时最大的块正好申请一个大页，槽位太小时受每块对象数上限限制，仍然是普通页
+void CaseHugeBlock()
+{
+    PRINT_INFO("=================");
+    CMmapBlockAllocator allocator(CMmapBlockAllocator::MmapTransparentHuge);
+    for (uint32_t uSize : {8u, 1000u, 4096u})
+    {
+        CObjectPool pool;
+        ObjectPoolOption option;
+        option.lpBlockAllocator = &allocator;
+        if (pool.Init(uSize, nullptr, option) != 0)
+        {
+            PRINT_ERROR("size %u Init fail", uSize);
+            exit(1);
+        }
+
+        // 扩容到最大的块，记下最后一个块申请的大小
+        std::vector<void *> vecObjs;
+        uint64_t uLastBlockBytes = 0;
+        while (pool.GetBlockCount() < 12)
+        {
+            auto uMemory = pool.GetMemorySize();
+            vecObjs.push_back(pool.Get());
+            if (pool.GetMemorySize() != uMemory)
+            {
+                uLastBlockBytes = pool.GetMemorySize() - uMemory;
+            }
+        }
+        bool bHuge = (uint64_t)(uSize + 8) * PoolMaxBlockObjects >= HugePageSize;
+        if (bHuge ? uLastBlockBytes != HugePageSize
+                  : (uLastBlockBytes >= HugePageSize || pool.GetNextBlockObjects() != PoolMaxBlockObjects))
+        {
+            PRINT_ERROR("size %u last block = %lu bytes, block objects = %u", uSize, uLastBlockBytes,
+                        pool.GetNextBlockObjects());
+            exit(1);
+        }
+        printf("object size = %4u: last block = %7lu bytes, block objects = %u\n", uSize, uLastBlockBytes,
+               pool.GetNextBlockObjects());
+        pool.ReleaseBatch(vecObjs.data(), (uint32_t)vecObjs.size());
+        pool.UnInit();
+    }
+    PRINT_INFO("=================");
+}
+
+// 槽位对齐与块着色：对象地址满足对齐，着色的块对象区依次后移一个缓存行
+void CaseSlotLayout()
+{
+    PRINT_INFO("=================");
+    CMmapBlockAllocator mmapAllocator(CMmapBlockAllocator::MmapPopulate);
+    CObjectPool pool;
+    ObjectPoolOption option;
+    option.lpBlockAllocator = &mmapAllocator;
+    option.uSlotAlign = 64;
+    option.uColorCount = 4;
+    option.uFirstBlockBytes = option.uBlockBytes = 64 * 64;
+    if (pool.Init(24, nullptr, option) != 0 || pool.GetObjectSize() != 56)
+    {
+        PRINT_FAIL("pool Init Fail, object size = %u", pool.GetObjectSize());
+        exit(1);
+    }
+
+    constexpr uint32_t count = 64 * 8;
+    std::vector<void *> vecObjs(count);
+    pool.GetBatch(count, vecObjs.data());
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if ((uintptr_t)vecObjs[i] % 64 != 0)
+        {
+            PRINT_ERROR("object %p is not aligned", vecObjs[i]);
+            exit(1);
+        }
+        memset(vecObjs[i], 0xA5, 56);
+    }
+    // 块按页对齐，每块第一个对象所在的缓存行依次后移一行
+    for (uint32_t uBlock = 1; uBlock < count / 64; uBlock++)
+    {
+        auto uPrev = (uintptr_t)vecObjs[(uBlock - 1) * 64] % 4096 / 64;
+        auto uCurr = (uintptr_t)vecObjs[uBlock * 64] % 4096 / 64;
+        if (uCurr != (uBlock % 4 == 0 ? uPrev - 3 : uPrev + 1))
+        {
+            PRINT_ERROR("block %u color line %lu, prev %lu", uBlock, uCurr, uPrev);
+            exit(1);
+        }
+    }
+    pool.ReleaseBatch(vecObjs.data(), count);
+
+    // 非法参数
+    option.uSlotAlign = 48;
+    if (pool.Init(24, nullptr, option) == 0)
+    {
+        PRINT_ERROR("slot align 48 should fail");
+        exit(1);
+    }
+    pool.UnInit();
+    PRINT_INFO("=================");
+}
+
+// 伪共享：几个线程各自反复写自己的对象，对象从同一个池连续申请；
+// 缓存组冲突：按固定间隔遍历每个块的第一个对象，块都按页对齐时这些对象落在同一个缓存组
+void CasePerfSlotLayout()
+{
+    PRINT_INFO("=================");
+    constexpr uint32_t uThreads = 4;
+    constexpr uint32_t loop = 20000000;
+    for (uint32_t uAlign : {0u, 64u})
+    {
+        CObjectPool pool;
+        ObjectPoolOption option;
+        option.uSlotAlign = uAlign;
+        pool.Init(sizeof(uint64_t), nullptr, option);
+        volatile uint64_t *arrCounters[uThreads];
+        for (uint32_t i = 0; i < uThreads; i++)
+        {
+            arrCounters[i] = (volatile uint64_t *)pool.Get();
+            *arrCounters[i] = 0;
+        }
+
+        std::vector<std::thread> vecThreads;
+        timespec begin, end;
+        CPerfProfiler::GetTime(begin);
+        for (uint32_t i = 0; i < uThreads; i++)
+        {
+            vecThreads.emplace_back([&arrCounters, i]() {
+                for (uint32_t j = 0; j < loop; j++)
+                {
+                    (*arrCounters[i])++;
+                }
+            });
+        }
+        for (auto &th : vecThreads)
+        {
+            th.join();
+        }
+        CPerfProfiler::GetTime(end);
+        printf("false sharing, slot align = %2u: %lu ns/op\n", uAlign,
+               CPerfProfiler::GetTimeDiffNano(begin, end) / loop);
+        for (uint32_t i = 0; i < uThreads; i++)
+        {
+            pool.Release((void *)arrCounters[i]);
+        }
+        pool.UnInit();
+    }
+
+    constexpr uint32_t uBlocks = 512;
+    constexpr uint32_t uBlockObjects = 64;
+    CMmapBlockAllocator mmapAllocator(CMmapBlockAllocator::MmapPopulate);
+    for (uint32_t uColors : {0u, 8u, 32u})
+    {
+        CObjectPool pool;
+        ObjectPoolOption option;
+        option.lpBlockAllocator = &mmapAllocator;
+        option.uColorCount = uColors;
+        option.uFirstBlockBytes = option.uBlockBytes = 64 * uBlockObjects;
+        pool.Init(56, nullptr, option);
+        std::vector<void *> vecObjs(uBlocks * uBlockObjects);
+        pool.GetBatch((uint32_t)vecObjs.size(), vecObjs.data());
+        std::vector<volatile uint64_t *> vecHot;
+        for (uint32_t i = 0; i < uBlocks; i++)
+        {
+            vecHot.push_back((volatile uint64_t *)vecObjs[i * uBlockObjects]);
+        }
+
+        timespec begin, end;
+        CPerfProfiler::GetTime(begin);
+        for (uint32_t round = 0; round < 2000; round++)
+        {
+            for (auto ptr : vecHot)
+            {
+                (*ptr)++;
+            }
+        }
+        CPerfProfiler::GetTime(end);
+        printf("cache set conflict, colors = %2u: %lu ns/op\n", uColors,
+               CPerfProfiler::GetTimeDiffNano(begin, end) / (2000 * uBlocks));
+        pool.ReleaseBatch(vecObjs.data(), (uint32_t)vecObjs.size());
+        pool.UnInit();
+    }
+    PRINT_INFO("=================");
+}
+
 int main(int argc, const char *argv[])
 {
     // CaseOneByOne();
     // CaseManyGet2Release();
     // CaseMultiThreadOneByOne();
     CasePerf();
+    CaseBatch();
+    CasePerfBatch();
+    CasePerfBlockAllocator();
+    CaseRandomChurn();
+    CasePerfFragmented();
+    CaseTrim();
+    CaseProvision();
+    CasePerfProvision();
+    CaseGeometry();
+    CaseHugeBlock();
+    CaseSlotLayout();
+    CasePerfSlotLayout();
     return 0;
 }
@@ -0,0 +1,153 @@
+#include <utility/perf_counter.h>
+#include <utility/object_pool.h>
+#include <vector>
+
+using namespace utility;
+
+// 顺序访问一个小数组和随机访问一个大数组，后者的缓存和TLB缺失明显更多
+static uint64_t Walk(const std::vector<uint32_t> &vecNext, uint32_t uSteps)
+{
+    uint32_t uIndex = 0;
+    for (uint32_t i = 0; i < uSteps; i++)
+    {
+        uIndex = vecNext[uIndex];
+    }
+    return uIndex;
+}
+
+static std::vector<uint32_t> MakeChain(uint32_t uCount, bool bRandom)
+{
+    std::vector<uint32_t> vecOrder(uCount), vecNext(uCount);
+    for (uint32_t i = 0; i < uCount; i++)
+    {
+        vecOrder[i] = i;
+    }
+    uint64_t uSeed = 88172645463325252ull;
+    for (uint32_t i = uCount - 1; bRandom && i > 0; i--)
+    {
+        uSeed ^= uSeed << 13;
+        uSeed ^= uSeed >> 7;
+        uSeed ^= uSeed << 17;
+        std::swap(vecOrder[i], vecOrder[uSeed % (i + 1)]);
+    }
+    for (uint32_t i = 0; i < uCount; i++)
+    {
+        vecNext[vecOrder[i]] = vecOrder[(i + 1) % uCount];
+    }
+    return vecNext;
+}
+
+// 有PMU时检查计数合理；没有权限时退化为只计时，两种情况下section都能正常累计和输出
+void CaseCounters()
+{
+    PRINT_INFO("=================");
+    constexpr uint32_t uSteps = 1 << 20;
+    CPerfCounterGroup group;
+    auto iRet = group.Open();
+    printf("enabled = %d, mask = 0x%x\n", group.IsEnabled(), group.GetValidMask());
+    if ((iRet == 0) != group.IsEnabled())
+    {
+        PRINT_ERROR("Open = %d, enabled = %d", iRet, group.IsEnabled());
+        exit(1);
+    }
+
+    auto vecSmall = MakeChain(1024, false);
+    auto vecLarge = MakeChain(16 << 20, true);
+    CPerfCounterSection sectionSmall("sequential 4KB"), sectionLarge("random 64MB");
+    uint64_t uSum = 0;
+    for (uint32_t round = 0; round < 3; round++)
+    {
+        {
+            CPerfCounterScope scope(group, sectionSmall);
+            uSum += Walk(vecSmall, uSteps);
+        }
+        {
+            CPerfCounterScope scope(group, sectionLarge);
+            uSum += Walk(vecLarge, uSteps);
+        }
+    }
+    sectionSmall.Print(group.GetValidMask());
+    sectionLarge.Print(group.GetValidMask());
+
+    if (sectionSmall.GetCalls() != 3 || sectionLarge.GetTimeNano() <= sectionSmall.GetTimeNano())
+    {
+        PRINT_ERROR("small = %lu ns, large = %lu ns (%lu)", sectionSmall.GetTimeNano(), sectionLarge.GetTimeNano(),
+                    uSum);
+        exit(1);
+    }
+    if (group.IsValid(PerfInstructions) && sectionSmall.GetSum(PerfInstructions) < 3ull * uSteps)
+    {
+        PRINT_ERROR("instructions = %lu", sectionSmall.GetSum(PerfInstructions));
+        exit(1);
+    }
+    if (group.IsValid(PerfLlcMisses) &&
+        sectionLarge.GetSum(PerfLlcMisses) <= sectionSmall.GetSum(PerfLlcMisses))
+    {
+        PRINT_ERROR("llc misses small = %lu, large = %lu", sectionSmall.GetSum(PerfLlcMisses),
+                    sectionLarge.GetSum(PerfLlcMisses));
+        exit(1);
+    }
+    PRINT_INFO("=================");
+}
+
+// 逐次测量CObjectPool::Get，区分普通调用和触发Expand的调用
+void CasePoolGet()
+{
+    PRINT_INFO("=================");
+    constexpr uint32_t count = 100000;
+    CPerfCounterGroup group;
+    group.Open();
+    CObjectPool pool;
+    pool.Init(64);
+    CPerfCounterSection sectionGet("Get"), sectionExpand("Get with Expand");
+    std::vector<void *> vecObjs;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        auto uBlocks = pool.GetBlockCount();
+        PerfCounterValues begin, end;
+        group.Read(begin);
+        vecObjs.push_back(pool.Get());
+        group.Read(end);
+        (pool.GetBlockCount() != uBlocks ? sectionExpand : sectionGet).Add(begin, end);
+    }
+    for (auto ptr : vecObjs)
+    {
+        pool.Release(ptr);
+    }
+    pool.UnInit();
+
+    sectionGet.Print(group.GetValidMask());
+    sectionExpand.Print(group.GetValidMask());
+    if (sectionGet.GetCalls() + sectionExpand.GetCalls() != count || sectionExpand.GetCalls() == 0)
+    {
+        PRINT_ERROR("get = %lu, expand = %lu", sectionGet.GetCalls(), sectionExpand.GetCalls());
+        exit(1);
+    }
+    PRINT_INFO("=================");
+}
+
+void CasePerf()
+{
+    PRINT_INFO("=================");
+    constexpr uint32_t count = 100000;
+    CPerfCounterGroup group;
+    group.Open();
+    PerfCounterValues values;
+    timespec begin, end;
+    CPerfProfiler::GetTime(begin);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        group.Read(values);
+    }
+    CPerfProfiler::GetTime(end);
+    printf("enabled = %d, read = %.1f ns\n", group.IsEnabled(), (double)CPerfProfiler::GetTimeDiffNano(begin, end) / count);
+    PRINT_INFO("=================");
+}
+
+int main(int argc, const char *argv[])
+{
+    CaseCounters();
+    CasePoolGet();
+    CasePerf();
+    return 0;
+}
@@ -0,0 +1,230 @@
+#include <utility/perf_profiler.h>
+#include <thread>
+#include <chrono>
+
+using namespace utility;
+
+// tick换算出的时间和CLOCK_MONOTONIC一致
+void CaseTscClock()
+{
+    PRINT_INFO("=================");
+    printf("tsc = %d, ticks/ns = %.3f\n", CTscClock::IsTscEnabled(), CTscClock::GetTicksPerNano());
+    if (CTscClock::GetTicksPerNano() <= 0.0)
+    {
+        PRINT_ERROR("bad calibration");
+        exit(1);
+    }
+
+    timespec begin, end;
+    CPerfProfiler::GetTime(begin);
+    auto uTickBegin = CTscClock::GetTick();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    auto uTickEnd = CTscClock::GetTickEnd();
+    CPerfProfiler::GetTime(end);
+
+    auto uClockNano = CPerfProfiler::GetTimeDiffNano(begin, end);
+    auto uTickNano = CTscClock::TickToNano(uTickEnd - uTickBegin);
+    // 校准误差在2%以内
+    if (uTickEnd <= uTickBegin || uTickNano > uClockNano * 51 / 50 || uTickNano < uClockNano * 49 / 50)
+    {
+        PRINT_ERROR("clock = %lu ns, tick = %lu ns", uClockNano, uTickNano);
+        exit(1);
+    }
+
+    BeginPerfTest(sleep);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    EndPerfTest(sleep, stdout);
+    PRINT_INFO("=================");
+}
+
+// 超过一个块的打点也能正确保存
+void CaseProfiler()
+{
+    PRINT_INFO("=================");
+    constexpr uint32_t count = StepTimePointSize * 3;
+    static const char *s_lpPath = "/tmp/perf_profiler_test.csv";
+    std::vector<CPerfProfiler::TimePoint *> vecChunks;
+    struct CAllocator : public CPerfProfiler::IObjAllocator
+    {
+        uint32_t uSize_{0};
+        int32_t SetObjSize(uint32_t uObjSize) override
+        {
+            uSize_ = uObjSize;
+            return 0;
+        }
+        CPerfProfiler::TimePoint *Get() override { return (CPerfProfiler::TimePoint *)malloc(uSize_); }
+        void *Release(CPerfProfiler::TimePoint *ptr) override
+        {
+            free(ptr);
+            return nullptr;
+        }
+    } allocator;
+
+    {
+        CPerfProfilerWrap perf(&allocator);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            perf.Add("step");
+        }
+        perf.Print("steps");
+        perf.Save(s_lpPath);
+    }
+
+    auto fp = fopen(s_lpPath, "r");
+    char szName[64];
+    uint64_t uNano = 0;
+    uint32_t uLines = 0;
+    while (fp != nullptr && fscanf(fp, "%63[^,], %lu\n", szName, &uNano) == 2)
+    {
+        // 打点之间没有其他工作，间隔不会超过1ms
+        if (uNano > 1000000)
+        {
+            PRINT_ERROR("%s = %lu ns", szName, uNano);
+            exit(1);
+        }
+        uLines++;
+    }
+    if (fp != nullptr)
+    {
+        fclose(fp);
+    }
+    remove(s_lpPath);
+    // 每个新块开头多一个__pf_expand
+    if (uLines < count)
+    {
+        PRINT_ERROR("lines = %u", uLines);
+        exit(1);
+    }
+    PRINT_INFO("=================");
+}
+
+// 均匀分布的分位数误差不超过一格(1/32)，合并两半等于整体
+void CaseHistogram()
+{
+    PRINT_INFO("=================");
+    constexpr uint64_t count = 1000000;
+    CPerfHistogram whole, low, high;
+    for (uint64_t i = 1; i <= count; i++)
+    {
+        whole.Record(i);
+        (i <= count / 2 ? low : high).Record(i);
+    }
+    low.Merge(high);
+
+    for (auto dPercent : {50.0, 90.0, 99.0, 99.9})
+    {
+        auto uExpect = uint64_t(dPercent / 100.0 * count);
+        auto uValue = whole.GetPercentile(dPercent);
+        if (uValue < uExpect || uValue > uExpect + uExpect / HistogramSubCount || uValue != low.GetPercentile(dPercent))
+        {
+            PRINT_ERROR("p%.1f = %lu, merged = %lu, expect %lu", dPercent, uValue, low.GetPercentile(dPercent), uExpect);
+            exit(1);
+        }
+    }
+    if (whole.GetMax() != count || whole.GetMin() != 1 || whole.GetPercentile(100) != count ||
+        low.GetCount() != count || low.GetSum() != whole.GetSum())
+    {
+        PRINT_ERROR("max = %lu, min = %lu", whole.GetMax(), whole.GetMin());
+        exit(1);
+    }
+
+    // 每个值都落在上界不小于它的格里
+    for (uint64_t uValue = 0; uValue < (1ull << 20); uValue = uValue * 9 / 8 + 1)
+    {
+        auto uBucket = CPerfHistogram::GetBucket(uValue);
+        if (CPerfHistogram::GetBucketUpper(uBucket) < uValue ||
+            (uBucket > 0 && CPerfHistogram::GetBucketUpper(uBucket - 1) >= uValue))
+        {
+            PRINT_ERROR("value %lu in bucket %u", uValue, uBucket);
+            exit(1);
+        }
+    }
+    PRINT_INFO("=================");
+}
+
+// 直方图模式打点多少次内存都不变，超过MaxPerfProbes个名字的打点计入丢弃
+void CaseHistogramMode()
+{
+    PRINT_INFO("=================");
+    static const char *s_lpPath = "/tmp/perf_profiler_hist.csv";
+    CPerfProfilerWrap perf(PerfModeHistogram), other(PerfModeHistogram), sample;
+    for (uint32_t i = 0; i < 1000000; i++)
+    {
+        perf.Add(i % 2 == 0 ? "even" : "odd");
+    }
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        other.Add("odd");
+    }
+    char szName[MaxPerfProbes + 1][16];
+    for (uint32_t i = 0; i <= MaxPerfProbes; i++)
+    {
+        snprintf(szName[i], sizeof(szName[i]), "probe%u", i);
+        other.Add(szName[i]);
+    }
+
+    if (perf.Merge(other) != 0 || perf.Merge(sample) == 0 || perf.GetProbeCount() != MaxPerfProbes ||
+        perf.GetDroppedCount() != 3 || perf.GetHistogram("odd")->GetCount() != 501000 ||
+        perf.GetHistogram("even")->GetCount() != 500000 || perf.GetHistogram("none") != nullptr)
+    {
+        PRINT_ERROR("probes = %u, dropped = %lu", perf.GetProbeCount(), perf.GetDroppedCount());
+        exit(1);
+    }
+    perf.Print("histogram");
+    perf.Save(s_lpPath);
+
+    auto fp = fopen(s_lpPath, "r");
+    uint64_t arrValues[7];
+    if (fp == nullptr || fscanf(fp, "%15[^,], %lu, %lu, %lu, %lu, %lu, %lu, %lu\n", szName[0], &arrValues[0],
+                                &arrValues[1], &arrValues[2], &arrValues[3], &arrValues[4], &arrValues[5],
+                                &arrValues[6]) != 8 ||
+        strcmp(szName[0], "even") != 0 || arrValues[0] != 500000 || arrValues[2] > arrValues[3] ||
+        arrValues[3] > arrValues[4] || arrValues[4] > arrValues[5] || arrValues[5] > arrValues[6])
+    {
+        PRINT_ERROR("bad csv");
+        exit(1);
+    }
+    fclose(fp);
+    remove(s_lpPath);
+    PRINT_INFO("=================");
+}
+
+// 读一次时间戳的开销
+void CasePerf()
+{
+    PRINT_INFO("=================");
+    constexpr uint32_t count = 1000000;
+    timespec begin, end, ts;
+    uint64_t uSum = 0;
+
+    CPerfProfiler::GetTime(begin);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        CPerfProfiler::GetTime(ts);
+        uSum += ts.tv_nsec;
+    }
+    CPerfProfiler::GetTime(end);
+    auto uClockCost = CPerfProfiler::GetTimeDiffNano(begin, end);
+
+    CPerfProfiler::GetTime(begin);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uSum += CTscClock::GetTick();
+    }
+    CPerfProfiler::GetTime(end);
+    auto uTickCost = CPerfProfiler::GetTimeDiffNano(begin, end);
+
+    printf("clock_gettime = %.1f ns, tsc = %.1f ns (%lu)\n", (double)uClockCost / count, (double)uTickCost / count,
+           uSum & 1);
+    PRINT_INFO("=================");
+}
+
+int main(int argc, const char *argv[])
+{
+    CaseTscClock();
+    CaseProfiler();
+    CaseHistogram();
+    CaseHistogramMode();
+    CasePerf();
+    return 0;
+}
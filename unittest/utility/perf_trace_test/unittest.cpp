@@ -0,0 +1,196 @@
+#define OBJECT_POOL_TIMELINE
+#include <utility/object_pool.h>
+#include <utility/perf_trace.h>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace utility;
+
+static const char *s_lpPath = "/tmp/perf_trace_test.json";
+
+static std::string ReadFile(const char *lpPath)
+{
+    std::string strData;
+    auto fp = fopen(lpPath, "r");
+    if (fp == nullptr)
+    {
+        return strData;
+    }
+    char szBuf[4096];
+    size_t uRead = 0;
+    while ((uRead = fread(szBuf, 1, sizeof(szBuf), fp)) > 0)
+    {
+        strData.append(szBuf, uRead);
+    }
+    fclose(fp);
+    return strData;
+}
+
+// 统计每个线程的B/E事件数
+static void CountEvents(const std::string &strData, std::map<uint32_t, int64_t> &mapDepth, uint64_t &uEvents)
+{
+    uEvents = 0;
+    for (size_t uPos = strData.find("\"ph\":\""); uPos != std::string::npos; uPos = strData.find("\"ph\":\"", uPos + 1))
+    {
+        auto cPhase = strData[uPos + 6];
+        auto uTid = (uint32_t)atoi(strData.c_str() + strData.find("\"tid\":", uPos) + 6);
+        if (cPhase == 'B')
+        {
+            mapDepth[uTid]++;
+        }
+        else if (cPhase == 'E')
+        {
+            mapDepth[uTid]--;
+        }
+        uEvents += cPhase == 'C' ? 0 : 1;
+    }
+}
+
+// 多个线程嵌套打点并且共享一个加锁的池，输出的JSON里每个线程的开始和结束成对出现
+void CaseTimeline()
+{
+    PRINT_INFO("=================");
+    constexpr uint32_t uThreads = 4;
+    constexpr uint32_t count = 2000;
+    if (CPerfTrace::Start(s_lpPath, 1 << 16, 1) != 0 || CPerfTrace::Start(s_lpPath) == 0)
+    {
+        PRINT_FAIL("Start fail");
+        exit(1);
+    }
+
+    CObjectPool pool;
+    ObjectPoolOption option;
+    option.uFirstBlockBytes = option.uBlockBytes = (64 + 8) * 64;
+    pool.Init(64, nullptr, option);
+    std::mutex lock;
+    auto func = [&]() {
+        PERF_TRACE_SCOPE("worker");
+        std::vector<void *> vecObjs;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            PERF_TRACE_SCOPE("request \"quoted\"");
+            {
+                PERF_TRACE_SCOPE("lock wait");
+                lock.lock();
+            }
+            vecObjs.push_back(pool.Get());
+            lock.unlock();
+        }
+        PERF_TRACE_INSTANT("release all");
+        std::lock_guard<std::mutex> guard(lock);
+        for (auto ptr : vecObjs)
+        {
+            pool.Release(ptr);
+        }
+    };
+    std::vector<std::thread> vecThreads;
+    for (uint32_t i = 0; i < uThreads; i++)
+    {
+        vecThreads.emplace_back(func);
+    }
+    for (auto &th : vecThreads)
+    {
+        th.join();
+    }
+    auto uWritten = CPerfTrace::Stop();
+    pool.UnInit();
+
+    auto strData = ReadFile(s_lpPath);
+    std::map<uint32_t, int64_t> mapDepth;
+    uint64_t uEvents = 0;
+    CountEvents(strData, mapDepth, uEvents);
+    auto uExpand = 0;
+    for (size_t uPos = strData.find("CObjectPool::Expand"); uPos != std::string::npos;
+         uPos = strData.find("CObjectPool::Expand", uPos + 1))
+    {
+        uExpand++;
+    }
+    // 每个线程：worker一对、每次请求两对、一个instant
+    if (strData.compare(0, 14, "{\"displayTimeU") != 0 || strData.find("]}\n") != strData.size() - 3 ||
+        strData.find("request \\\"quoted\\\"") == std::string::npos || uEvents != uWritten ||
+        uWritten < uThreads * (2 + count * 4 + 1) || uExpand == 0 || uExpand % 2 != 0 ||
+        CPerfTrace::GetDroppedCount() != 0 || mapDepth.size() != uThreads)
+    {
+        PRINT_ERROR("written = %lu, parsed = %lu, expand = %d, threads = %lu", uWritten, uEvents, uExpand,
+                    mapDepth.size());
+        exit(1);
+    }
+    for (auto &item : mapDepth)
+    {
+        if (item.second != 0)
+        {
+            PRINT_ERROR("tid %u unbalanced %ld", item.first, item.second);
+            exit(1);
+        }
+    }
+    printf("events = %lu, expand events = %d\n", uWritten, uExpand);
+    remove(s_lpPath);
+    PRINT_INFO("=================");
+}
+
+// 缓冲区很小且收集很慢时打点不阻塞，只计数丢弃
+void CaseOverflow()
+{
+    PRINT_INFO("=================");
+    constexpr uint32_t count = 100000;
+    CPerfTrace::Start(s_lpPath, 64, 1000);
+    uint64_t uDropped = 0;
+    std::thread th([&]() {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            PERF_TRACE_INSTANT("tick");
+        }
+    });
+    th.join();
+    uDropped = CPerfTrace::GetDroppedCount();
+    auto uWritten = CPerfTrace::Stop();
+    if (uDropped == 0 || uWritten + uDropped != count || uWritten > 64 * 2 ||
+        ReadFile(s_lpPath).find("trace_dropped") == std::string::npos)
+    {
+        PRINT_ERROR("written = %lu, dropped = %lu", uWritten, uDropped);
+        exit(1);
+    }
+    printf("written = %lu, dropped = %lu\n", uWritten, uDropped);
+    remove(s_lpPath);
+    PRINT_INFO("=================");
+}
+
+// 打点开销：关闭时和开启时
+void CasePerf()
+{
+    PRINT_INFO("=================");
+    constexpr uint32_t count = 1000000;
+    timespec begin, end;
+    CPerfProfiler::GetTime(begin);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        PERF_TRACE_SCOPE("off");
+    }
+    CPerfProfiler::GetTime(end);
+    auto uOffCost = CPerfProfiler::GetTimeDiffNano(begin, end);
+
+    CPerfTrace::Start(s_lpPath, 1 << 20, 1000);
+    PERF_TRACE_INSTANT("create ring"); // 第一次打点时创建缓冲区，不计入耗时
+    CPerfProfiler::GetTime(begin);
+    for (uint32_t i = 0; i < count / 4; i++)
+    {
+        PERF_TRACE_SCOPE("on");
+    }
+    CPerfProfiler::GetTime(end);
+    auto uOnCost = CPerfProfiler::GetTimeDiffNano(begin, end);
+    CPerfTrace::Stop();
+    remove(s_lpPath);
+
+    printf("disabled = %.1f ns/event, enabled = %.1f ns/event\n", (double)uOffCost / count / 2,
+           (double)uOnCost / (count / 4) / 2);
+    PRINT_INFO("=================");
+}
+
+int main(int argc, const char *argv[])
+{
+    CaseTimeline();
+    CaseOverflow();
+    CasePerf();
+    return 0;
+}
@@ -0,0 +1,197 @@
+#define PERF_ZONE_ENABLE
+#include <utility/perf_zone.h>
+#include <utility/perf_profiler.h>
+#include <thread>
+
+using namespace utility;
+
+// 忙等uNano纳秒
+static void Spin(uint64_t uNano)
+{
+    timespec begin, now;
+    CPerfProfiler::GetTime(begin);
+    do
+    {
+        CPerfProfiler::GetTime(now);
+    } while (CPerfProfiler::GetTimeDiffNano(begin, now) < uNano);
+}
+
+static void Leaf()
+{
+    PERF_ZONE("leaf");
+    Spin(20000);
+}
+
+static void Middle()
+{
+    PERF_ZONE("middle");
+    Spin(10000);
+    Leaf();
+    Leaf();
+}
+
+static void Request()
+{
+    PERF_ZONE("request");
+    Middle();
+    Leaf();
+}
+
+static uint32_t Recurse(uint32_t uDepth)
+{
+    PERF_ZONE("recurse");
+    return uDepth == 0 ? 0 : Recurse(uDepth - 1) + 1;
+}
+
+// 同一个位置从不同的父节点进入是不同的节点；独占时间等于包含时间减去子节点
+void CaseTree()
+{
+    PRINT_INFO("=================");
+    constexpr uint32_t count = 100;
+    CPerfZone::Reset();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        Request();
+    }
+
+    CPerfZoneTree tree;
+    CPerfZone::Snapshot(tree);
+    auto lpRequest = tree.Find({"request"});
+    auto lpMiddle = tree.Find({"request", "middle"});
+    auto lpMiddleLeaf = tree.Find({"request", "middle", "leaf"});
+    auto lpLeaf = tree.Find({"request", "leaf"});
+    if (lpRequest == nullptr || lpMiddle == nullptr || lpMiddleLeaf == nullptr || lpLeaf == nullptr ||
+        tree.Find({"leaf"}) != nullptr || lpRequest->uCalls_ != count || lpMiddle->uCalls_ != count ||
+        lpMiddleLeaf->uCalls_ != count * 2 || lpLeaf->uCalls_ != count)
+    {
+        PRINT_ERROR("bad tree");
+        exit(1);
+    }
+    if (lpRequest->uChildTicks_ != lpMiddle->uInclusiveTicks_ + lpLeaf->uInclusiveTicks_ ||
+        lpMiddle->uChildTicks_ != lpMiddleLeaf->uInclusiveTicks_)
+    {
+        PRINT_ERROR("child time mismatch");
+        exit(1);
+    }
+
+    // middle独占约10us，leaf约20us
+    auto uMiddleExclusive = CTscClock::TickToNano(lpMiddle->GetExclusiveTicks()) / count;
+    auto uLeafInclusive = CTscClock::TickToNano(lpLeaf->uInclusiveTicks_) / count;
+    if (uMiddleExclusive < 10000 || uMiddleExclusive > 15000 || uLeafInclusive < 20000 || uLeafInclusive > 25000)
+    {
+        PRINT_ERROR("middle exclusive = %lu, leaf = %lu", uMiddleExclusive, uLeafInclusive);
+        exit(1);
+    }
+    CPerfZone::Print();
+    PRINT_INFO("=================");
+}
+
+// 线程退出时合并到全局；递归超过节点上限的部分计入丢弃，调用栈仍然平衡
+void CaseThreads()
+{
+    PRINT_INFO("=================");
+    constexpr uint32_t uThreads = 4;
+    CPerfZone::Reset();
+    std::thread th[uThreads];
+    for (uint32_t i = 0; i < uThreads; i++)
+    {
+        th[i] = std::thread([]() {
+            Request();
+            Recurse(MaxZoneNodes + 100);
+            Request();
+        });
+    }
+    for (uint32_t i = 0; i < uThreads; i++)
+    {
+        th[i].join();
+    }
+
+    static const char *s_lpPath = "/tmp/perf_zone_test.csv";
+    CPerfZoneTree tree;
+    CPerfZone::Snapshot(tree);
+    auto lpRequest = tree.Find({"request"});
+    if (lpRequest == nullptr || lpRequest->uCalls_ != uThreads * 2 || tree.GetDroppedCount() == 0 ||
+        tree.GetNodeCount() > MaxZoneNodes || CPerfZone::Save(s_lpPath) != 0)
+    {
+        PRINT_ERROR("merge fail, dropped = %lu", tree.GetDroppedCount());
+        exit(1);
+    }
+
+    auto fp = fopen(s_lpPath, "r");
+    char szLine[256];
+    if (fgets(szLine, sizeof(szLine), fp) == nullptr || strncmp(szLine, "request, 8,", 11) != 0 ||
+        fgets(szLine, sizeof(szLine), fp) == nullptr || strncmp(szLine, "request;middle, 8,", 18) != 0)
+    {
+        PRINT_ERROR("bad csv: %s", szLine);
+        exit(1);
+    }
+    fclose(fp);
+    remove(s_lpPath);
+    PRINT_INFO("=================");
+}
+
+// 在还没结束的打点里输出或Flush：进行中的节点不带未结束的子节点时间，结束后再完整计入
+void CaseOpenZone()
+{
+    PRINT_INFO("=================");
+    constexpr uint32_t count = 10;
+    CPerfZone::Reset();
+    {
+        PERF_ZONE("main");
+        for (uint32_t i = 0; i < count; i++)
+        {
+            Request();
+        }
+
+        CPerfZoneTree tree;
+        CPerfZone::Snapshot(tree);
+        auto lpMain = tree.Find({"main"});
+        auto lpRequest = tree.Find({"main", "request"});
+        if (lpMain == nullptr || lpRequest == nullptr || lpMain->uCalls_ != 0 || lpMain->uInclusiveTicks_ != 0 ||
+            lpMain->GetExclusiveTicks() != 0 || lpRequest->uCalls_ != count)
+        {
+            PRINT_ERROR("open zone snapshot fail");
+            exit(1);
+        }
+        CPerfZone::Print();
+        CPerfZone::Flush();
+        Request();
+    }
+
+    CPerfZoneTree tree;
+    CPerfZone::Snapshot(tree);
+    auto lpMain = tree.Find({"main"});
+    auto lpRequest = tree.Find({"main", "request"});
+    if (lpMain == nullptr || lpRequest == nullptr || lpMain->uCalls_ != 1 || lpRequest->uCalls_ != count + 1 ||
+        lpMain->uChildTicks_ != lpRequest->uInclusiveTicks_ || lpMain->uChildTicks_ > lpMain->uInclusiveTicks_)
+    {
+        PRINT_ERROR("open zone merge fail");
+        exit(1);
+    }
+    CPerfZone::Print();
+    PRINT_INFO("=================");
+}
+
+void CasePerf()
+{
+    PRINT_INFO("=================");
+    constexpr uint32_t count = 1000000;
+    timespec begin, end;
+    CPerfProfiler::GetTime(begin);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        PERF_ZONE("empty");
+    }
+    CPerfProfiler::GetTime(end);
+    printf("zone = %.1f ns\n", (double)CPerfProfiler::GetTimeDiffNano(begin, end) / count);
+    PRINT_INFO("=================");
+}
+
+int main(int argc, const char *argv[])
+{
+    CaseTree();
+    CaseThreads();
+    CaseOpenZone();
+    CasePerf();
+    return 0;
+}
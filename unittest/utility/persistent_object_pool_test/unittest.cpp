@@ -0,0 +1,248 @@
+#include <utility/persistent_object_pool.h>
+#include <utility/perf_profiler.h>
+#include <vector>
+#include <set>
+
+using namespace utility;
+
+// 对象之间用偏移相连，重新映射到其他地址也能遍历
+struct Node
+{
+    uint64_t uNextOffset;
+    uint64_t uValue;
+    char szName[48];
+};
+
+static const char *s_lpPath = "/tmp/persistent_object_pool_test.dat";
+static const char *s_lpShmName = "/persistent_object_pool_test";
+
+static int32_t BuildList(CPersistentObjectPool &pool, uint32_t uCount)
+{
+    uint64_t uHead = 0;
+    for (uint32_t i = 0; i < uCount; i++)
+    {
+        auto lpNode = (Node *)pool.Get();
+        if (lpNode == nullptr)
+        {
+            return 1;
+        }
+        lpNode->uNextOffset = uHead;
+        lpNode->uValue = i;
+        snprintf(lpNode->szName, sizeof(lpNode->szName), "node-%u", i);
+        uHead = pool.ToOffset(lpNode);
+    }
+    pool.SetRoot(pool.FromOffset(uHead));
+    return 0;
+}
+
+// 返回链表长度，内容不对时返回0
+static uint32_t CheckList(CPersistentObjectPool &pool)
+{
+    uint32_t uCount = 0;
+    char szName[48];
+    for (auto lpNode = (Node *)pool.GetRoot(); lpNode != nullptr; lpNode = (Node *)pool.FromOffset(lpNode->uNextOffset))
+    {
+        snprintf(szName, sizeof(szName), "node-%lu", lpNode->uValue);
+        if (strcmp(szName, lpNode->szName) != 0)
+        {
+            return 0;
+        }
+        uCount++;
+    }
+    return uCount;
+}
+
+void CaseReattach()
+{
+    PRINT_INFO("=================");
+    constexpr uint32_t count = 5000;
+    CPersistentObjectPool::Remove(s_lpPath);
+    {
+        CPersistentObjectPool pool;
+        if (pool.Init(s_lpPath, sizeof(Node), 64 << 20) != 0 || pool.IsReattached() || BuildList(pool, count) != 0)
+        {
+            PRINT_FAIL("create fail");
+            exit(1);
+        }
+    }
+
+    // 重新打开：链表完整，释放一半后再申请不会拿到仍在使用的对象
+    CPersistentObjectPool pool;
+    if (pool.Init(s_lpPath, sizeof(Node), 0) != 0 || !pool.IsReattached() || !pool.WasCleanShutdown() ||
+        pool.GetLiveObjectCount() != count || CheckList(pool) != count)
+    {
+        PRINT_ERROR("reattach fail, live = %lu", pool.GetLiveObjectCount());
+        exit(1);
+    }
+
+    std::set<void *> setLive;
+    std::vector<Node *> vecFree;
+    auto lpNode = (Node *)pool.GetRoot();
+    for (uint32_t i = 0; lpNode != nullptr; i++)
+    {
+        auto lpNext = (Node *)pool.FromOffset(lpNode->uNextOffset);
+        if (i % 2 == 0)
+        {
+            vecFree.push_back(lpNode);
+        }
+        else
+        {
+            setLive.insert(lpNode);
+        }
+        lpNode = lpNext;
+    }
+    pool.SetRoot(nullptr);
+    for (auto ptr : vecFree)
+    {
+        pool.Release(ptr);
+    }
+    for (uint32_t i = 0; i < count; i++)
+    {
+        auto ptr = pool.Get();
+        if (ptr == nullptr || !setLive.insert(ptr).second)
+        {
+            PRINT_ERROR("Get %p twice", ptr);
+            exit(1);
+        }
+    }
+    if (pool.GetLiveObjectCount() != setLive.size())
+    {
+        PRINT_ERROR("live = %lu, expect %lu", pool.GetLiveObjectCount(), setLive.size());
+        exit(1);
+    }
+    pool.UnInit();
+    CPersistentObjectPool::Remove(s_lpPath);
+    PRINT_INFO("=================");
+}
+
+// 对象大小不同、映射被破坏时拒绝接管；容量用完时Get返回空
+void CaseValidate()
+{
+    PRINT_INFO("=================");
+    CPersistentObjectPool::Remove(s_lpPath);
+    CPersistentObjectPool pool;
+    if (pool.Init(s_lpPath, sizeof(Node), 0) == 0)
+    {
+        PRINT_ERROR("too small mapping should fail");
+        exit(1);
+    }
+    CPersistentObjectPool::Remove(s_lpPath);
+    if (pool.Init(s_lpPath, sizeof(Node), PersistDataOffset + 2 * (sizeof(Node) * BlockObjectSize + 256)) != 0 ||
+        pool.GetMaxBlockCount() != 2)
+    {
+        PRINT_FAIL("create fail, max blocks = %u", pool.GetMaxBlockCount());
+        exit(1);
+    }
+    uint32_t uGot = 0;
+    while (pool.Get() != nullptr)
+    {
+        uGot++;
+    }
+    if (uGot != 2 * BlockObjectSize)
+    {
+        PRINT_ERROR("got %u objects", uGot);
+        exit(1);
+    }
+    pool.UnInit();
+
+    if (pool.Init(s_lpPath, sizeof(Node) + 8, 0) == 0)
+    {
+        PRINT_ERROR("object size mismatch should fail");
+        exit(1);
+    }
+
+    auto fp = fopen(s_lpPath, "r+");
+    fwrite("garbage!", 1, 8, fp);
+    fclose(fp);
+    if (pool.Init(s_lpPath, sizeof(Node), 0) == 0)
+    {
+        PRINT_ERROR("corrupted magic should fail");
+        exit(1);
+    }
+    CPersistentObjectPool::Remove(s_lpPath);
+    PRINT_INFO("=================");
+}
+
+// 共享内存：一个读写映射，一个只读映射，地址不同但看到同一份数据
+void CaseShm()
+{
+    PRINT_INFO("=================");
+    auto uFlags = CPersistentObjectPool::PersistShm | CPersistentObjectPool::PersistCreate;
+    CPersistentObjectPool::Remove(s_lpShmName, CPersistentObjectPool::PersistShm);
+    CPersistentObjectPool writer;
+    if (writer.Init(s_lpShmName, sizeof(Node), 16 << 20, uFlags) != 0 || BuildList(writer, 3000) != 0)
+    {
+        PRINT_FAIL("shm create fail");
+        exit(1);
+    }
+
+    CPersistentObjectPool reader;
+    if (reader.Init(s_lpShmName, sizeof(Node), 0,
+                    CPersistentObjectPool::PersistShm | CPersistentObjectPool::PersistReadOnly) != 0 ||
+        reader.GetRoot() == writer.GetRoot() || CheckList(reader) != 3000 || reader.Get() != nullptr)
+    {
+        PRINT_ERROR("shm reader fail");
+        exit(1);
+    }
+    reader.UnInit();
+    writer.UnInit();
+    CPersistentObjectPool::Remove(s_lpShmName, CPersistentObjectPool::PersistShm);
+    PRINT_INFO("=================");
+}
+
+// 重启耗时：重新映射已有的池 vs 重新申请并填充同样数量的对象
+void CasePerf()
+{
+    PRINT_INFO("=================");
+    constexpr uint32_t count = 2000000;
+    CPersistentObjectPool::Remove(s_lpPath);
+    {
+        CPersistentObjectPool pool;
+        pool.Init(s_lpPath, sizeof(Node), 1ull << 30);
+        BuildList(pool, count);
+    }
+
+    timespec begin, end;
+    CPerfProfiler::GetTime(begin);
+    CObjectPool rebuildPool;
+    rebuildPool.Init(sizeof(Node));
+    uint64_t uPrev = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        auto lpNode = (Node *)rebuildPool.Get();
+        lpNode->uNextOffset = uPrev;
+        lpNode->uValue = i;
+        snprintf(lpNode->szName, sizeof(lpNode->szName), "node-%u", i);
+        uPrev = (uint64_t)lpNode;
+    }
+    CPerfProfiler::GetTime(end);
+    auto uRebuild = CPerfProfiler::GetTimeDiffNano(begin, end);
+    rebuildPool.UnInit();
+
+    CPerfProfiler::GetTime(begin);
+    CPersistentObjectPool pool;
+    auto iRet = pool.Init(s_lpPath, sizeof(Node), 0);
+    auto lpRoot = (Node *)pool.GetRoot();
+    CPerfProfiler::GetTime(end);
+    auto uReattach = CPerfProfiler::GetTimeDiffNano(begin, end);
+    if (iRet != 0 || lpRoot == nullptr || lpRoot->uValue != count - 1)
+    {
+        PRINT_ERROR("reattach fail");
+        exit(1);
+    }
+
+    printf("objects = %u, rebuild = %lu us, reattach = %lu us, blocks = %u\n", count, uRebuild / 1000,
+           uReattach / 1000, pool.GetBlockCount());
+    pool.UnInit();
+    CPersistentObjectPool::Remove(s_lpPath);
+    PRINT_INFO("=================");
+}
+
+int main(int argc, const char *argv[])
+{
+    CaseReattach();
+    CaseValidate();
+    CaseShm();
+    CasePerf();
+    return 0;
+}
@@ -0,0 +1,7 @@
+#!/bin/bash
+
+target=unittest.out
+
+rm $target
+g++ -g unittest.cpp -I ../../../src -o $target -lpthread -std=c++17
+./$target
\ No newline at end of file
@@ -0,0 +1,246 @@
+#include <utility/pool_allocator.h>
+#include <utility/perf_profiler.h>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <random>
+
+using namespace utility;
+
+struct alignas(32) ObjAligned
+{
+    uint64_t a[4];
+};
+
+void CaseAllocator()
+{
+    PRINT_INFO("=================");
+    CSlabAllocator slab;
+    slab.Init();
+    {
+        CPoolAllocator<int> alloc(&slab);
+        std::list<int, CPoolAllocator<int>> lst(alloc);
+        std::map<int, int, std::less<int>, CPoolAllocator<std::pair<const int, int>>> mp(alloc);
+        std::unordered_map<int, int, std::hash<int>, std::equal_to<int>, CPoolAllocator<std::pair<const int, int>>> ump(
+            16, std::hash<int>(), std::equal_to<int>(), alloc);
+        for (int i = 0; i < 10000; i++)
+        {
+            lst.push_back(i);
+            mp[i] = i * 2;
+            ump[i] = i * 3;
+        }
+        for (int i = 0; i < 10000; i += 2)
+        {
+            mp.erase(i);
+            ump.erase(i);
+        }
+        int iSum = 0;
+        for (auto &kv : mp)
+        {
+            if (kv.second != kv.first * 2 || ump.at(kv.first) != kv.first * 3)
+            {
+                PRINT_ERROR("key %d is not OK", kv.first);
+                exit(1);
+            }
+            iSum++;
+        }
+        if (iSum != 5000 || lst.size() != 10000 || ump.size() != 5000)
+        {
+            PRINT_ERROR("sum = %d, list = %lu, umap = %lu", iSum, lst.size(), ump.size());
+            exit(1);
+        }
+
+        // 超过slab对齐要求的类型走对齐分配
+        std::vector<ObjAligned, CPoolAllocator<ObjAligned>> vec(alloc);
+        vec.resize(100);
+        if (((uintptr_t)vec.data() & 31) != 0)
+        {
+            PRINT_ERROR("vec data %p not aligned", vec.data());
+            exit(1);
+        }
+
+        // 字节数会溢出的申请直接抛异常，容器看到的上限与分配器一致
+        CPoolAllocator<ObjAligned> alignedAlloc(alloc);
+        bool bThrown = false;
+        try
+        {
+            alignedAlloc.allocate(alignedAlloc.max_size() + 1);
+        }
+        catch (const std::bad_alloc &)
+        {
+            bThrown = true;
+        }
+        if (!bThrown || vec.max_size() > alignedAlloc.max_size())
+        {
+            PRINT_ERROR("overflow check fail, max size = %lu", alignedAlloc.max_size());
+            exit(1);
+        }
+
+        // rebind后的分配器与原分配器相等
+        CPoolAllocator<std::pair<const int, int>> rebound(alloc);
+        CSlabAllocator other;
+        if (!(rebound == alloc) || CPoolAllocator<int>(&other) == alloc)
+        {
+            PRINT_ERROR("allocator equality is not OK");
+            exit(1);
+        }
+    }
+    slab.UnInit();
+    PRINT_INFO("=================");
+}
+
+void CasePmr()
+{
+    PRINT_INFO("=================");
+    CSlabAllocator slab;
+    slab.Init();
+    {
+        CSlabMemoryResource resource(&slab);
+        std::pmr::list<std::pmr::string> lst(&resource);
+        std::pmr::unordered_map<int, std::pmr::string> ump(&resource);
+        for (int i = 0; i < 5000; i++)
+        {
+            // 超过SSO长度，字符串内容也从resource申请
+            lst.emplace_back(64, 'a' + i % 26);
+            ump.emplace(i, std::pmr::string(100, 'z'));
+        }
+        for (auto &str : lst)
+        {
+            if (str.get_allocator().resource() != &resource)
+            {
+                PRINT_ERROR("string not using slab resource");
+                exit(1);
+            }
+        }
+
+        auto ptr = resource.allocate(100, 64);
+        if (((uintptr_t)ptr & 63) != 0)
+        {
+            PRINT_ERROR("ptr %p not aligned", ptr);
+            exit(1);
+        }
+        resource.deallocate(ptr, 100, 64);
+
+        CSlabMemoryResource same(&slab);
+        if (!resource.is_equal(same) || resource.is_equal(*std::pmr::new_delete_resource()))
+        {
+            PRINT_ERROR("resource equality is not OK");
+            exit(1);
+        }
+    }
+    slab.UnInit();
+    PRINT_INFO("=================");
+}
+
+// 容器反复插入删除，keys为随机序列；第一轮用于预热，不计时(桶数组和各尺寸级别的首次扩容)
+template <typename Map>
+uint64_t MapChurn(Map &mp, const std::vector<int> &vecKeys, uint32_t uLoop)
+{
+    timespec begin, end;
+    for (auto key : vecKeys)
+    {
+        mp.emplace(key, key);
+    }
+    for (auto key : vecKeys)
+    {
+        mp.erase(key);
+    }
+
+    CPerfProfiler::GetTime(begin);
+    for (uint32_t n = 0; n < uLoop; n++)
+    {
+        for (auto key : vecKeys)
+        {
+            mp.emplace(key, key);
+        }
+        for (auto key : vecKeys)
+        {
+            mp.erase(key);
+        }
+    }
+    CPerfProfiler::GetTime(end);
+    return CPerfProfiler::GetTimeDiffNano(begin, end) / (vecKeys.size() * uLoop * 2);
+}
+
+template <typename List>
+uint64_t ListChurn(List &lst, uint32_t uCount, uint32_t uLoop)
+{
+    timespec begin, end;
+    CPerfProfiler::GetTime(begin);
+    for (uint32_t n = 0; n < uLoop; n++)
+    {
+        for (uint32_t i = 0; i < uCount; i++)
+        {
+            lst.push_back(i);
+        }
+        // 隔一个删一个，再清空
+        for (auto it = lst.begin(); it != lst.end();)
+        {
+            it = lst.erase(it);
+            if (it != lst.end())
+            {
+                ++it;
+            }
+        }
+        lst.clear();
+    }
+    CPerfProfiler::GetTime(end);
+    return CPerfProfiler::GetTimeDiffNano(begin, end) / (uCount * uLoop * 2);
+}
+
+void CasePerf()
+{
+    PRINT_INFO("=================");
+    constexpr uint32_t count = 10000;
+    constexpr uint32_t loop = 50;
+    std::vector<int> vecKeys(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        vecKeys[i] = (int)i;
+    }
+    std::shuffle(vecKeys.begin(), vecKeys.end(), std::mt19937(3));
+
+    CSlabAllocator slab;
+    slab.Init();
+    CPoolAllocator<int> alloc(&slab);
+    CSlabMemoryResource resource(&slab);
+    using PairAlloc = CPoolAllocator<std::pair<const int, int>>;
+
+    {
+        std::list<int> lstStd;
+        std::list<int, CPoolAllocator<int>> lstPool(alloc);
+        std::pmr::list<int> lstPmr(&resource);
+        auto uStd = ListChurn(lstStd, count, loop);
+        auto uPool = ListChurn(lstPool, count, loop);
+        auto uPmr = ListChurn(lstPmr, count, loop);
+        printf("list          : std = %lu ns/op, pool = %lu ns/op, pmr = %lu ns/op\n", uStd, uPool, uPmr);
+    }
+    {
+        std::map<int, int> mpStd;
+        std::map<int, int, std::less<int>, PairAlloc> mpPool(alloc);
+        std::pmr::map<int, int> mpPmr(&resource);
+        auto uStd = MapChurn(mpStd, vecKeys, loop);
+        auto uPool = MapChurn(mpPool, vecKeys, loop);
+        auto uPmr = MapChurn(mpPmr, vecKeys, loop);
+        printf("map           : std = %lu ns/op, pool = %lu ns/op, pmr = %lu ns/op\n", uStd, uPool, uPmr);
+    }
+    {
+        std::unordered_map<int, int> umpStd;
+        std::unordered_map<int, int, std::hash<int>, std::equal_to<int>, PairAlloc> umpPool(16, std::hash<int>(),
+                                                                                          std::equal_to<int>(), alloc);
+        std::pmr::unordered_map<int, int> umpPmr(&resource);
+        auto uStd = MapChurn(umpStd, vecKeys, loop);
+        auto uPool = MapChurn(umpPool, vecKeys, loop);
+        auto uPmr = MapChurn(umpPmr, vecKeys, loop);
+        printf("unordered_map : std = %lu ns/op, pool = %lu ns/op, pmr = %lu ns/op\n", uStd, uPool, uPmr);
+    }
+    PRINT_INFO("=================");
+}
+
+int main(int argc, const char *argv[])
+{
+    CaseAllocator();
+    CasePmr();
+    CasePerf();
+    return 0;
+}
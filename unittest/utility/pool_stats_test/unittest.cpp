@@ -0,0 +1,112 @@
+#define OBJECT_POOL_STATS
+#include <utility/object_pool.h>
+#include <vector>
+
+using namespace utility;
+
+void CaseCounters()
+{
+    PRINT_INFO("=================");
+    CObjectPool pool;
+    ObjectPoolOption option;
+    option.uInitBlockCount = 1;
+    option.uFirstBlockBytes = option.uBlockBytes = (32 + 8) * BlockObjectSize; // 每块BlockObjectSize个对象
+    option.uIdleHighWatermark = 4;
+    option.uIdleLowWatermark = 1;
+    pool.Init(32, nullptr, option);
+
+    std::vector<void *> vecObjs;
+    for (uint32_t i = 0; i < BlockObjectSize * 8; i++)
+    {
+        vecObjs.push_back(pool.Get());
+    }
+    void *arrBatch[100];
+    auto uGot = pool.GetBatch(100, arrBatch);
+    for (uint32_t i = 0; i < vecObjs.size(); i++)
+    {
+        pool.Release(vecObjs[i]);
+    }
+    pool.ReleaseBatch(arrBatch, uGot);
+
+    PoolStatsSnapshot snapshot;
+    if (pool.GetStats(snapshot) != 0)
+    {
+        PRINT_FAIL("GetStats Fail");
+        exit(1);
+    }
+    uint64_t uScans = 0;
+    for (auto uCount : snapshot.arrScanHist_)
+    {
+        uScans += uCount;
+    }
+    if (snapshot.uGets_ != BlockObjectSize * 8 + 100 || snapshot.uReleases_ != snapshot.uGets_ ||
+        snapshot.uLiveObjects_ != 0 || snapshot.uPeakLiveObjects_ != snapshot.uGets_ || snapshot.uExpands_ != 9 ||
+        snapshot.uTrimmedBlocks_ == 0 || uScans == 0 || snapshot.uEventCount_ == 0 ||
+        snapshot.uBlocks_ != pool.GetBlockCount())
+    {
+        PRINT_ERROR("snapshot is not OK\n%s", snapshot.ToText().c_str());
+        exit(1);
+    }
+
+    // 事件按时间排序
+    for (uint32_t i = 1; i < snapshot.uEventCount_; i++)
+    {
+        if (snapshot.arrEvents_[i].uTimeNano_ < snapshot.arrEvents_[i - 1].uTimeNano_)
+        {
+            PRINT_ERROR("event %u out of order", i);
+            exit(1);
+        }
+    }
+    printf("%s", snapshot.ToText().c_str());
+    printf("%s\n", snapshot.ToJson().c_str());
+
+    pool.UnInit();
+    pool.GetStats(snapshot);
+    if (snapshot.uGets_ != 0 || snapshot.uEventCount_ != 0)
+    {
+        PRINT_ERROR("stats not reset after UnInit");
+        exit(1);
+    }
+    PRINT_INFO("=================");
+}
+
+// 事件环只保留最近PoolEventSize个
+void CaseEventRing()
+{
+    PRINT_INFO("=================");
+    CObjectPool pool;
+    ObjectPoolOption option;
+    option.uInitBlockCount = 0;
+    option.uFirstBlockBytes = option.uBlockBytes = (8 + 8) * BlockObjectSize;
+    pool.Init(8, nullptr, option);
+
+    std::vector<void *> vecObjs;
+    for (uint32_t i = 0; i < BlockObjectSize * (PoolEventSize + 10); i++)
+    {
+        vecObjs.push_back(pool.Get());
+    }
+
+    PoolStatsSnapshot snapshot;
+    pool.GetStats(snapshot);
+    if (snapshot.uExpands_ != PoolEventSize + 10 || snapshot.uEventCount_ != PoolEventSize ||
+        snapshot.arrEvents_[PoolEventSize - 1].uBlocks_ != PoolEventSize + 10 ||
+        snapshot.arrEvents_[0].uBlocks_ != 11)
+    {
+        PRINT_ERROR("event ring is not OK, expands = %lu, events = %u, first blocks = %u", snapshot.uExpands_,
+                    snapshot.uEventCount_, snapshot.arrEvents_[0].uBlocks_);
+        exit(1);
+    }
+    for (auto ptr : vecObjs)
+    {
+        pool.Release(ptr);
+    }
+    pool.UnInit();
+    PRINT_INFO("=================");
+}
+
+int main(int argc, const char *argv[])
+{
+    CaseCounters();
+    CaseEventRing();
+    return 0;
+}
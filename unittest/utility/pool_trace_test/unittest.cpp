@@ -0,0 +1,217 @@
+#define OBJECT_POOL_TRACE
+#include <utility/object_pool.h>
+#include <vector>
+#include <thread>
+#include <unordered_map>
+
+using namespace utility;
+
+static const char *s_lpPath = "/tmp/pool_trace_test.bin";
+
+class CObjectPoolTarget : public IPoolReplayTarget
+{
+public:
+    ~CObjectPoolTarget()
+    {
+        for (auto &iter : m_mapPools)
+        {
+            iter.second.UnInit();
+        }
+    }
+
+    const char *GetName() override { return "object"; }
+
+    int32_t Prepare(const std::vector<uint32_t> &vecSizes) override
+    {
+        for (auto uSize : vecSizes)
+        {
+            if (m_mapPools[uSize].Init(uSize) != 0)
+            {
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    void *Get(uint32_t uSize) override
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_uLive++;
+        return m_mapPools.find(uSize)->second.Get();
+    }
+
+    void Release(void *ptr, uint32_t uSize) override
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_uLive--;
+        m_mapPools.find(uSize)->second.Release(ptr);
+    }
+
+    int64_t GetLive() { return m_uLive; }
+
+private:
+    std::mutex m_lock;
+    int64_t m_uLive{0};
+    std::unordered_map<uint32_t, CObjectPool> m_mapPools;
+};
+
+class CMallocTarget : public IPoolReplayTarget
+{
+public:
+    const char *GetName() override { return "malloc"; }
+    int32_t Prepare(const std::vector<uint32_t> &vecSizes) override { return 0; }
+    void *Get(uint32_t uSize) override { return malloc(uSize); }
+    void Release(void *ptr, uint32_t uSize) override { free(ptr); }
+};
+
+// 记录两个大小的池，读回来后事件数量和配对都正确
+void CaseCapture()
+{
+    PRINT_INFO("=================");
+    CObjectPool smallPool, bigPool;
+    smallPool.Init(24);
+    bigPool.Init(200);
+
+    // 开始记录之前申请的对象，它的Release在回放时会被跳过
+    auto lpBefore = smallPool.Get();
+    if (CPoolTrace::Start(s_lpPath) != 0 || CPoolTrace::Start(s_lpPath) == 0)
+    {
+        PRINT_FAIL("Start fail");
+        exit(1);
+    }
+
+    std::vector<void *> vecObjs;
+    for (uint32_t i = 0; i < 10000; i++)
+    {
+        vecObjs.push_back(i % 4 == 0 ? bigPool.Get() : smallPool.Get());
+    }
+    void *arrBatch[64];
+    auto uGot = smallPool.GetBatch(64, arrBatch);
+    smallPool.ReleaseBatch(arrBatch, uGot);
+    smallPool.Release(lpBefore);
+    for (uint32_t i = 0; i < vecObjs.size(); i += 2)
+    {
+        (i % 4 == 0 ? bigPool : smallPool).Release(vecObjs[i]);
+    }
+    auto uRecords = CPoolTrace::Stop();
+
+    // 停止以后不再记录
+    smallPool.Release(smallPool.Get());
+
+    std::vector<PoolTraceRecord> vecRecords;
+    if (CPoolTrace::Load(s_lpPath, vecRecords) != 0 || vecRecords.size() != uRecords ||
+        uRecords != 10000 + 64 * 2 + 1 + 5000)
+    {
+        PRINT_ERROR("records = %lu, loaded = %lu", uRecords, vecRecords.size());
+        exit(1);
+    }
+    uint32_t uBig = 0;
+    for (uint32_t i = 0; i < vecRecords.size(); i++)
+    {
+        if (i > 0 && vecRecords[i].uTimeNano_ < vecRecords[i - 1].uTimeNano_)
+        {
+            PRINT_ERROR("records not sorted");
+            exit(1);
+        }
+        uBig += vecRecords[i].GetSize() == bigPool.GetObjectSize() ? 1 : 0;
+    }
+    if (uBig != 2500 + 2500)
+    {
+        PRINT_ERROR("big records = %u", uBig);
+        exit(1);
+    }
+
+    CPoolTraceReplayer replayer;
+    if (replayer.Init(vecRecords) != 0 || replayer.GetThreadCount() != 1 || replayer.GetSizes().size() != 2 ||
+        replayer.GetPeakLive() != 10064)
+    {
+        PRINT_ERROR("replayer init fail, peak live = %lu", replayer.GetPeakLive());
+        exit(1);
+    }
+    for (uint32_t i = 1; i < vecObjs.size(); i += 2)
+    {
+        smallPool.Release(vecObjs[i]);
+    }
+    smallPool.UnInit();
+    bigPool.UnInit();
+    remove(s_lpPath);
+    PRINT_INFO("=================");
+}
+
+// 多线程记录，生产者申请消费者释放；单线程和多线程两种方式回放
+void CaseReplay()
+{
+    PRINT_INFO("=================");
+    CObjectPool pool;
+    pool.Init(64);
+    std::mutex lock;
+    std::vector<void *> vecQueue;
+    constexpr uint32_t count = 20000;
+
+    CPoolTrace::Start(s_lpPath);
+    std::thread producer([&]() {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            vecQueue.push_back(pool.Get());
+        }
+    });
+    std::thread consumer([&]() {
+        uint32_t uReleased = 0;
+        while (uReleased < count)
+        {
+            std::vector<void *> vecObjs;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                vecObjs.swap(vecQueue);
+                for (auto ptr : vecObjs)
+                {
+                    pool.Release(ptr);
+                }
+            }
+            uReleased += vecObjs.size();
+        }
+    });
+    producer.join();
+    consumer.join();
+    CPoolTrace::Stop();
+    pool.UnInit();
+
+    std::vector<PoolTraceRecord> vecRecords;
+    CPoolTraceReplayer replayer;
+    if (CPoolTrace::Load(s_lpPath, vecRecords) != 0 || vecRecords.size() != count * 2 ||
+        replayer.Init(vecRecords) != 0 || replayer.GetThreadCount() != 2)
+    {
+        PRINT_ERROR("load fail, records = %lu", vecRecords.size());
+        exit(1);
+    }
+
+    for (auto bThreaded : {false, true})
+    {
+        CObjectPoolTarget objectTarget;
+        CMallocTarget mallocTarget;
+        PoolReplayResult objectResult, mallocResult;
+        if (replayer.Run(&objectTarget, bThreaded, objectResult) != 0 ||
+            replayer.Run(&mallocTarget, bThreaded, mallocResult) != 0 || objectResult.uOps_ != count * 2 ||
+            objectTarget.GetLive() != 0 || objectResult.uThreads_ != (bThreaded ? 2 : 1))
+        {
+            PRINT_ERROR("replay fail, ops = %lu, live = %ld", objectResult.uOps_, objectTarget.GetLive());
+            exit(1);
+        }
+        for (auto lpResult : {&objectResult, &mallocResult})
+        {
+            printf("%s threaded = %d, ops = %lu, %lu ns, p50 = %lu, p99 = %lu, p99.9 = %lu, max = %lu ns, timer = %lu ns\n",
+                   lpResult == &objectResult ? "object" : "malloc", bThreaded, lpResult->uOps_, lpResult->uTimeNano_,
+                   lpResult->uP50_, lpResult->uP99_, lpResult->uP999_, lpResult->uMax_, lpResult->uTimerNano_);
+        }
+    }
+    remove(s_lpPath);
+    PRINT_INFO("=================");
+}
+
+int main(int argc, const char *argv[])
+{
+    CaseCapture();
+    CaseReplay();
+    return 0;
+}
@@ -0,0 +1,136 @@
+#include <utility/slab_allocator.h>
+#include <utility/perf_profiler.h>
+#include <algorithm>
+#include <random>
+
+using namespace utility;
+
+void CaseSizeClass()
+{
+    PRINT_INFO("=================");
+    // 级别大小单调递增，且每个大小都落在能容纳它的最小级别
+    uint32_t uLastSize = 0;
+    for (uint32_t uClass = 0; CSlabAllocator::GetClassSize(uClass) <= DefaultMaxSizeClass; uClass++)
+    {
+        auto uClassSize = CSlabAllocator::GetClassSize(uClass);
+        if (uClassSize <= uLastSize || CSlabAllocator::GetSizeClass(uClassSize) != uClass)
+        {
+            PRINT_ERROR("class %u size %u is not OK", uClass, uClassSize);
+            exit(1);
+        }
+        uLastSize = uClassSize;
+    }
+    for (uint32_t uSize = 1; uSize <= DefaultMaxSizeClass; uSize++)
+    {
+        auto uClass = CSlabAllocator::GetSizeClass(uSize);
+        if (CSlabAllocator::GetClassSize(uClass) < uSize || (uClass > 0 && CSlabAllocator::GetClassSize(uClass - 1) >= uSize))
+        {
+            PRINT_ERROR("size %u -> class %u is not OK", uSize, uClass);
+            exit(1);
+        }
+    }
+    PRINT_INFO("=================");
+}
+
+void CaseAllocFree()
+{
+    PRINT_INFO("=================");
+    CSlabAllocator slab;
+    if (slab.Init() != 0)
+    {
+        PRINT_FAIL("slab Init Fail");
+        exit(1);
+    }
+
+    std::mt19937 rng(7);
+    std::vector<std::pair<uint8_t *, size_t>> vecBufs;
+    for (uint32_t i = 0; i < 20000; i++)
+    {
+        // 偶尔申请超过最大级别的大对象
+        size_t uSize = (i % 97 == 0) ? DefaultMaxSizeClass + rng() % 4096 : 1 + rng() % 2048;
+        auto ptr = (uint8_t *)slab.Allocate(uSize);
+        if (ptr == nullptr || ((uintptr_t)ptr & 7) != 0 || CSlabAllocator::GetUsableSize(ptr) < uSize)
+        {
+            PRINT_ERROR("Allocate %lu Fail, ptr = %p", uSize, ptr);
+            exit(1);
+        }
+        memset(ptr, (uint8_t)i, uSize);
+        vecBufs.emplace_back(ptr, uSize);
+    }
+
+    std::shuffle(vecBufs.begin(), vecBufs.end(), rng);
+    for (auto &buf : vecBufs)
+    {
+        auto uPattern = buf.first[0];
+        if (buf.first[buf.second - 1] != uPattern)
+        {
+            PRINT_ERROR("buf %p overwritten", buf.first);
+            exit(1);
+        }
+        slab.Free(buf.first);
+    }
+    slab.Free(nullptr);
+    slab.UnInit();
+    PRINT_INFO("=================");
+}
+
+// 随机大小、随机顺序释放，对比glibc malloc
+void CasePerf()
+{
+    PRINT_INFO("=================");
+    constexpr uint32_t count = 4096;
+    constexpr uint32_t loop = 200;
+    std::mt19937 rng(13);
+    std::vector<uint32_t> vecSizes(count), vecOrder(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        vecSizes[i] = 8 + rng() % 1024;
+        vecOrder[i] = i;
+    }
+    std::shuffle(vecOrder.begin(), vecOrder.end(), rng);
+    std::vector<void *> vecPtrs(count);
+    timespec begin, end;
+
+    CSlabAllocator slab;
+    slab.Init();
+    CPerfProfiler::GetTime(begin);
+    for (uint32_t n = 0; n < loop; n++)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            vecPtrs[i] = slab.Allocate(vecSizes[i]);
+        }
+        for (uint32_t i = 0; i < count; i++)
+        {
+            slab.Free(vecPtrs[vecOrder[i]]);
+        }
+    }
+    CPerfProfiler::GetTime(end);
+    auto uSlabCost = CPerfProfiler::GetTimeDiffNano(begin, end);
+
+    CPerfProfiler::GetTime(begin);
+    for (uint32_t n = 0; n < loop; n++)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            vecPtrs[i] = malloc(vecSizes[i]);
+        }
+        for (uint32_t i = 0; i < count; i++)
+        {
+            free(vecPtrs[vecOrder[i]]);
+        }
+    }
+    CPerfProfiler::GetTime(end);
+    auto uMallocCost = CPerfProfiler::GetTimeDiffNano(begin, end);
+
+    printf("slab = %lu ns/op, malloc = %lu ns/op\n", uSlabCost / (count * loop), uMallocCost / (count * loop));
+    PRINT_INFO("=================");
+}
+
+int main(int argc, const char *argv[])
+{
+    CaseSizeClass();
+    CaseAllocFree();
+    CasePerf();
+    return 0;
+}
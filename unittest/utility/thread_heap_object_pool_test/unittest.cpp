@@ -0,0 +1,270 @@
+#include <utility/thread_heap_object_pool.h>
+#include <utility/perf_profiler.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+using namespace utility;
+
+struct ObjDemo
+{
+    uint64_t uOwner;
+    uint64_t uSeq;
+    char f[48];
+
+    void Set(uint64_t owner, uint64_t seq)
+    {
+        uOwner = owner;
+        uSeq = seq;
+        memset(f, (char)owner, sizeof(f));
+    }
+
+    bool IsOk(uint64_t owner)
+    {
+        if (uOwner != owner)
+        {
+            return false;
+        }
+        for (uint32_t i = 0; i < sizeof(f); i++)
+        {
+            if (f[i] != (char)owner)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// 消息队列只用于测试线程之间传递对象
+struct HandoffQueue
+{
+    std::mutex lock;
+    std::vector<ObjDemo *> vecQueue;
+
+    void Push(ObjDemo *ptr)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        vecQueue.push_back(ptr);
+    }
+
+    void Take(std::vector<ObjDemo *> &vecObjs)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        vecObjs.swap(vecQueue);
+    }
+};
+
+void CaseLocal()
+{
+    PRINT_INFO("=================");
+    CThreadHeapObjectPool pool;
+    if (pool.Init(sizeof(ObjDemo)) != 0)
+    {
+        PRINT_FAIL("pool Init Fail");
+        exit(1);
+    }
+
+    std::vector<ObjDemo *> vecObjs;
+    for (uint32_t round = 0; round < 4; round++)
+    {
+        for (uint32_t i = 0; i < 10240; i++)
+        {
+            auto ptr = (ObjDemo *)pool.Get();
+            ptr->Set(round + 1, i);
+            vecObjs.push_back(ptr);
+        }
+        for (auto ptr : vecObjs)
+        {
+            if (!ptr->IsOk(round + 1))
+            {
+                PRINT_ERROR("ptr %p Is Not OK", ptr);
+                exit(1);
+            }
+            pool.Release(ptr);
+        }
+        vecObjs.clear();
+    }
+    pool.UnInit();
+    PRINT_INFO("=================");
+}
+
+// 生产者申请、消费者释放；生产者先退出，它们的堆在对象全部归还前成为孤儿，之后被新线程接管
+void CaseProducerConsumer()
+{
+    PRINT_INFO("=================");
+    CThreadHeapObjectPool pool;
+    pool.Init(sizeof(ObjDemo));
+
+    constexpr uint32_t count = 200000;
+    HandoffQueue queue;
+    std::atomic<bool> bProducing{true};
+    std::atomic<bool> bHold{true};
+    std::atomic<uint32_t> uErrors{0};
+    std::atomic<uint32_t> uReleased{0};
+
+    auto producer = [&](uint64_t uOwner) {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            auto ptr = (ObjDemo *)pool.Get();
+            if (ptr == nullptr)
+            {
+                uErrors++;
+                continue;
+            }
+            ptr->Set(uOwner, i);
+            queue.Push(ptr);
+        }
+    };
+
+    // 消费者留下一部分对象，等生产者退出后再释放
+    auto consumer = [&]() {
+        std::vector<ObjDemo *> vecObjs, vecHeld;
+        while (true)
+        {
+            auto bStop = !bProducing;
+            queue.Take(vecObjs);
+            if (bStop && vecObjs.empty())
+            {
+                break;
+            }
+            for (auto ptr : vecObjs)
+            {
+                if (!ptr->IsOk(ptr->uOwner))
+                {
+                    uErrors++;
+                }
+                if (ptr->uSeq % 1000 == 0)
+                {
+                    vecHeld.push_back(ptr);
+                    continue;
+                }
+                pool.Release(ptr);
+                uReleased++;
+            }
+            vecObjs.clear();
+            std::this_thread::yield();
+        }
+        while (bHold)
+        {
+            std::this_thread::yield();
+        }
+        for (auto ptr : vecHeld)
+        {
+            pool.Release(ptr);
+            uReleased++;
+        }
+    };
+
+    std::thread thProducer[2];
+    std::thread thConsumer[2];
+    for (auto &th : thConsumer)
+    {
+        th = std::thread(consumer);
+    }
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        thProducer[i] = std::thread(producer, 'a' + i);
+    }
+    for (auto &th : thProducer)
+    {
+        th.join();
+    }
+    bProducing = false;
+
+    auto uOrphans = pool.GetOrphanHeapCount();
+    bHold = false;
+    for (auto &th : thConsumer)
+    {
+        th.join();
+    }
+
+    // 新线程接管孤儿堆，并取回消费者远程释放的对象
+    std::thread([&]() {
+        auto ptr = pool.Get();
+        pool.Release(ptr);
+    }).join();
+
+    if (uErrors != 0 || uReleased != count * 2 || uOrphans != 2 || pool.GetOrphanHeapCount() != 1)
+    {
+        PRINT_ERROR("errors = %u, released = %u, orphans = %u -> %u", uErrors.load(), uReleased.load(), uOrphans,
+                    pool.GetOrphanHeapCount());
+        exit(1);
+    }
+    pool.UnInit();
+    PRINT_INFO("=================");
+}
+
+// 一个生产者一个消费者传递对象：全局锁包裹的CObjectPool对比线程堆
+template <typename GetFunc, typename ReleaseFunc>
+uint64_t Handoff(uint32_t uCount, GetFunc funcGet, ReleaseFunc funcRelease)
+{
+    HandoffQueue queue;
+    std::atomic<bool> bProducing{true};
+    timespec begin, end;
+    CPerfProfiler::GetTime(begin);
+    std::thread thConsumer([&]() {
+        std::vector<ObjDemo *> vecObjs;
+        while (true)
+        {
+            auto bStop = !bProducing;
+            queue.Take(vecObjs);
+            if (bStop && vecObjs.empty())
+            {
+                break;
+            }
+            for (auto ptr : vecObjs)
+            {
+                funcRelease(ptr);
+            }
+            vecObjs.clear();
+        }
+    });
+    for (uint32_t i = 0; i < uCount; i++)
+    {
+        queue.Push((ObjDemo *)funcGet());
+    }
+    bProducing = false;
+    thConsumer.join();
+    CPerfProfiler::GetTime(end);
+    return CPerfProfiler::GetTimeDiffNano(begin, end) / uCount;
+}
+
+void CasePerf()
+{
+    PRINT_INFO("=================");
+    constexpr uint32_t count = 1000000;
+
+    std::mutex lock;
+    CObjectPool lockedPool;
+    lockedPool.Init(sizeof(ObjDemo));
+    auto uLocked = Handoff(
+        count,
+        [&]() {
+            std::lock_guard<std::mutex> guard(lock);
+            return lockedPool.Get();
+        },
+        [&](void *ptr) {
+            std::lock_guard<std::mutex> guard(lock);
+            lockedPool.Release(ptr);
+        });
+    lockedPool.UnInit();
+
+    CThreadHeapObjectPool pool;
+    pool.Init(sizeof(ObjDemo));
+    auto uHeap = Handoff(
+        count, [&]() { return pool.Get(); }, [&](void *ptr) { pool.Release(ptr); });
+    pool.UnInit();
+
+    printf("handoff: mutex pool = %lu ns/op, thread heap pool = %lu ns/op\n", uLocked, uHeap);
+    PRINT_INFO("=================");
+}
+
+int main(int argc, const char *argv[])
+{
+    CaseLocal();
+    CaseProducerConsumer();
+    CasePerf();
+    return 0;
+}
@@ -0,0 +1,267 @@
+#include <utility/typed_object_pool.h>
+#include <utility/perf_profiler.h>
+#include <stdexcept>
+#include <string>
+
+using namespace utility;
+
+static int32_t s_iAlive = 0;
+
+struct ObjDemo
+{
+    ObjDemo(uint64_t uId, const std::string &strName) : uId_(uId), strName_(strName) { s_iAlive++; }
+    ~ObjDemo() { s_iAlive--; }
+
+    uint64_t uId_;
+    std::string strName_;
+};
+
+struct ObjRecycle
+{
+    ObjRecycle() { s_iAlive++; }
+    ~ObjRecycle() { s_iAlive--; }
+
+    uint32_t uUsed_{0};
+    char f[60];
+};
+
+static int32_t s_iThrowAfter = -1; // 再构造多少个对象后抛异常，-1表示不抛
+
+struct ObjThrow
+{
+    ObjThrow()
+    {
+        if (s_iThrowAfter >= 0 && s_iThrowAfter-- == 0)
+        {
+            throw std::runtime_error("ObjThrow");
+        }
+        s_iAlive++;
+    }
+    ~ObjThrow() { s_iAlive--; }
+
+    uint64_t uValue_{0};
+};
+
+struct alignas(64) ObjAligned
+{
+    uint64_t a[3];
+};
+
+void CaseLifetime()
+{
+    PRINT_INFO("=================");
+    {
+        CTypedObjectPool<ObjDemo, 128> pool;
+        if (pool.Init() != 0)
+        {
+            PRINT_FAIL("pool Init Fail");
+            exit(1);
+        }
+
+        std::vector<ObjDemo *> vecObjs;
+        for (uint32_t i = 0; i < 1000; i++)
+        {
+            vecObjs.push_back(pool.Get(i, std::to_string(i)));
+        }
+        if (s_iAlive != 1000 || pool.GetBlockCount() != 8)
+        {
+            PRINT_ERROR("alive = %d, blocks = %u", s_iAlive, pool.GetBlockCount());
+            exit(1);
+        }
+        for (uint32_t i = 0; i < 1000; i++)
+        {
+            if (vecObjs[i]->uId_ != i || vecObjs[i]->strName_ != std::to_string(i))
+            {
+                PRINT_ERROR("vecObjs[%u] Is Not OK", i);
+                exit(1);
+            }
+        }
+        for (uint32_t i = 0; i < 1000; i += 2)
+        {
+            pool.Release(vecObjs[i]);
+        }
+        if (s_iAlive != 500)
+        {
+            PRINT_ERROR("alive = %d", s_iAlive);
+            exit(1);
+        }
+        // 剩余对象由UnInit析构
+    }
+    if (s_iAlive != 0)
+    {
+        PRINT_ERROR("alive = %d after UnInit", s_iAlive);
+        exit(1);
+    }
+    PRINT_INFO("=================");
+}
+
+void CaseRecycle()
+{
+    PRINT_INFO("=================");
+    {
+        CTypedObjectPool<ObjRecycle, 64, true> pool;
+        pool.Init();
+        if (s_iAlive != 64)
+        {
+            PRINT_ERROR("alive = %d", s_iAlive);
+            exit(1);
+        }
+
+        // 归还后再次取出的是同一个未重新构造的对象
+        auto ptr = pool.Get();
+        ptr->uUsed_ = 42;
+        pool.Release(ptr);
+        auto ptrAgain = pool.Get();
+        if (ptrAgain != ptr || ptrAgain->uUsed_ != 42 || s_iAlive != 64)
+        {
+            PRINT_ERROR("recycle fail, used = %u, alive = %d", ptrAgain->uUsed_, s_iAlive);
+            exit(1);
+        }
+        pool.Release(ptrAgain);
+    }
+    if (s_iAlive != 0)
+    {
+        PRINT_ERROR("alive = %d after UnInit", s_iAlive);
+        exit(1);
+    }
+
+    CTypedObjectPool<ObjAligned, 64> alignedPool;
+    alignedPool.Init();
+    for (uint32_t i = 0; i < 200; i++)
+    {
+        auto ptr = alignedPool.Get();
+        if (((uintptr_t)ptr & 63) != 0)
+        {
+            PRINT_ERROR("ptr %p not aligned", ptr);
+            exit(1);
+        }
+    }
+    PRINT_INFO("=================");
+}
+
+// 构造函数抛异常时槽位要归还，已构造的对象要析构，且之后UnInit不会析构没构造过的对象
+void CaseThrow()
+{
+    PRINT_INFO("=================");
+    {
+        // 块里最后一个槽位构造失败，归还后再取不需要扩容
+        CTypedObjectPool<ObjThrow, 64> pool;
+        pool.Init();
+        std::vector<ObjThrow *> vecObjs;
+        for (uint32_t i = 0; i < 63; i++)
+        {
+            vecObjs.push_back(pool.Get());
+        }
+        s_iThrowAfter = 0;
+        bool bThrown = false;
+        try
+        {
+            pool.Get();
+        }
+        catch (const std::runtime_error &)
+        {
+            bThrown = true;
+        }
+        vecObjs.push_back(pool.Get());
+        if (!bThrown || s_iAlive != 64 || pool.GetBlockCount() != 1)
+        {
+            PRINT_ERROR("get throw fail, alive = %d, blocks = %u", s_iAlive, pool.GetBlockCount());
+            exit(1);
+        }
+        pool.Release(vecObjs[0]);
+    }
+    if (s_iAlive != 0)
+    {
+        PRINT_ERROR("alive = %d after UnInit", s_iAlive);
+        exit(1);
+    }
+
+    {
+        CTypedObjectPool<ObjThrow, 64, true> pool;
+        s_iThrowAfter = 10;
+        bool bThrown = false;
+        try
+        {
+            pool.Init();
+        }
+        catch (const std::runtime_error &)
+        {
+            bThrown = true;
+        }
+        if (!bThrown || s_iAlive != 0 || pool.GetBlockCount() != 0)
+        {
+            PRINT_ERROR("construct block throw fail, alive = %d, blocks = %u", s_iAlive, pool.GetBlockCount());
+            exit(1);
+        }
+        if (pool.Init() != 0 || s_iAlive != 64)
+        {
+            PRINT_ERROR("Init after throw fail, alive = %d", s_iAlive);
+            exit(1);
+        }
+    }
+    if (s_iAlive != 0)
+    {
+        PRINT_ERROR("alive = %d after UnInit", s_iAlive);
+        exit(1);
+    }
+    PRINT_INFO("=================");
+}
+
+// 对比类型擦除池(std::function构造 + 手工析构)与类型化池的单次开销
+void CasePerf()
+{
+    PRINT_INFO("=================");
+    constexpr uint32_t count = 32;
+    constexpr uint32_t loop = 100000;
+    ObjRecycle *ptrArr[count];
+    timespec begin, end;
+
+    CObjectPool pool;
+    pool.Init(sizeof(ObjRecycle), [](void *ptr) { new (ptr) ObjRecycle(); });
+    CPerfProfiler::GetTime(begin);
+    for (uint32_t n = 0; n < loop; n++)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            ptrArr[i] = new (pool.Get()) ObjRecycle();
+        }
+        for (uint32_t i = 0; i < count; i++)
+        {
+            ptrArr[i]->~ObjRecycle();
+            pool.Release(ptrArr[i]);
+        }
+    }
+    CPerfProfiler::GetTime(end);
+    auto uErasedCost = CPerfProfiler::GetTimeDiffNano(begin, end);
+    pool.UnInit();
+
+    CTypedObjectPool<ObjRecycle> typedPool;
+    typedPool.Init();
+    CPerfProfiler::GetTime(begin);
+    for (uint32_t n = 0; n < loop; n++)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            ptrArr[i] = typedPool.Get();
+        }
+        for (uint32_t i = 0; i < count; i++)
+        {
+            typedPool.Release(ptrArr[i]);
+        }
+    }
+    CPerfProfiler::GetTime(end);
+    auto uTypedCost = CPerfProfiler::GetTimeDiffNano(begin, end);
+
+    printf("type-erased pool = %lu ns/op, typed pool = %lu ns/op\n", uErasedCost / (count * loop),
+           uTypedCost / (count * loop));
+    PRINT_INFO("=================");
+}
+
+int main(int argc, const char *argv[])
+{
+    CaseLifetime();
+    CaseRecycle();
+    CaseThrow();
+    CasePerf();
+    return 0;
+}